@@ -4,6 +4,21 @@
 #include "cl_safe_math_macros.h"
 #include "safe_math_macros.h"
 
+/* Adds a hash to a digest of four words: the XOR of the hashes, low word then
+ * high word, and their sum, with the carry of the low word added to the high
+ * one. Only 32 bit atomics are always available. Defined before NO_ATOMICS
+ * can replace them. */
+inline __attribute__((always_inline)) void
+add_to_digest_ (__global volatile uint *digest, uint64_t hash)
+{
+  uint lo = (uint)hash;
+  uint hi = (uint)(hash >> 32);
+  atomic_xor(&digest[0], lo);
+  atomic_xor(&digest[1], hi);
+  uint old = atomic_add(&digest[2], lo);
+  atomic_add(&digest[3], hi + (old + lo < old ? 1 : 0));
+}
+
 #ifdef NO_ATOMICS
 #define atomic_inc(x) -1
 #define atomic_add(x,y) (1+1)
@@ -45,4 +60,13 @@ get_linear_local_id (void)
     get_local_size(0) + get_local_id(0);
 }
 
+/* The digest buffer has the digest of the whole range first, then one per
+ * work-group. */
+inline __attribute__((always_inline)) void
+add_to_digest (__global volatile uint *digest, uint64_t hash)
+{
+  add_to_digest_(digest, hash);
+  add_to_digest_(digest + 4 * (1 + get_linear_group_id()), hash);
+}
+
 #endif /* RANDOM_RUNTIME_H */
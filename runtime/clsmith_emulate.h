@@ -0,0 +1,117 @@
+/* Host definitions of the OpenCL C used by CLSmith programs, so that
+ * clsmith_emulate can build a program as GNU C for the host and run it.
+ * Included before the program, in place of the OpenCL compiler's own.
+ *
+ * The work-item functions, barrier() and the fences are provided by
+ * clsmith_emulate. The other built-ins are only defined for the scalar types;
+ * vector programs are not supported.
+ */
+
+#ifndef CLSMITH_EMULATE_H
+#define CLSMITH_EMULATE_H
+
+#include <limits.h>
+#include <stddef.h>
+
+typedef unsigned char uchar;
+typedef unsigned short ushort;
+typedef unsigned int uint;
+typedef unsigned long ulong;
+
+#define __kernel
+#define __global
+#define __private
+#define __constant const
+/* Only a qualifier of pointers here. clsmith_emulate turns the declarations of
+ * local variables in the kernel into CLSMITH_LOCAL ones: each work-group runs
+ * on a single thread, so a thread local variable is shared by the work-group,
+ * as local memory is. */
+#define __local
+#define CLSMITH_LOCAL static __thread
+
+#define CLK_LOCAL_MEM_FENCE 1
+#define CLK_GLOBAL_MEM_FENCE 2
+
+uint get_work_dim(void);
+size_t get_global_size(uint dim);
+size_t get_global_id(uint dim);
+size_t get_local_size(uint dim);
+size_t get_local_id(uint dim);
+size_t get_num_groups(uint dim);
+size_t get_group_id(uint dim);
+void barrier(uint flags);
+
+/* Lets the other work-items of the work-group run. Message passing programs
+ * spin on local memory written by other work-items, with a fence in the loop,
+ * so a fence must give way to them. */
+void clsmith_yield(void);
+#define mem_fence(flags) clsmith_yield()
+#define read_mem_fence(flags) clsmith_yield()
+#define write_mem_fence(flags) clsmith_yield()
+
+/* Work-groups run in parallel, so the atomics on global memory must be real
+ * ones. They return the old value, as in OpenCL. */
+#define atomic_add(p, v) __atomic_fetch_add((p), (v), __ATOMIC_SEQ_CST)
+#define atomic_sub(p, v) __atomic_fetch_sub((p), (v), __ATOMIC_SEQ_CST)
+#define atomic_inc(p) __atomic_fetch_add((p), 1, __ATOMIC_SEQ_CST)
+#define atomic_dec(p) __atomic_fetch_sub((p), 1, __ATOMIC_SEQ_CST)
+#define atomic_and(p, v) __atomic_fetch_and((p), (v), __ATOMIC_SEQ_CST)
+#define atomic_or(p, v) __atomic_fetch_or((p), (v), __ATOMIC_SEQ_CST)
+#define atomic_xor(p, v) __atomic_fetch_xor((p), (v), __ATOMIC_SEQ_CST)
+#define atomic_xchg(p, v) __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#define atomic_cmpxchg(p, cmp, v) \
+  ({ __typeof__(*(p) + 0) _old = (cmp); \
+     __atomic_compare_exchange_n((p), &_old, (v), 0, __ATOMIC_SEQ_CST, \
+                                 __ATOMIC_SEQ_CST); \
+     _old; })
+#define CLSMITH_ATOMIC_MINMAX(p, v, better) \
+  ({ __typeof__(*(p) + 0) _old = __atomic_load_n((p), __ATOMIC_SEQ_CST); \
+     __typeof__(*(p) + 0) _val = (v); \
+     while ((_val better _old) && \
+            !__atomic_compare_exchange_n((p), &_old, _val, 0, \
+                                         __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) \
+       ; \
+     _old; })
+#define atomic_min(p, v) CLSMITH_ATOMIC_MINMAX(p, v, <)
+#define atomic_max(p, v) CLSMITH_ATOMIC_MINMAX(p, v, >)
+
+/* Integer built-ins used by the safe math macros. */
+#define CLSMITH_MUL_HI(name, type, wide, bits) \
+  static inline type name(type a, type b) { \
+    return (type)(((wide)a * (wide)b) >> (bits)); \
+  }
+CLSMITH_MUL_HI(clsmith_mul_hi_char, signed char, int, 8)
+CLSMITH_MUL_HI(clsmith_mul_hi_uchar, uchar, uint, 8)
+CLSMITH_MUL_HI(clsmith_mul_hi_short, short, int, 16)
+CLSMITH_MUL_HI(clsmith_mul_hi_ushort, ushort, uint, 16)
+CLSMITH_MUL_HI(clsmith_mul_hi_int, int, long, 32)
+CLSMITH_MUL_HI(clsmith_mul_hi_uint, uint, ulong, 32)
+CLSMITH_MUL_HI(clsmith_mul_hi_long, long, __int128, 64)
+CLSMITH_MUL_HI(clsmith_mul_hi_ulong, ulong, unsigned __int128, 64)
+#undef CLSMITH_MUL_HI
+
+#define mul_hi(a, b) \
+  _Generic((a), \
+           char: clsmith_mul_hi_char, \
+           signed char: clsmith_mul_hi_char, \
+           uchar: clsmith_mul_hi_uchar, \
+           short: clsmith_mul_hi_short, \
+           ushort: clsmith_mul_hi_ushort, \
+           int: clsmith_mul_hi_int, \
+           uint: clsmith_mul_hi_uint, \
+           long: clsmith_mul_hi_long, \
+           ulong: clsmith_mul_hi_ulong)((a), (b))
+#define mad_hi(a, b, c) ((__typeof__(a))(mul_hi((a), (b)) + (c)))
+
+/* The result wraps, rather than overflowing, as on the devices. */
+#define mul24(a, b) \
+  ((__typeof__((a) + (b)))((ulong)(long)(a) * (ulong)(long)(b)))
+#define mad24(a, b, c) \
+  ((__typeof__((a) + (b)))((ulong)(long)mul24((a), (b)) + (ulong)(long)(c)))
+
+#define clamp(x, lo, hi) \
+  ({ __typeof__(x) _x = (x); __typeof__(x) _lo = (lo); \
+     __typeof__(x) _hi = (hi); \
+     _x < _lo ? _lo : (_x > _hi ? _hi : _x); })
+
+#endif /* CLSMITH_EMULATE_H */
@@ -0,0 +1,49 @@
+#!/bin/bash
+#
+# Checks that a multi-threaded batch (--count N --jobs K) writes the same
+# programs, byte for byte, as separate single-seed runs.
+#
+# Usage: check_jobs_identical.sh <CLSmith binary> [count] [jobs] [seed-start]
+#                                [extra CLSmith options...]
+#
+# Exits with 0 if every program matches, 1 otherwise.
+
+if [ $# -lt 1 ]; then
+  echo "Usage: $0 <CLSmith binary> [count] [jobs] [seed-start] [options...]"
+  exit 2
+fi
+
+CLSMITH=$(readlink -f "$1")
+COUNT=${2:-20}
+JOBS=${3:-4}
+SEED_START=${4:-1}
+shift $(( $# < 4 ? $# : 4 ))
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+mkdir "$WORK/batch" "$WORK/single"
+
+(cd "$WORK/batch" && "$CLSMITH" "$@" --count "$COUNT" --jobs "$JOBS" \
+    --seed-start "$SEED_START" -o CLProg.c > /dev/null) || {
+  echo "batch run failed"
+  exit 1
+}
+
+FAILED=0
+for (( SEED = SEED_START; SEED < SEED_START + COUNT; ++SEED )); do
+  (cd "$WORK/single" && "$CLSMITH" "$@" --seed "$SEED" \
+      -o "CLProg_$SEED.c" > /dev/null) || {
+    echo "seed $SEED: single run failed"
+    FAILED=1
+    continue
+  }
+  if ! cmp -s "$WORK/batch/CLProg_$SEED.c" "$WORK/single/CLProg_$SEED.c"; then
+    echo "seed $SEED: batch output differs from single run"
+    FAILED=1
+  fi
+done
+
+if [ $FAILED -eq 0 ]; then
+  echo "all $COUNT programs identical with --jobs $JOBS"
+fi
+exit $FAILED
@@ -0,0 +1,150 @@
+#!/usr/bin/python3
+
+""" Loads the features CLSmith writes next to each kernel with --features,
+e.g. CLProg_42.features.json for CLProg_42.cl, to pick and compare kernels
+without reading their sources.
+
+A kernel's features are flattened into names such as statements.barrier,
+built_ins.clamp, vector_widths.4, memory_buffers.local, max_block_depth,
+threads and group_size; a feature a kernel does not have is 0. Conditions are
+a name, which holds if the feature is not 0, or a name, an operator and a
+number, e.g. max_block_depth>=4.
+
+Usage:
+  cl_features.py DIR list [COND...]     List the kernels with all of the
+                                        conditions, e.g. to be ranked with
+                                        `... | triage rankfile`
+  cl_features.py DIR correlate DB       Compare how often the kernels with
+                                        and without each feature disagree in
+                                        a result store (see cl_results_db.py)
+"""
+
+import argparse
+import glob
+import json
+import operator
+import os
+import sys
+
+SUFFIX = ".features.json"
+
+OPERATORS = [(">=", operator.ge), ("<=", operator.le), ("==", operator.eq),
+             ("!=", operator.ne), (">", operator.gt), ("<", operator.lt)]
+
+# The statements that are only generated by the OpenCL options.
+CL_STATEMENTS = ["atomic_section", "atomic_reduction", "barrier", "comm", "emi",
+                 "fake_divergence", "message"]
+
+def load(path):
+  """ Returns the features of a kernel, as flattened names. """
+  with open(path) as f:
+    record = json.load(f)
+  features = {}
+  for key, value in record.items():
+    if isinstance(value, dict):
+      for name, count in value.items():
+        features["%s.%s" % (key, name)] = count
+    elif not isinstance(value, list):
+      features[key] = value
+  threads = 1
+  for size in record.get("global_size", []):
+    threads *= size
+  group_size = 1
+  for size in record.get("local_size", []):
+    group_size *= size
+  features["threads"] = threads
+  features["group_size"] = group_size
+  return features
+
+def load_dir(directory):
+  """ Returns {kernel: features} for the sidecars in a directory, where the
+  kernel is named as in the results files, e.g. CLProg_42. """
+  kernels = {}
+  for path in glob.glob(os.path.join(directory, "*" + SUFFIX)):
+    kernels[os.path.basename(path)[:-len(SUFFIX)]] = load(path)
+  return kernels
+
+def kernel_path(directory, kernel):
+  """ The source of a kernel, next to its features, or its name if it is not
+  there. """
+  for path in sorted(glob.glob(os.path.join(directory, kernel + ".*"))):
+    if not path.endswith(SUFFIX):
+      return path
+  return kernel
+
+def parse_condition(text):
+  """ Returns (name, compare, value) for a condition. """
+  for symbol, compare in OPERATORS:
+    if symbol in text:
+      name, value = text.split(symbol, 1)
+      return name.strip(), compare, float(value)
+  return text.strip(), operator.gt, 0
+
+def matches(features, conditions):
+  return all(compare(features.get(name, 0), value)
+             for name, compare, value in conditions)
+
+def summary(features):
+  """ A short description of what is notable about a kernel, e.g.
+  "atomic_section 3, barrier 2; vectors 4, 16". """
+  parts = ["%s %d" % (name, features["statements." + name])
+           for name in CL_STATEMENTS if features.get("statements." + name)]
+  text = ", ".join(parts)
+  widths = sorted(int(name.split(".", 1)[1]) for name in features
+                  if name.startswith("vector_widths."))
+  if widths:
+    text += "%svectors %s" % ("; " if text else "", ", ".join(str(w) for w in widths))
+  return text
+
+def correlate(kernels, store):
+  """ Returns (feature, with, failing with, rate with, rate without) for each
+  feature, for the kernels that have results, by how much more often the
+  kernels with the feature disagree. """
+  tested = set(kernel for kernel, _, _ in store.kernels()) & set(kernels)
+  failing = set(kernel for kernel, _, _ in store.discrepancies(mark=False)) & tested
+  names = set()
+  for kernel in tested:
+    names.update(name for name, value in kernels[kernel].items()
+                 if "." in name and value)
+  rows = []
+  for name in names:
+    having = set(kernel for kernel in tested if kernels[kernel].get(name, 0))
+    rate_with = len(having & failing) / float(len(having))
+    others = len(tested) - len(having)
+    rate_without = len(failing - having) / float(others) if others else 0.0
+    rows.append((name, len(having), len(having & failing), rate_with, rate_without))
+  rows.sort(key=lambda row: (row[4] - row[3], row[0]))
+  return rows
+
+def main():
+  parser = argparse.ArgumentParser(description="Filter and compare kernels by their features.")
+  parser.add_argument('directory', help="Directory of the kernels and their features")
+  sub = parser.add_subparsers(dest='command')
+  p = sub.add_parser('list', help="List the kernels with all of the conditions")
+  p.add_argument('conditions', nargs='*')
+  p = sub.add_parser('correlate', help="Compare the failures of the kernels with and without each feature")
+  p.add_argument('db', help="Result store")
+  args = parser.parse_args()
+
+  kernels = load_dir(args.directory)
+  if args.command == 'list':
+    conditions = [parse_condition(c) for c in args.conditions]
+    for kernel in sorted(kernels):
+      if matches(kernels[kernel], conditions):
+        print(kernel_path(args.directory, kernel))
+  elif args.command == 'correlate':
+    if not os.path.exists(args.db):
+      print("Could not find result store %s!" % args.db)
+      return 1
+    from cl_results_db import ResultStore
+    store = ResultStore(args.db)
+    print("feature\tkernels\tfailing\trate\trate_without")
+    for name, count, failed, rate_with, rate_without in correlate(kernels, store):
+      print("%s\t%d\t%d\t%.3f\t%.3f" % (name, count, failed, rate_with, rate_without))
+    store.close()
+  else:
+    parser.print_help()
+  return 0
+
+if __name__ == "__main__":
+  sys.exit(main())
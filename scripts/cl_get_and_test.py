@@ -1,13 +1,38 @@
-#!/usr/bin/python
+#!/usr/bin/python3
 
+""" Runs cl_launcher on every test in a directory and records the results.
+
+Several launchers can run at once (-jobs N), taking tests from a shared queue.
+They share the OpenCL device, which suits CPU drivers; on a GPU, concurrent
+launchers can distort the timeouts and the results, so one runs by default. The
+results are still written in the order of the sorted test names, as each test
+is done, so the output matches a serial run. Every few tests (-checkpoint)
+the output is synced to disk and its size recorded in <output>.ckpt, with the
+index of the next test; -resume truncates the output to that size and carries
+on from there, without reading the results back.
+
+The wall and CPU time of each test go to <output>.times, one CSV line per
+test.
+"""
+
+import argparse
 import atexit
-import sys
 import os
-import argparse
-from processTimeout import WorkerThread
+import shlex
+import shutil
+import signal
+import struct
+import subprocess
+import sys
 import tempfile
+import threading
+import time
 import zipfile
-import shutil
+
+try:
+  import queue
+except ImportError:
+  import Queue as queue
 
 # nb: extractall is unsafe if you pass in archives from untrusted sources
 def unzip(path, fname):
@@ -23,6 +48,9 @@ if sys.platform == "win32":
   clLauncherExecutable += ".exe"
   pathSeparator += os.sep
 
+# Seconds between asking a timed out launcher to stop and killing it.
+killGracePeriod = 5
+
 parser = argparse.ArgumentParser("Run generator on a range of given programs.")
 
 parser.add_argument('-cl_launcher', default = "." + pathSeparator + clLauncherExecutable)
@@ -34,21 +62,21 @@ parser.add_argument('-path', default = "CLSmithTests/")
 parser.add_argument('-zipfile', type=argparse.FileType('r'), default=None, help="Zipfile containing tests to run")
 parser.add_argument('-output', default = "Result.csv")
 parser.add_argument('-timeout', default = 150, type = int)
+parser.add_argument('-jobs', default = 1, type = int, help="Number of launchers to run at once, all on the same device (default 1)")
+parser.add_argument('-checkpoint', default = 16, type = int, help="Sync the output to disk every N tests")
 
-parser.add_argument('-resume', type=argparse.FileType('r'), default=None, help="Do not run tests that appear in an existing results file")
+parser.add_argument('-resume', nargs='?', const="", default=None, help="Carry on from the checkpoint of the output file, or, given another results file, do not run tests that appear in it")
 
 parser.add_argument('flags', nargs='*')
 
 args = parser.parse_args()
 
-if os.path.isfile(args.output):
-    print("Overwriting file %s." % args.output)
+checkpoint_file = args.output + ".ckpt"
+times_file = args.output + ".times"
 
 if os.path.dirname(args.output) and not os.path.isdir(os.path.dirname(args.output)):
-    print("Creating directory %s." % os.path.dirname(args.output))
-    os.makedirs(os.path.dirname(args.output))
-
-output = open(args.output, 'w')
+  print("Creating directory %s." % os.path.dirname(args.output))
+  os.makedirs(os.path.dirname(args.output))
 
 if args.zipfile:
   print("Creating temporary directory [%s]" % args.path)
@@ -67,73 +95,295 @@ if not os.path.exists(args.path):
   print("Given path %s does not exist!" % (args.path))
   exit(1)
 
-already_processed = []
-if args.resume:
-  for l in args.resume:
+full_file_list = set(os.listdir(args.path))
+file_list = sorted([f for f in full_file_list if f.endswith(".cl")])
+
+# Tests found in an older results file, given with -resume FILE.
+already_processed = set()
+if args.resume and os.path.abspath(args.resume) != os.path.abspath(args.output):
+  last = None
+  for l in open(args.resume):
     if "RESULTS FOR" in l:
-      already_processed.append(l.split()[-2])
-  already_processed.remove(l.split()[-2])
+      last = l.split()[2]
+      already_processed.add(last)
+  # The last test may not have finished.
+  already_processed.discard(last)
 
-full_file_list = os.listdir(args.path)
-file_list = sorted([f for f in os.listdir(args.path) if f.endswith(".cl")])
-file_index = 0
-for curr_file in file_list:
-  file_index += 1
+# Index of the first test to run, and the sizes of the output files when the
+# test before it was written.
+start_index = 0
+output_offset = 0
+times_offset = 0
+resuming = args.resume is not None and (args.resume == "" or
+    os.path.abspath(args.resume) == os.path.abspath(args.output))
+if resuming:
+  if os.path.isfile(checkpoint_file):
+    with open(checkpoint_file) as f:
+      fields = f.readline().split(None, 3)
+    start_index, output_offset, times_offset = [int(x) for x in fields[:3]]
+    next_test = fields[3].strip() if len(fields) > 3 else ""
+    if start_index < len(file_list) and file_list[start_index] != next_test:
+      print("Tests in %s do not match checkpoint %s (expected %s next)." % (args.path, checkpoint_file, next_test))
+      exit(1)
+    print("Resuming %s at kernel %d/%d." % (args.output, start_index + 1, len(file_list)))
+  else:
+    print("No checkpoint %s, starting from the first kernel." % checkpoint_file)
+    resuming = False
+elif os.path.isfile(args.output):
+  print("Overwriting file %s." % args.output)
 
-  if curr_file in already_processed:
-      print("Skipping kernel %s (%d/%d)..." % (curr_file, file_index, len(file_list)))
-      continue
+def open_output(path, offset):
+  if not resuming:
+    return open(path, 'w')
+  f = open(path, 'a')
+  f.truncate(offset)
+  f.seek(0, os.SEEK_END)
+  return f
 
-  check_args = os.path.splitext(curr_file)[0] + ".args"
-  if not check_args in full_file_list:
-    check_args = ""
-  else:
-    check_args = args.path + pathSeparator + check_args
+output = open_output(args.output, output_offset)
+times = open_output(times_file, times_offset)
 
-  lines = ""
-  if sys.platform != "win32":
-    lines = " (" + os.popen("wc -l " + args.path + pathSeparator + curr_file).readline().split()[0] + ")"
-  output.write("RESULTS FOR " + curr_file + lines + "\n")
-  output.flush()
-  print("Executing kernel %s (%d/%d)..." % (curr_file, file_index, len(file_list)))
-  sys.stdout.flush()
+def write_checkpoint(next_index):
+  for f in (output, times):
+    f.flush()
+    os.fsync(f.fileno())
+  next_test = file_list[next_index] if next_index < len(file_list) else ""
+  tmp = checkpoint_file + ".tmp"
+  with open(tmp, 'w') as f:
+    f.write("%d %d %d %s\n" % (next_index, output.tell(), times.tell(), next_test))
+    f.flush()
+    os.fsync(f.fileno())
+  os.replace(tmp, checkpoint_file)
 
+def build_command(curr_file):
   file_path = args.path + pathSeparator + curr_file
   cmd = "%s -f %s -p %d -d %d" % (args.cl_launcher, file_path, args.cl_platform_idx, args.cl_device_idx)
   if (args.device_name_contains):
       cmd += " -n " + args.device_name_contains
-  if (check_args):
-      cmd += " -a " + check_args
+  check_args = os.path.splitext(curr_file)[0] + ".args"
+  if check_args in full_file_list:
+      cmd += " -a " + args.path + pathSeparator + check_args
   if (args.flags):
       cmd += " " + " ".join(args.flags)
-  run_prog = WorkerThread(args.timeout, cmd)
-  run_prog_res = run_prog.start()
+  return shlex.split(cmd)
+
+def stop_process(process, sig):
+  try:
+    if hasattr(os, "killpg"):
+      os.killpg(process.pid, sig)
+    else:
+      process.kill()
+  except OSError:
+    pass
+
+# Launchers still running, stopped if the run is aborted.
+running = set()
+running_lock = threading.Lock()
+
+def stop_running(sig):
+  """ Stops every launcher still running. Takes a copy of the set rather than
+  the lock, so that it can be called from a signal handler. """
+  for process in list(running):
+    stop_process(process, sig)
 
-  run_prog_out = run_prog_res[0].decode('unicode_escape')
+# The launchers are in their own sessions, so they do not see the signals sent
+# to this script. Stop them when it exits or is interrupted.
+atexit.register(stop_running, signal.SIGKILL)
+
+def on_signal(signum, frame):
+  stop.set()
+  stop_running(signal.SIGKILL)
+  sys.exit(128 + signum)
+
+def run_launcher(cmd):
+  """ Runs one launcher, in its own process group so that it can be stopped
+  with everything it started. Returns (output, return code, timed out, wall
+  time, CPU time); the CPU time is None where os.wait4 is not available. """
+  start = time.time()
+  if not hasattr(os, "wait4"):
+    process = subprocess.Popen(cmd, stdout=subprocess.PIPE)
+    with running_lock:
+      running.add(process)
+    try:
+      out = process.communicate(timeout=args.timeout)[0]
+      return out, process.returncode, False, time.time() - start, None
+    except subprocess.TimeoutExpired:
+      process.kill()
+      out = process.communicate()[0]
+      return out, process.returncode, True, time.time() - start, None
+    finally:
+      with running_lock:
+        running.discard(process)
+
+  process = subprocess.Popen(cmd, stdout=subprocess.PIPE, start_new_session=True)
+  with running_lock:
+    running.add(process)
+  # The run may have been stopped while this one was starting.
+  if stop.is_set():
+    stop_process(process, signal.SIGKILL)
+  timed_out = threading.Event()
+  def on_timeout():
+    timed_out.set()
+    stop_process(process, signal.SIGTERM)
+  term_timer = threading.Timer(args.timeout, on_timeout)
+  kill_timer = threading.Timer(args.timeout + killGracePeriod, stop_process, [process, signal.SIGKILL])
+  term_timer.start()
+  kill_timer.start()
+  out = process.stdout.read()
+  process.stdout.close()
+  _, status, usage = os.wait4(process.pid, 0)
+  term_timer.cancel()
+  kill_timer.cancel()
+  with running_lock:
+    running.discard(process)
+  wall = time.time() - start
+  process.returncode = -os.WTERMSIG(status) if os.WIFSIGNALED(status) else os.WEXITSTATUS(status)
+  return out, process.returncode, timed_out.is_set(), wall, usage.ru_utime + usage.ru_stime
+
+def digest_hashes(out):
+  """ The distinct hashes in the record cl_launcher prints for tests that
+  compute digests, formatted as it prints the full output, or None if out is
+  not such a record. """
+  if not out.startswith(b"CLSD") or len(out) < 16:
+    return None
+  _, groups, distinct = struct.unpack_from("=III", out, 4)
+  offset = 16 + 16 * (groups + 1)
+  if len(out) < offset + 12 * distinct:
+    return None
+  hashes = [struct.unpack_from("=Q", out, offset + 12 * i)[0] for i in range(distinct)]
+  return ["%#x" % h if h else "0" for h in hashes]
+
+def count_lines(path):
+  with open(path, 'rb') as f:
+    return sum(1 for _ in f)
+
+device_mismatch = threading.Event()
+stop = threading.Event()
+print_lock = threading.Lock()
+todo = queue.Queue()
+done = queue.Queue()
+
+def run_test(index, curr_file):
+  """ Runs one test. Returns its record for the output and its line for the
+  times file, or (None, None) if the device name did not match. """
+  with print_lock:
+    print("Executing kernel %s (%d/%d)..." % (curr_file, index + 1, len(file_list)))
+    sys.stdout.flush()
+
+  file_path = args.path + pathSeparator + curr_file
+  record = "RESULTS FOR %s (%d)\n" % (curr_file, count_lines(file_path))
+  try:
+    run_prog_res = run_launcher(build_command(curr_file))
+  except OSError as e:
+    run_prog_res = (str(e).encode(), 1, False, 0.0, None)
+  # The digest record is binary, and is not decoded as text.
+  hashes = digest_hashes(run_prog_res[0])
+  run_prog_out = "" if hashes is not None else run_prog_res[0].decode('unicode_escape')
   run_prog_out = '\n'.join(filter(lambda x: (not "PLUGIN" in x), run_prog_out.split("\n")))
 
   if "not found in device name" in run_prog_out or "No matching platform or device found" in run_prog_out:
+    with print_lock:
       print("Mismatch in device name (aborting all further runs)")
       print(run_prog_out)
+    device_mismatch.set()
+    return None, None
+
+  if run_prog_res[2]:
+    status = "timeout"
+    record += "timeout\n"
+  elif not run_prog_res[1] == 0:
+    status = "run_error"
+    record += "run_error: %s\n" % (run_prog_out)
+  else:
+    status = "ok"
+    if hashes is not None:
+      run_prog_out = sorted(hashes)
+    else:
+      run_prog_out = sorted(filter(None, set(run_prog_out.split(','))))
+    record += "".join([result + ", " for result in run_prog_out]) + "\n"
+  cpu = "" if run_prog_res[4] is None else "%.3f" % run_prog_res[4]
+  timing = "%s,%s,%.3f,%s\n" % (curr_file, status, run_prog_res[3], cpu)
+  return record, timing
+
+def worker():
+  while not stop.is_set():
+    try:
+      index, curr_file = todo.get_nowait()
+    except queue.Empty:
+      return
+    try:
+      record, timing = run_test(index, curr_file)
+    except BaseException:
+      # Stop the run, rather than leave the writer waiting for this test.
+      record, timing = None, sys.exc_info()[1]
+    if record is None:
+      stop.set()
+    done.put((index, record, timing))
+    if record is None:
+      return
+
+if not resuming:
+  times.write("kernel,status,wall_s,cpu_s\n")
+
+# Tests that are skipped are done straight away, with nothing to write.
+pending = dict()
+for index in range(start_index, len(file_list)):
+  curr_file = file_list[index]
+  if curr_file in already_processed:
+    print("Skipping kernel %s (%d/%d)..." % (curr_file, index + 1, len(file_list)))
+    pending[index] = ("", "")
+  else:
+    todo.put((index, curr_file))
+
+signal.signal(signal.SIGINT, on_signal)
+signal.signal(signal.SIGTERM, on_signal)
+
+threads = [threading.Thread(target=worker) for _ in range(max(1, args.jobs))]
+for t in threads:
+  t.daemon = True
+  t.start()
+
+# Write the results in order, holding back any that finish early.
+next_index = start_index
+since_checkpoint = 0
+while next_index < len(file_list):
+  while next_index in pending:
+    record, timing = pending.pop(next_index)
+    output.write(record)
+    times.write(timing)
+    next_index += 1
+    since_checkpoint += 1
+    if since_checkpoint >= args.checkpoint:
+      write_checkpoint(next_index)
+      since_checkpoint = 0
+  if next_index >= len(file_list):
+    break
+  index, record, timing = done.get()
+  if record is None:
+    break
+  pending[index] = (record, timing)
+
+if stop.is_set():
+  stop_running(signal.SIGKILL)
+  for t in threads:
+    t.join()
+  if not device_mismatch.is_set():
+    # Keep what is done; -resume carries on from the last checkpoint.
+    write_checkpoint(next_index)
+    output.close()
+    times.close()
+    sys.stderr.write("Error running kernel %s: %r\n" % (file_list[index], timing))
+    sys.exit(1)
+  output.close()
+  times.close()
+  if not resuming:
+    for f in (args.output, times_file, checkpoint_file):
       try:
-          os.remove(args.output)
-      except IOError:
-          pass
-      sys.exit(1)
-
-  if not run_prog_res[1] == 0:
-      output.write("run_error: %s\n" % (run_prog_out))
-      output.flush()
-      continue
-  elif run_prog_out == "Process timeout":
-      output.write("timeout\n")
-      output.flush()
-      continue
-
-  run_prog_out = run_prog_out.split(',')
-  run_prog_out = filter(None, set(run_prog_out))
-
-  for result in run_prog_out:
-      output.write(result + ", ")
-      output.flush()
-  output.write("\n")
+        os.remove(f)
+      except OSError:
+        pass
+  sys.exit(1)
+
+write_checkpoint(next_index)
+output.close()
+times.close()
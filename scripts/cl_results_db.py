@@ -0,0 +1,302 @@
+#!/usr/bin/python3
+
+""" A store for the results of running tests on several configurations.
+
+The results files written by cl_get_and_test.py are imported as they grow:
+the store remembers how far it has read each one, and only reads what was
+appended since. Each result is kept as the hash of its values, with each
+distinct set of values stored once. The vote for the majority result of a
+test, and the configurations that disagree with it, are updated as each
+result comes in, so nothing is recomputed over all the results.
+
+Usage:
+  cl_results_db.py DB import FILE...   Import results files, one per
+                                       configuration
+  cl_results_db.py DB new [--keep]     List the discrepancies found since the
+                                       last time this was run
+  cl_results_db.py DB list             List all the discrepancies
+  cl_results_db.py DB show KERNEL      Show the results of one test
+"""
+
+import argparse
+import hashlib
+import os
+import sqlite3
+import sys
+import time
+
+SCHEMA = """
+CREATE TABLE IF NOT EXISTS vectors (
+  hash TEXT PRIMARY KEY,
+  value TEXT NOT NULL,
+  ok INTEGER NOT NULL
+) WITHOUT ROWID;
+CREATE TABLE IF NOT EXISTS results (
+  kernel TEXT NOT NULL,
+  config TEXT NOT NULL,
+  hash TEXT NOT NULL,
+  PRIMARY KEY (kernel, config)
+) WITHOUT ROWID;
+CREATE TABLE IF NOT EXISTS kernels (
+  kernel TEXT PRIMARY KEY,
+  lines TEXT,
+  majority TEXT
+) WITHOUT ROWID;
+CREATE TABLE IF NOT EXISTS votes (
+  kernel TEXT NOT NULL,
+  hash TEXT NOT NULL,
+  count INTEGER NOT NULL,
+  PRIMARY KEY (kernel, hash)
+) WITHOUT ROWID;
+CREATE TABLE IF NOT EXISTS discrepancies (
+  kernel TEXT NOT NULL,
+  config TEXT NOT NULL,
+  run INTEGER NOT NULL,
+  PRIMARY KEY (kernel, config)
+) WITHOUT ROWID;
+CREATE INDEX IF NOT EXISTS discrepancies_run ON discrepancies (run);
+CREATE TABLE IF NOT EXISTS runs (
+  run INTEGER PRIMARY KEY,
+  started REAL NOT NULL,
+  reported INTEGER NOT NULL DEFAULT 0
+);
+CREATE TABLE IF NOT EXISTS sources (
+  path TEXT PRIMARY KEY,
+  config TEXT NOT NULL,
+  offset INTEGER NOT NULL,
+  tail TEXT NOT NULL
+) WITHOUT ROWID;
+"""
+
+# A majority result needs more votes than this.
+MIN_VOTES = 2
+
+# Bytes before the import offset of a file that are checked to find out if it
+# was written again rather than appended to.
+TAIL_SIZE = 256
+
+def config_name(path):
+  """ Name of the configuration of a results file, e.g. "intel gpu" for
+  intel_gpu.csv. """
+  return ' '.join(os.path.basename(path).split('.')[0].split('_'))
+
+def normalise(body):
+  """ Turns the lines of a result into the list of its values. Values are
+  given a 0x prefix if they are hexadecimal without one. """
+  if not body:
+    return []
+  values = [r.strip() for r in body[0].split(',')] + body[1:]
+  normal = []
+  for r in values:
+    if not r:
+      continue
+    if not r.startswith("0x") and all(c in "0123456789abcdef" for c in r):
+      r = "0x" + r
+    normal.append(r)
+  return normal
+
+class ResultStore(object):
+
+  def __init__(self, path):
+    self.db = sqlite3.connect(path)
+    self.db.executescript(SCHEMA)
+    self.run = None
+
+  def close(self):
+    self.db.commit()
+    self.db.close()
+
+  def begin_run(self):
+    """ Starts a new run; discrepancies found from now on are tagged with
+    it. """
+    cur = self.db.execute("INSERT INTO runs (started) VALUES (?)", (time.time(),))
+    self.run = cur.lastrowid
+
+  def import_file(self, path, config=None):
+    """ Imports the results appended to a results file since it was last
+    imported. Returns the number of results read. """
+    if config is None:
+      config = config_name(path)
+    row = self.db.execute("SELECT offset, tail FROM sources WHERE path = ?", (path,)).fetchone()
+    offset = row[0] if row else 0
+
+    count = 0
+    kernel = None
+    with open(path, 'rb') as f:
+      if offset > 0 and (offset > os.path.getsize(path) or self._tail(f, offset) != row[1]):
+        # The file was written again rather than appended to.
+        offset = 0
+      f.seek(offset)
+      pos = offset
+      record_start = offset
+      for raw in f:
+        line = raw.decode('utf-8', 'replace').strip()
+        if line.startswith("RESULTS FOR"):
+          if kernel is not None:
+            self.add_result(kernel, config, body, lines)
+            count += 1
+          kernel, lines = self._parse_header(line)
+          body = []
+          record_start = pos
+        elif line and kernel is not None:
+          body.append(line)
+        pos += len(raw)
+      if kernel is not None:
+        # The last record may still be growing: import it, but read it again
+        # next time.
+        self.add_result(kernel, config, body, lines)
+        count += 1
+        pos = record_start
+      tail = self._tail(f, pos)
+    self.db.execute("INSERT OR REPLACE INTO sources (path, config, offset, tail) VALUES (?, ?, ?, ?)",
+                    (path, config, pos, tail))
+    self.db.commit()
+    return count
+
+  @staticmethod
+  def _tail(f, offset):
+    start = max(0, offset - TAIL_SIZE)
+    f.seek(start)
+    return hashlib.sha1(f.read(offset - start)).hexdigest()
+
+  @staticmethod
+  def _parse_header(line):
+    name = line.replace("RESULTS FOR", "").strip()
+    lines = None
+    if name.endswith(")") and " (" in name:
+      name, lines = name.rsplit(" (", 1)
+      lines = lines[:-1]
+    return name.rsplit(".", 1)[0].strip(), lines
+
+  def add_result(self, kernel, config, body, lines=None):
+    """ Records the result of a test on a configuration, given as the lines
+    after its RESULTS FOR line, replacing any earlier result. """
+    values = normalise(body)
+    ok = bool(values) and all(v.startswith("0x") for v in values)
+    if ok:
+      value = ",".join(sorted(set(values)))
+    else:
+      value = ",".join(values)
+    digest = hashlib.sha1(value.encode('utf-8')).hexdigest()
+
+    old = self.db.execute("SELECT hash FROM results WHERE kernel = ? AND config = ?",
+                          (kernel, config)).fetchone()
+    if old and old[0] == digest:
+      return
+    if self.run is None:
+      self.begin_run()
+    self.db.execute("INSERT OR IGNORE INTO vectors (hash, value, ok) VALUES (?, ?, ?)",
+                    (digest, value, int(ok)))
+    self.db.execute("INSERT OR IGNORE INTO kernels (kernel, lines) VALUES (?, ?)", (kernel, lines))
+    if lines is not None:
+      self.db.execute("UPDATE kernels SET lines = ? WHERE kernel = ?", (lines, kernel))
+    if old:
+      self.db.execute("UPDATE votes SET count = count - 1 WHERE kernel = ? AND hash = ?",
+                      (kernel, old[0]))
+      # A different wrong result is a new discrepancy.
+      self.db.execute("DELETE FROM discrepancies WHERE kernel = ? AND config = ?",
+                      (kernel, config))
+    self.db.execute("INSERT OR REPLACE INTO results (kernel, config, hash) VALUES (?, ?, ?)",
+                    (kernel, config, digest))
+    self.db.execute("INSERT OR IGNORE INTO votes (kernel, hash, count) VALUES (?, ?, 0)",
+                    (kernel, digest))
+    self.db.execute("UPDATE votes SET count = count + 1 WHERE kernel = ? AND hash = ?",
+                    (kernel, digest))
+    self._update_verdict(kernel)
+
+  def _update_verdict(self, kernel):
+    """ Picks the majority result of a test again, and updates the
+    configurations that disagree with it. """
+    top = self.db.execute(
+        "SELECT votes.hash, count FROM votes JOIN vectors ON votes.hash = vectors.hash "
+        "WHERE kernel = ? AND ok AND count > 0 ORDER BY count DESC LIMIT 2", (kernel,)).fetchall()
+    majority = None
+    if top and top[0][1] > MIN_VOTES and (len(top) == 1 or top[1][1] < top[0][1]):
+      majority = top[0][0]
+    self.db.execute("UPDATE kernels SET majority = ? WHERE kernel = ?", (majority, kernel))
+
+    if majority is None:
+      self.db.execute("DELETE FROM discrepancies WHERE kernel = ?", (kernel,))
+      return
+    self.db.execute(
+        "DELETE FROM discrepancies WHERE kernel = ? AND config IN "
+        "(SELECT config FROM results WHERE kernel = ? AND hash = ?)", (kernel, kernel, majority))
+    self.db.execute(
+        "INSERT OR IGNORE INTO discrepancies (kernel, config, run) "
+        "SELECT kernel, config, ? FROM results WHERE kernel = ? AND hash != ?",
+        (self.run, kernel, majority))
+
+  def configs(self):
+    return [r[0] for r in self.db.execute("SELECT DISTINCT config FROM results ORDER BY config")]
+
+  def kernels(self):
+    """ Yields (kernel, lines, majority values or None) for every test. """
+    cur = self.db.execute(
+        "SELECT kernel, lines, value FROM kernels LEFT JOIN vectors ON majority = hash "
+        "ORDER BY kernel")
+    for row in cur:
+      yield row
+
+  def results(self, kernel):
+    """ Returns {config: (values, agrees)} for a test, where agrees tells if
+    the values are the majority result, or is None if there is none. """
+    cur = self.db.execute(
+        "SELECT config, value, results.hash = kernels.majority FROM results "
+        "JOIN vectors ON results.hash = vectors.hash "
+        "JOIN kernels ON results.kernel = kernels.kernel WHERE results.kernel = ?", (kernel,))
+    return dict((config, (value, None if agrees is None else bool(agrees)))
+                for config, value, agrees in cur)
+
+  def discrepancies(self, new_only=False, mark=True):
+    """ Returns (kernel, config, values) for every configuration disagreeing
+    with a majority result. With new_only, only those found in runs not yet
+    reported, which are then marked as reported unless mark is unset. """
+    query = ("SELECT discrepancies.kernel, config, value FROM discrepancies "
+             "JOIN results USING (kernel, config) JOIN vectors USING (hash) ")
+    if new_only:
+      query += "WHERE run IN (SELECT run FROM runs WHERE NOT reported) "
+    query += "ORDER BY discrepancies.kernel, config"
+    rows = self.db.execute(query).fetchall()
+    if new_only and mark:
+      self.db.execute("UPDATE runs SET reported = 1")
+      self.db.commit()
+    return rows
+
+def main():
+  parser = argparse.ArgumentParser(description="Store and query test results.")
+  parser.add_argument('db', help="Result store, created if missing")
+  sub = parser.add_subparsers(dest='command')
+  p = sub.add_parser('import', help="Import results files, one per configuration")
+  p.add_argument('files', nargs='+')
+  p = sub.add_parser('new', help="List the discrepancies found since the last time")
+  p.add_argument('--keep', action='store_true', help="Do not mark them as reported")
+  sub.add_parser('list', help="List all the discrepancies")
+  p = sub.add_parser('show', help="Show the results of one test")
+  p.add_argument('kernel')
+  args = parser.parse_args()
+
+  store = ResultStore(args.db)
+  if args.command == 'import':
+    for path in args.files:
+      print("%s: %d results" % (path, store.import_file(path)))
+  elif args.command in ('new', 'list'):
+    rows = store.discrepancies(new_only=args.command == 'new',
+                               mark=not getattr(args, 'keep', False))
+    for kernel, config, value in rows:
+      print("%s\t%s\t%s" % (kernel, config, value))
+  elif args.command == 'show':
+    results = store.results(args.kernel)
+    if not results:
+      print("No results for %s" % args.kernel)
+      store.close()
+      return 1
+    for config in sorted(results):
+      value, agrees = results[config]
+      print("%s%s\t%s" % ("* " if agrees is False else "", config, value))
+  else:
+    parser.print_help()
+  store.close()
+  return 0
+
+if __name__ == "__main__":
+  sys.exit(main())
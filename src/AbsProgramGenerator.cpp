@@ -38,7 +38,7 @@
 
 using namespace std;
 
-AbsProgramGenerator *AbsProgramGenerator::current_generator_ = NULL;
+thread_local AbsProgramGenerator *AbsProgramGenerator::current_generator_ = NULL;
 
 OutputMgr *
 AbsProgramGenerator::GetOutputMgr()
@@ -99,5 +99,6 @@ AbsProgramGenerator::AbsProgramGenerator()
 
 AbsProgramGenerator::~AbsProgramGenerator()
 {
-
+	if (current_generator_ == this)
+		current_generator_ = NULL;
 }
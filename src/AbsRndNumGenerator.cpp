@@ -33,31 +33,28 @@
 #include <cstdlib>
 #include <iostream>
 
+#include "CGOptions.h"
 #include "DefaultRndNumGenerator.h"
 #include "DFSRndNumGenerator.h"
+#include "RandomEngine.h"
 #include "SimpleDeltaRndNumGenerator.h"
 
 using namespace std;
 
-#ifdef WIN32
-extern "C" {
-	extern void srand48(long seed);
-	extern long lrand48(void);
-}
-#endif
-
 const char *AbsRndNumGenerator::hex1 = "0123456789ABCDEF";
 
 const char *AbsRndNumGenerator::dec1 = "0123456789";
 
-AbsRndNumGenerator::AbsRndNumGenerator()
+AbsRndNumGenerator::AbsRndNumGenerator(const unsigned long seed)
+	: engine_(RandomEngine::make_engine(CGOptions::rng_engine(), seed)),
+	  draws_(0)
 {
-	//Nothing to do
+	assert(engine_);
 }
 
 AbsRndNumGenerator::~AbsRndNumGenerator()
 {
-	//Nothing to do
+	delete engine_;
 }
 
 /*
@@ -68,13 +65,12 @@ AbsRndNumGenerator::make_rndnum_generator(RNDNUM_GENERATOR impl, const unsigned
 {
 	AbsRndNumGenerator *rImpl = 0;
 
-	AbsRndNumGenerator::seedrand(seed);
 	switch (impl) {
 		case rDefaultRndNumGenerator: 
 			rImpl = DefaultRndNumGenerator::make_rndnum_generator(seed);
 			break;
 		case rDFSRndNumGenerator: 
-			rImpl = DFSRndNumGenerator::make_rndnum_generator();
+			rImpl = DFSRndNumGenerator::make_rndnum_generator(seed);
 			break;
 		case rSimpleDeltaRndNumGenerator:
 			rImpl = SimpleDeltaRndNumGenerator::make_rndnum_generator(seed);
@@ -87,12 +83,6 @@ AbsRndNumGenerator::make_rndnum_generator(RNDNUM_GENERATOR impl, const unsigned
 	return rImpl;
 }
 
-void
-AbsRndNumGenerator::seedrand(const unsigned long seed )
-{
-	srand48 (seed);
-}
-
 /*
  * Return random shuffled integers in set [0...n]
  * Note: deprecated.
@@ -122,7 +112,15 @@ AbsRndNumGenerator::rnd_shuffle(unsigned int n)
 unsigned long 
 AbsRndNumGenerator::genrand(void)
 {
-	return lrand48();
+	draws_++;
+	switch (engine_->kind()) {
+	case eXoshiro256Engine:
+		return static_cast<Xoshiro256Engine*>(engine_)->next();
+	case ePCG64Engine:
+		return static_cast<PCG64Engine*>(engine_)->next();
+	default:
+		return static_cast<Rand48Engine*>(engine_)->next();
+	}
 }
 
 std::string
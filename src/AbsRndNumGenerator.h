@@ -32,6 +32,7 @@
 
 #include <string>
 #include "CommonMacros.h"
+#include "RandomEngine.h"
 
 class Filter;
 
@@ -50,8 +51,6 @@ class AbsRndNumGenerator
 public:
 	static AbsRndNumGenerator *make_rndnum_generator(RNDNUM_GENERATOR impl, const unsigned long seed);
 
-	static void seedrand(const unsigned long seed);
-
 	static const char* get_hex1();
 
 	static const char* get_dec1();
@@ -79,14 +78,40 @@ public:
 	// depend on the kind, use polymorphism instead. 
 	virtual enum RNDNUM_GENERATOR kind() = 0;
 
+	// The number of numbers drawn from the engine so far.
+	unsigned long get_draw_count(void) const { return draws_; }
+
 	virtual ~AbsRndNumGenerator(void);
 
 protected:
 	virtual unsigned long genrand(void) = 0;
 
-	AbsRndNumGenerator();
+	// A number in [0, n), straight from the engine.
+	unsigned int genrand_upto(const unsigned int n) {
+		draws_++;
+		// Calls the final engine class, so the draw is inlined here.
+		switch (engine_->kind()) {
+		case eXoshiro256Engine:
+			return static_cast<Xoshiro256Engine*>(engine_)->next_upto(n);
+		case ePCG64Engine:
+			return static_cast<PCG64Engine*>(engine_)->next_upto(n);
+		default:
+			return static_cast<Rand48Engine*>(engine_)->next_upto(n);
+		}
+	}
+
+	// True if the engine must give the same stream as lrand48, in which case
+	// the number of draws made for each choice must not change either.
+	bool exact_stream(void) const { return engine_->kind() == eRand48Engine; }
+
+	// Creates the engine, of the kind given by CGOptions::rng_engine().
+	explicit AbsRndNumGenerator(const unsigned long seed);
 
 private:
+	RandomEngine *engine_;
+
+	unsigned long draws_;
+
 	// ------------------------------------------------------------------------------------------
 	// "hex" and "dec" are reserved keywords in MSVC, we have to rename them
 	static const char *hex1;
@@ -0,0 +1,131 @@
+// -*- mode: C++ -*-
+//
+// Implementation of the arena declared in Arena.h.
+
+#include "Arena.h"
+
+#include <cassert>
+#include <new>
+
+using namespace std;
+
+// Each object is preceded by a header telling where it came from. This keeps
+// the objects aligned as the heap would.
+struct ArenaHeader {
+	Arena *owner;		// NULL if the object is on the heap
+	size_t size_class;
+};
+
+static const size_t header_size = 16;
+static const size_t size_granule = 16;
+// Larger objects are rare, and go to the heap even with an arena current.
+static const size_t max_size_classes = 64;
+static const size_t first_chunk_size = 64 * 1024;
+static const size_t max_chunk_size = 4 * 1024 * 1024;
+
+static thread_local Arena *current_arena = 0;
+
+Arena::Arena(void)
+	: next_(0),
+	  end_(0),
+	  chunk_size_(first_chunk_size),
+	  free_lists_(max_size_classes + 1, (void *)0),
+	  reserved_bytes_(0),
+	  live_bytes_(0),
+	  peak_bytes_(0),
+	  object_count_(0)
+{
+	static_assert(sizeof(ArenaHeader) <= header_size, "arena header too large");
+}
+
+Arena::~Arena(void)
+{
+	assert(current_arena != this);
+	for (size_t i = 0; i < chunks_.size(); ++i) {
+		::operator delete(chunks_[i]);
+	}
+}
+
+Arena *
+Arena::get_current(void)
+{
+	return current_arena;
+}
+
+void
+Arena::set_current(Arena *arena)
+{
+	current_arena = arena;
+}
+
+void *
+Arena::allocate(size_t size_class)
+{
+	const size_t bytes = size_class * size_granule;
+	live_bytes_ += bytes;
+	if (live_bytes_ > peak_bytes_)
+		peak_bytes_ = live_bytes_;
+	++object_count_;
+
+	void *block = free_lists_[size_class];
+	if (block) {
+		free_lists_[size_class] = *static_cast<void **>(block);
+		return block;
+	}
+	if (next_ + bytes > end_) {
+		// What is left of the old chunk is lost, at most one object's worth.
+		next_ = static_cast<char *>(::operator new(chunk_size_));
+		end_ = next_ + chunk_size_;
+		chunks_.push_back(next_);
+		reserved_bytes_ += chunk_size_;
+		if (chunk_size_ < max_chunk_size)
+			chunk_size_ *= 2;
+	}
+	block = next_;
+	next_ += bytes;
+	return block;
+}
+
+void
+Arena::release(void *block, size_t size_class)
+{
+	live_bytes_ -= size_class * size_granule;
+	*static_cast<void **>(block) = free_lists_[size_class];
+	free_lists_[size_class] = block;
+}
+
+void *
+Arena::allocate_object(size_t size)
+{
+	const size_t size_class = (size + header_size + size_granule - 1) / size_granule;
+	Arena *arena = current_arena;
+	void *block;
+	if (arena && size_class <= max_size_classes) {
+		block = arena->allocate(size_class);
+	}
+	else {
+		arena = 0;
+		block = ::operator new(size + header_size);
+	}
+	ArenaHeader *header = static_cast<ArenaHeader *>(block);
+	header->owner = arena;
+	header->size_class = size_class;
+	return static_cast<char *>(block) + header_size;
+}
+
+void
+Arena::release_object(void *p)
+{
+	if (!p)
+		return;
+	void *block = static_cast<char *>(p) - header_size;
+	ArenaHeader *header = static_cast<ArenaHeader *>(block);
+	if (header->owner) {
+		// Objects are only deleted on the thread that made them.
+		assert(header->owner == current_arena);
+		header->owner->release(block, header->size_class);
+	}
+	else {
+		::operator delete(block);
+	}
+}
@@ -0,0 +1,79 @@
+// -*- mode: C++ -*-
+//
+// The memory of the nodes of one generated program: statements, expressions,
+// variables, facts and CFG edges, and the classes derived from them.
+//
+// While an arena is current on a thread, those objects are carved out of its
+// chunks instead of being allocated one by one. Deleting one puts its block
+// on a free list for its size, where the next object of that size finds it.
+// Deleting the arena frees all its objects at once, including those no one
+// deleted, without running their destructors; nothing may use them after.
+// With no arena current, the objects come from the heap as usual.
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <vector>
+#include "CommonMacros.h"
+
+class Arena
+{
+public:
+	Arena(void);
+
+	~Arena(void);
+
+	static Arena *get_current(void);
+
+	// Makes the arena current on this thread, or none if NULL.
+	static void set_current(Arena *arena);
+
+	// Used by the operator new and delete of the classes declared with
+	// ARENA_ALLOCATED.
+	static void *allocate_object(size_t size);
+	static void release_object(void *p);
+
+	// Total size of the chunks.
+	size_t get_reserved_bytes(void) const { return reserved_bytes_; }
+
+	// Most memory held by live objects at any one time.
+	size_t get_peak_bytes(void) const { return peak_bytes_; }
+
+	// Number of objects allocated, including those already deleted.
+	size_t get_object_count(void) const { return object_count_; }
+
+private:
+	void *allocate(size_t size_class);
+
+	void release(void *block, size_t size_class);
+
+	std::vector<char *> chunks_;
+
+	char *next_;
+
+	char *end_;
+
+	size_t chunk_size_;
+
+	// Heads of the free lists, one per size class.
+	std::vector<void *> free_lists_;
+
+	size_t reserved_bytes_;
+
+	size_t live_bytes_;
+
+	size_t peak_bytes_;
+
+	size_t object_count_;
+
+	DISALLOW_COPY_AND_ASSIGN(Arena);
+};
+
+// Declares the operator new and delete of a class, to allocate its objects in
+// the current arena. They are inherited by derived classes.
+#define ARENA_ALLOCATED \
+	static void *operator new(size_t size) { return Arena::allocate_object(size); } \
+	static void operator delete(void *p) { Arena::release_object(p); }
+
+#endif // ARENA_H
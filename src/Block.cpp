@@ -60,11 +60,23 @@
 #include "CFGEdge.h"
 #include "Expression.h"
 #include "VectorFilter.h"
+#include "Bookkeeper.h"
 
 #include "CLSmith/ExpressionAtomic.h"
+#include "CLSmith/GenerationContext.h"
+#include "CLSmith/UseDefIndex.h"
 
 using namespace std;
 
+/*
+ * How many times find_fixed_point() may analyse a block again after merging
+ * the facts of its back edges. Merging facts only ever adds targets to
+ * points-to sets, which can only hold the variables in scope, and moves
+ * union facts towards bottom, so the analysis converges after a few rounds.
+ * Needing more rounds than this means the merge is not monotone.
+ */
+static const int max_fixed_point_revisits = 8;
+
 ///////////////////////////////////////////////////////////////////////////////
 Block* find_block_by_id(int blk_id)
 {
@@ -286,8 +298,11 @@ static void
 OutputStatementList(const vector<Statement*> &stms, std::ostream &out, FactMgr* fm, int indent)
 {
 	size_t i;
+	CLSmith::GenerationContext::Features* features =
+		CLSmith::GenerationContext::GetCurrentFeatures();
 	for (i=0; i<stms.size(); i++) {
 		const Statement* stm = stms[i];
+		if (features) features->RecordStatement(*stm);
 		stm->pre_output(out, fm, indent);
 		stm->Output(out, fm, indent);
 		stm->post_output(out, fm, indent);
@@ -300,6 +315,10 @@ OutputStatementList(const vector<Statement*> &stms, std::ostream &out, FactMgr*
 void
 Block::Output(std::ostream &out, FactMgr* fm, int indent) const
 { 
+	CLSmith::GenerationContext::Features* features =
+		CLSmith::GenerationContext::GetCurrentFeatures();
+	if (features) features->RecordBlock(*this);
+
 	output_tab(out, indent);
 	out << "{ ";
 	std::ostringstream ss; 
@@ -590,16 +609,17 @@ Block::find_fixed_point(vector<const Fact*> inputs, vector<const Fact*>& post_fa
 	FactMgr* fm = get_fact_mgr(&cg_context);  
 	// include outputs from all back edges leading to this block
 	size_t i;
-	static int g = 0;
+	static thread_local int g = 0;
 	vector<const CFGEdge*> edges;
-	int cnt = 0;
+	int revisits = 0;
 	do {
+		Bookkeeper::fixed_point_iteration_cnt++;
 		// if we have never visited the block, force the visitor to go through all statements at least once
 		if (fm->map_visited[this]) {
-			if (cnt++ > 7) {
+			if (++revisits > max_fixed_point_revisits) {
 				// takes too many iterations to reach a fixed point, must be something wrong
-				assert(0);			
-			} 
+				assert(0);
+			}
 			find_edges_in(edges, false, true); 
 			for (i=0; i<edges.size(); i++) { 
 				const Statement* src = edges[i]->src;
@@ -728,10 +748,12 @@ Block::remove_stmt(const Statement* s)
 	}
 
 	// delete all the blocks inside s
+	CLSmith::UseDefIndex* index = CLSmith::UseDefIndex::GetUseDefIndex();
 	len = func->blocks.size();
 	for (i=0; i<len; i++) {
 		Block* b = func->blocks[i];
 		if (s->contains_stmt(b)) {
+			if (index) index->RemoveBlock(b);
 			func->blocks.erase(func->blocks.begin() + i);
 			i--;
 			len--;
@@ -740,6 +762,7 @@ Block::remove_stmt(const Statement* s)
 	// delete the statment itself
 	for (i=0; i<(int)stms.size(); i++) {
 		if (stms[i] == s) {
+			if (index) index->RemoveStatement(s);
 			deleted_stms.push_back(stms[i]);
 			stms.erase(stms.begin() + i);
 			cnt++;
@@ -782,11 +805,16 @@ Block::post_creation_analysis(CGContext& cg_context, const Effect& pre_effect)
 		vector<const Fact*> facts_copy = fm->map_facts_in[this];  
 		// reset the accumulative effect 
 		cg_context.reset_effect_accum(pre_effect); 
+		// After deleting statements the whole block is analysed again from
+		// empty fact maps. Which statements the analysis deletes depends on
+		// this order, so re-analysing only the affected statements would
+		// change the generated programs.
 		while (!find_fixed_point(facts_copy, post_facts, cg_context, index, need_revisit)) {
 			size_t i, len;
+			Bookkeeper::analysis_restart_cnt++;
 			len = stms.size();
 			for (i=index; i<len; i++) {
-				remove_stmt(stms[i]); 
+				Bookkeeper::stm_delete_cnt += remove_stmt(stms[i]); 
 				i = index-1;
 				len = stms.size();
 			}
@@ -47,6 +47,7 @@
 
 #include "Statement.h"
 #include "Type.h"
+#include "VariableIndex.h"
 
 class CGContext;
 class Statement;
@@ -83,7 +84,9 @@ public:
 	// These are currently accessed directly.
 	std::vector<Statement *> stms;
 	std::vector<Statement *> deleted_stms;
-	std::vector<Variable *> local_vars; 
+	VariableList local_vars;
+	// local_vars as seen by VariableSelector::choose_var()
+	mutable VariableIndex local_var_index;
 	mutable std::map<std::string, enum eSimpleType> macro_tmp_vars;
 
 	std::string create_new_tmp_var(enum eSimpleType type) const;
@@ -51,43 +51,51 @@ using namespace std;
 ///////////////////////////////////////////////////////////////////////////////
  
 // counter for all levels of struct depth
-std::vector<int> Bookkeeper::struct_depth_cnts; 
-int Bookkeeper::union_var_cnt = 0;
-std::vector<int> Bookkeeper::expr_depth_cnts;
-std::vector<int> Bookkeeper::blk_depth_cnts;
-std::vector<int> Bookkeeper::dereference_level_cnts;
-int Bookkeeper::address_taken_cnt = 0;
-std::vector<int> Bookkeeper::read_dereference_cnts;
-std::vector<int> Bookkeeper::write_dereference_cnts;
-int Bookkeeper::cmp_ptr_to_null = 0;
-int Bookkeeper::cmp_ptr_to_ptr = 0;
-int Bookkeeper::cmp_ptr_to_addr = 0; 
-int Bookkeeper::read_volatile_cnt = 0;
-int Bookkeeper::write_volatile_cnt = 0;
-int Bookkeeper::read_non_volatile_cnt = 0;
-int Bookkeeper::write_non_volatile_cnt = 0;
-int Bookkeeper::read_volatile_thru_ptr_cnt = 0;
-int Bookkeeper::write_volatile_thru_ptr_cnt = 0;
-int Bookkeeper::pointer_avail_for_dereference = 0;
-int Bookkeeper::volatile_avail = 0;
-int Bookkeeper::structs_with_bitfields = 0;
-std::vector<int> Bookkeeper::vars_with_bitfields;
-std::vector<int> Bookkeeper::vars_with_full_bitfields;
-int Bookkeeper::vars_with_bitfields_address_taken_cnt = 0;
-int Bookkeeper::bitfields_in_total = 0;
-int Bookkeeper::unamed_bitfields_in_total = 0;
-int Bookkeeper::const_bitfields_in_total = 0;
-int Bookkeeper::volatile_bitfields_in_total = 0;
-int Bookkeeper::lhs_bitfields_structs_vars_cnt = 0;
-int Bookkeeper::rhs_bitfields_structs_vars_cnt = 0;
-int Bookkeeper::lhs_bitfield_cnt = 0;
-int Bookkeeper::rhs_bitfield_cnt = 0;
-int Bookkeeper::forward_jump_cnt = 0;
-int Bookkeeper::backward_jump_cnt = 0;
-int Bookkeeper::use_new_var_cnt = 0;
-int Bookkeeper::use_old_var_cnt = 0;
-bool Bookkeeper::rely_on_int_size = false;
-bool Bookkeeper::rely_on_ptr_size = false;
+thread_local std::vector<int> Bookkeeper::struct_depth_cnts; 
+thread_local int Bookkeeper::union_var_cnt = 0;
+thread_local std::vector<int> Bookkeeper::expr_depth_cnts;
+thread_local std::vector<int> Bookkeeper::blk_depth_cnts;
+thread_local std::vector<int> Bookkeeper::stm_analysis_cnts;
+thread_local std::vector<int> Bookkeeper::dereference_level_cnts;
+thread_local int Bookkeeper::address_taken_cnt = 0;
+thread_local std::vector<int> Bookkeeper::read_dereference_cnts;
+thread_local std::vector<int> Bookkeeper::write_dereference_cnts;
+thread_local int Bookkeeper::cmp_ptr_to_null = 0;
+thread_local int Bookkeeper::cmp_ptr_to_ptr = 0;
+thread_local int Bookkeeper::cmp_ptr_to_addr = 0; 
+thread_local int Bookkeeper::read_volatile_cnt = 0;
+thread_local int Bookkeeper::write_volatile_cnt = 0;
+thread_local int Bookkeeper::read_non_volatile_cnt = 0;
+thread_local int Bookkeeper::write_non_volatile_cnt = 0;
+thread_local int Bookkeeper::read_volatile_thru_ptr_cnt = 0;
+thread_local int Bookkeeper::write_volatile_thru_ptr_cnt = 0;
+thread_local int Bookkeeper::pointer_avail_for_dereference = 0;
+thread_local int Bookkeeper::volatile_avail = 0;
+thread_local int Bookkeeper::structs_with_bitfields = 0;
+thread_local std::vector<int> Bookkeeper::vars_with_bitfields;
+thread_local std::vector<int> Bookkeeper::vars_with_full_bitfields;
+thread_local int Bookkeeper::vars_with_bitfields_address_taken_cnt = 0;
+thread_local int Bookkeeper::bitfields_in_total = 0;
+thread_local int Bookkeeper::unamed_bitfields_in_total = 0;
+thread_local int Bookkeeper::const_bitfields_in_total = 0;
+thread_local int Bookkeeper::volatile_bitfields_in_total = 0;
+thread_local int Bookkeeper::lhs_bitfields_structs_vars_cnt = 0;
+thread_local int Bookkeeper::rhs_bitfields_structs_vars_cnt = 0;
+thread_local int Bookkeeper::lhs_bitfield_cnt = 0;
+thread_local int Bookkeeper::rhs_bitfield_cnt = 0;
+thread_local int Bookkeeper::forward_jump_cnt = 0;
+thread_local int Bookkeeper::backward_jump_cnt = 0;
+thread_local int Bookkeeper::use_new_var_cnt = 0;
+thread_local int Bookkeeper::use_old_var_cnt = 0;
+thread_local int Bookkeeper::stm_visit_cnt = 0;
+thread_local int Bookkeeper::stm_shortcut_cnt = 0;
+thread_local int Bookkeeper::fixed_point_iteration_cnt = 0;
+thread_local int Bookkeeper::analysis_restart_cnt = 0;
+thread_local int Bookkeeper::stm_delete_cnt = 0;
+thread_local int Bookkeeper::fact_rollback_cnt = 0;
+thread_local int Bookkeeper::filter_reject_cnt = 0;
+thread_local bool Bookkeeper::rely_on_int_size = false;
+thread_local bool Bookkeeper::rely_on_ptr_size = false;
 
 /*
  *
@@ -128,7 +136,42 @@ Bookkeeper::doFinalization()
 	Bookkeeper::cmp_ptr_to_null = 0;
 	Bookkeeper::cmp_ptr_to_ptr = 0;
 	Bookkeeper::cmp_ptr_to_addr = 0;
-	
+	Bookkeeper::union_var_cnt = 0;
+	Bookkeeper::blk_depth_cnts.clear();
+	Bookkeeper::stm_analysis_cnts.clear();
+	Bookkeeper::read_volatile_cnt = 0;
+	Bookkeeper::write_volatile_cnt = 0;
+	Bookkeeper::read_non_volatile_cnt = 0;
+	Bookkeeper::write_non_volatile_cnt = 0;
+	Bookkeeper::read_volatile_thru_ptr_cnt = 0;
+	Bookkeeper::write_volatile_thru_ptr_cnt = 0;
+	Bookkeeper::pointer_avail_for_dereference = 0;
+	Bookkeeper::volatile_avail = 0;
+	Bookkeeper::structs_with_bitfields = 0;
+	Bookkeeper::vars_with_bitfields.clear();
+	Bookkeeper::vars_with_full_bitfields.clear();
+	Bookkeeper::vars_with_bitfields_address_taken_cnt = 0;
+	Bookkeeper::bitfields_in_total = 0;
+	Bookkeeper::unamed_bitfields_in_total = 0;
+	Bookkeeper::const_bitfields_in_total = 0;
+	Bookkeeper::volatile_bitfields_in_total = 0;
+	Bookkeeper::lhs_bitfields_structs_vars_cnt = 0;
+	Bookkeeper::rhs_bitfields_structs_vars_cnt = 0;
+	Bookkeeper::lhs_bitfield_cnt = 0;
+	Bookkeeper::rhs_bitfield_cnt = 0;
+	Bookkeeper::forward_jump_cnt = 0;
+	Bookkeeper::backward_jump_cnt = 0;
+	Bookkeeper::use_new_var_cnt = 0;
+	Bookkeeper::use_old_var_cnt = 0;
+	Bookkeeper::stm_visit_cnt = 0;
+	Bookkeeper::stm_shortcut_cnt = 0;
+	Bookkeeper::fixed_point_iteration_cnt = 0;
+	Bookkeeper::analysis_restart_cnt = 0;
+	Bookkeeper::stm_delete_cnt = 0;
+	Bookkeeper::fact_rollback_cnt = 0;
+	Bookkeeper::filter_reject_cnt = 0;
+	Bookkeeper::rely_on_int_size = false;
+	Bookkeeper::rely_on_ptr_size = false;
 }
 
 int 
@@ -163,6 +206,34 @@ Bookkeeper::stat_blk_depths(void)
 	return cnt;
 }
 
+void 
+Bookkeeper::stat_analyses_for_stmt(const Statement* s)
+{
+	size_t i, j; 
+	if (s->eType != eBlock) {
+		incr_counter(stm_analysis_cnts, s->analysis_cnt);
+	}
+	vector<const Block*> blks; 
+	s->get_blocks(blks); 
+	for (i=0; i<blks.size(); i++) {
+		for (j=0; j<blks[i]->stms.size(); j++) {
+			stat_analyses_for_stmt(blks[i]->stms[j]);
+		}
+	}
+}
+
+void 
+Bookkeeper::stat_analyses(void) 
+{
+	const vector<Function*>& funcs = get_all_functions();
+	stm_analysis_cnts.clear();
+	for (size_t i=0; i<funcs.size(); i++) {
+		if (funcs[i]->is_builtin)
+			continue;
+		stat_analyses_for_stmt(funcs[i]->body);
+	}
+}
+
 void
 Bookkeeper::output_stmts_statistics(std::ostream &out)
 {
@@ -194,6 +265,8 @@ Bookkeeper::output_statistics(std::ostream &out)
 	output_stmts_statistics(out);
 	out << endl;
 	output_var_freshness(out);
+	out << endl;
+	output_dfa_statistics(out);
 	if (rely_on_int_size) {
 		out << "FYI: the random generator makes assumptions about the integer size. See ";
 		out << PLATFORM_CONFIG_FILE << " for more details." << endl;
@@ -517,6 +590,32 @@ Bookkeeper::output_jump_statistics(std::ostream &out)
 	formated_output(out, "backward jumps: ", backward_jump_cnt);
 }
 
+void
+Bookkeeper::output_dfa_statistics(std::ostream &out)
+{
+	int stmt_cnt = 0;
+	for (size_t i=0; i<blk_depth_cnts.size(); i++) {
+		stmt_cnt += blk_depth_cnts[i];
+	}
+	formated_output(out, "statements analysed: ", stm_visit_cnt);
+	formated_output(out, "statements reusing previous analysis: ", stm_shortcut_cnt);
+	if (stmt_cnt) {
+		formated_outputf(out, "analyses per statement: ", stm_visit_cnt * 1.0 / stmt_cnt);
+	}
+	stat_analyses();
+	formated_output(out, "max analyses of a statement: ", (stm_analysis_cnts.size() - 1));
+	out << "breakdown:" << endl;
+	for (size_t i=0; i<stm_analysis_cnts.size(); i++) {
+		if (stm_analysis_cnts[i]) {
+			out << "   analyses: " << i << ", occurrence: " << stm_analysis_cnts[i] << endl;
+		}
+	}
+	formated_output(out, "fixed point iterations: ", fixed_point_iteration_cnt);
+	formated_output(out, "block analyses restarted: ", analysis_restart_cnt);
+	formated_output(out, "statements deleted by analysis: ", stm_delete_cnt);
+	formated_output(out, "function revisits rolled back: ", fact_rollback_cnt);
+}
+
 void
 Bookkeeper::output_var_freshness(std::ostream &out)
 {
@@ -67,6 +67,9 @@ int CGOptions::pointer_size_ = 0;
 #define DEFINE_GETTER_SETTER_BOOL(f) \
 	DEFINE_GETTER_SETTER(bool, false, f)
 
+#define DEFINE_THREAD_LOCAL_GETTER_SETTER_BOOL(f) \
+	thread_local DEFINE_GETTER_SETTER(bool, false, f)
+
 #define DEFINE_GETTER_SETTER_INT(f) \
 	DEFINE_GETTER_SETTER(int, 0, f)
 
@@ -109,6 +112,9 @@ DEFINE_GETTER_SETTER_BOOL(random_based)
 DEFINE_GETTER_SETTER_BOOL(dfs_exhaustive)
 DEFINE_GETTER_SETTER_STRING_REF(dfs_debug_sequence)
 DEFINE_GETTER_SETTER_INT (max_exhaustive_depth)
+DEFINE_GETTER_SETTER_INT (dfs_jobs)
+DEFINE_GETTER_SETTER_INT (dfs_split_depth)
+DEFINE_GETTER_SETTER_STRING_REF(dfs_output)
 DEFINE_GETTER_SETTER_BOOL(compact_output)
 DEFINE_GETTER_SETTER_BOOL(msp)
 DEFINE_GETTER_SETTER_INT(func1_max_params)
@@ -129,6 +135,7 @@ DEFINE_GETTER_SETTER_STRING_REF(delta_output)
 DEFINE_GETTER_SETTER_STRING_REF(go_delta)
 DEFINE_GETTER_SETTER_STRING_REF(delta_input)
 DEFINE_GETTER_SETTER_BOOL(no_delta_reduction)
+DEFINE_GETTER_SETTER(RNDNUM_ENGINE, eRand48Engine, rng_engine)
 DEFINE_GETTER_SETTER_BOOL(math64)
 DEFINE_GETTER_SETTER_BOOL(inline_function)
 DEFINE_GETTER_SETTER_BOOL(math_notmp)
@@ -147,7 +154,7 @@ DEFINE_GETTER_SETTER_BOOL(arg_unions)
 DEFINE_GETTER_SETTER_BOOL(volatiles)
 DEFINE_GETTER_SETTER_BOOL(volatile_pointers)
 DEFINE_GETTER_SETTER_BOOL(const_pointers)
-DEFINE_GETTER_SETTER_BOOL(access_once)
+DEFINE_THREAD_LOCAL_GETTER_SETTER_BOOL(access_once)
 DEFINE_GETTER_SETTER_BOOL(strict_volatile_rule)
 DEFINE_GETTER_SETTER_BOOL(addr_taken_of_locals)
 DEFINE_GETTER_SETTER_BOOL(fresh_array_ctrl_var_names)
@@ -168,7 +175,7 @@ DEFINE_GETTER_SETTER_STRING_REF(dump_default_probabilities)
 DEFINE_GETTER_SETTER_STRING_REF(dump_random_probabilities)
 DEFINE_GETTER_SETTER_STRING_REF(probability_configuration)
 DEFINE_GETTER_SETTER_BOOL(const_as_condition)
-DEFINE_GETTER_SETTER_BOOL(match_exact_qualifiers)
+DEFINE_THREAD_LOCAL_GETTER_SETTER_BOOL(match_exact_qualifiers)
 DEFINE_GETTER_SETTER_BOOL(blind_check_global)
 DEFINE_GETTER_SETTER_BOOL(no_return_dead_ptr)
 DEFINE_GETTER_SETTER_BOOL(hash_value_printf)
@@ -176,6 +183,7 @@ DEFINE_GETTER_SETTER_BOOL(signed_char_index)
 DEFINE_GETTER_SETTER_BOOL(empty_blocks)
 DEFINE_GETTER_SETTER_INT (max_array_num_in_loop)
 DEFINE_GETTER_SETTER_BOOL(identify_wrappers)
+DEFINE_GETTER_SETTER_BOOL(reduce_server)
 DEFINE_GETTER_SETTER_BOOL(mark_mutable_const)
 DEFINE_GETTER_SETTER_BOOL(force_globals_static)
 DEFINE_GETTER_SETTER_BOOL(force_non_uniform_array_init)
@@ -222,6 +230,9 @@ CGOptions::set_default_settings(void)
 	max_array_length_per_dimension(CGOPTIONS_DEFAULT_MAX_ARRAY_LENGTH_PER_DIMENSION);
 	max_array_length(CGOPTIONS_DEFAULT_MAX_ARRAY_LENGTH);
 	max_exhaustive_depth(CGOPTIONS_DEFAULT_MAX_EXHAUSTIVE_DEPTH);
+	dfs_jobs(CGOPTIONS_DEFAULT_DFS_JOBS);
+	dfs_split_depth(CGOPTIONS_DEFAULT_DFS_SPLIT_DEPTH);
+	dfs_output("");
 	max_indirect_level(CGOPTIONS_DEFAULT_MAX_INDIRECT_LEVEL);
 	output_file(CGOPTIONS_DEFAULT_OUTPUT_FILE);
 	interested_facts(ePointTo | eUnionWrite);
@@ -248,6 +259,7 @@ CGOptions::set_default_settings(void)
 	prefix_name(false);
 	sequence_name_prefix(false);
 	compatible_check(false);
+	rng_engine(eRand48Engine);
 	compound_assignment(true);
 	math64(true);
 	inline_function(false);
@@ -285,6 +297,7 @@ CGOptions::set_default_settings(void)
 	signed_char_index(true);
 	empty_blocks(true);
 	identify_wrappers(false);
+	reduce_server(false);
 	mark_mutable_const(false);
 	force_globals_static(true);
 	force_non_uniform_array_init(true);
@@ -434,6 +447,29 @@ bool CGOptions::resolve_exhaustive_options()
 		conflict_msg_ = "expand-struct cannot be used with --no-struct";
 		return true;
 	}
+
+	if (CGOptions::dfs_jobs() <= 0) {
+		conflict_msg_ = "dfs-jobs must be at least 1";
+		return true;
+	}
+
+	if (CGOptions::dfs_jobs() > 1) {
+		// Each worker writes the programs of its subtrees to its own file.
+		if (CGOptions::dfs_output().empty()) {
+			conflict_msg_ = "dfs-jobs needs --dfs-output";
+			return true;
+		}
+		if (!CGOptions::dfs_debug_sequence().empty()) {
+			conflict_msg_ = "dfs-jobs cannot be used with --dfs-debug-sequence";
+			return true;
+		}
+		// The numbers of --prefix-name follow the order of the programs,
+		// which the workers don't share.
+		if (CGOptions::prefix_name() && !CGOptions::sequence_name_prefix()) {
+			conflict_msg_ = "dfs-jobs needs --sequence-name-prefix with --prefix-name";
+			return true;
+		}
+	}
 	
 	if (CGOptions::has_extension_support()) {
 		conflict_msg_ = "exhaustive mode doesn't support splat|klee|crest|coverage-test extension";
@@ -543,6 +579,18 @@ CGOptions::has_conflict(void)
 			return true;
 		}
 	}
+
+	if (CGOptions::reduce_server()) {
+		// the configurations come from stdin, and stdout has the replies
+		if (CGOptions::get_reducer()) {
+			conflict_msg_ = "reduce-server cannot be used with --reduce";
+			return true;
+		}
+		if (CGOptions::output_file().empty()) {
+			conflict_msg_ = "reduce-server needs --output";
+			return true;
+		}
+	}
 	
 	if (!CGOptions::delta_monitor().empty()) {
 		string msg;
@@ -34,6 +34,7 @@
 #include <vector>
 #include <map>
 #include "Reducer.h"
+#include "RandomEngine.h"
 using namespace std;
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -59,6 +60,8 @@ using namespace std;
 #define CGOPTIONS_DEFAULT_MAX_ARRAY_LENGTH	(256)
 #define CGOPTIONS_DEFAULT_MAX_ARRAY_NUM_IN_LOOP	(4)
 #define CGOPTIONS_DEFAULT_MAX_EXHAUSTIVE_DEPTH	(-1) 
+#define CGOPTIONS_DEFAULT_DFS_JOBS	(1)
+#define CGOPTIONS_DEFAULT_DFS_SPLIT_DEPTH	(8)
 // 0 means we output to the standard output
 #define CGOPTIONS_DEFAULT_MAX_SPLIT_FILES	(0)
 #define CGOPTIONS_DEFAULT_SPLIT_FILES_DIR	("./output") 
@@ -175,6 +178,15 @@ public:
 	static int max_exhaustive_depth(void);
 	static int max_exhaustive_depth(int p);
 
+	static int dfs_jobs(void);
+	static int dfs_jobs(int p);
+
+	static int dfs_split_depth(void);
+	static int dfs_split_depth(int p);
+
+	static std::string dfs_output(void);
+	static std::string dfs_output(std::string p);
+
 	static bool compact_output(void);
 	static bool compact_output(bool p);
 
@@ -235,6 +247,9 @@ public:
 	static bool no_delta_reduction(void);
 	static bool no_delta_reduction(bool p);
 
+	static RNDNUM_ENGINE rng_engine(void);
+	static RNDNUM_ENGINE rng_engine(RNDNUM_ENGINE p);
+
 	static bool math_notmp(void);
 	static bool math_notmp(bool p);
 
@@ -391,6 +406,9 @@ public:
 	static void init_reducer(std::string fname) { reducer_ = new Reducer(fname);}
 	static Reducer* get_reducer(void) { return reducer_; } 
 
+	static bool reduce_server(void);
+	static bool reduce_server(bool p);
+
 	static bool x86_64();
 
 	static bool identify_wrappers(void);
@@ -518,6 +536,9 @@ private:
 	static bool	dfs_exhaustive_;
 	static std::string dfs_debug_sequence_;
 	static int	max_exhaustive_depth_;
+	static int	dfs_jobs_;
+	static int	dfs_split_depth_;
+	static std::string dfs_output_;
 	static bool	compact_output_;
 	static bool	msp_;
 	static int	func1_max_params_;
@@ -538,6 +559,7 @@ private:
 	static std::string	go_delta_;
 	static std::string	delta_input_;
 	static bool	no_delta_reduction_;
+	static RNDNUM_ENGINE	rng_engine_;
 	static bool	math64_;
 	static bool	inline_function_;
 	static bool	math_notmp_;
@@ -557,7 +579,8 @@ private:
 	static bool	volatile_pointers_;
 	static bool	const_pointers_;
 	static std::string	vol_tests_mach_;
-	static bool	access_once_;
+	// Toggled while generating a program, so kept per thread.
+	static thread_local bool	access_once_;
 	static bool	strict_volatile_rule_;
 	static bool	addr_taken_of_locals_;
 	static bool	fresh_array_ctrl_var_names_;
@@ -581,7 +604,8 @@ private:
 	static std::string	probability_configuration_;
 
 	static std::string conflict_msg_;
-	static bool match_exact_qualifiers_;
+	// Toggled while generating a program, so kept per thread.
+	static thread_local bool match_exact_qualifiers_;
 
 	static int max_array_num_in_loop_;
 	static bool identify_wrappers_;
@@ -607,6 +631,7 @@ private:
 	static bool take_union_field_addr_;
 	static bool vol_struct_union_fields_;
 	static Reducer* reducer_; 
+	static bool reduce_server_;
 
 	// flag to indicate language
 	static bool lang_cpp_;
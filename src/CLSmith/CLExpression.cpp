@@ -15,7 +15,7 @@ class CVQualifiers;
 
 namespace CLSmith {
 namespace {
-DistributionTable *cl_expr_table = NULL;
+thread_local DistributionTable *cl_expr_table = NULL;
 }  // namespace
 
 /*CL*/Expression *CLExpression::make_random(CGContext &cg_context, const Type *type,
@@ -80,6 +80,12 @@ void CLExpression::InitProbabilityTable() {
   ExpressionVector::InitProbabilityTable();
 }
 
+void CLExpression::ReleaseProbabilityTable() {
+  delete cl_expr_table;
+  cl_expr_table = NULL;
+  ExpressionVector::ReleaseProbabilityTable();
+}
+
 Expression *make_random(CGContext &cg_context, const Type *type,
     const CVQualifiers *qfer) {
   return CLExpression::make_random(cg_context, type, qfer, CLExpression::kNone);
@@ -45,6 +45,10 @@ class CLExpression : public Expression {
   // Create the random probability table, should be called once on startup.
   static void InitProbabilityTable();
 
+  // Destroy the probability tables built by InitProbabilityTable, so that they
+  // can be rebuilt for another program.
+  static void ReleaseProbabilityTable();
+
   // When evaluated at runtime, will this produce a divergent value.
   virtual bool IsDivergent() const { return false; }//; = 0;
   
@@ -14,6 +14,7 @@ namespace CLSmith {
 DEFINE_CLFLAG(atomic_reductions, bool, false)
 DEFINE_CLFLAG(atomics, bool, false)
 DEFINE_CLFLAG(barriers, bool, false)
+DEFINE_CLFLAG(digest, bool, false)
 DEFINE_CLFLAG(divergence, bool, false)
 DEFINE_CLFLAG(embedded, bool, false)
 DEFINE_CLFLAG(emi, bool, false)
@@ -35,6 +36,7 @@ void CLOptions::set_default_settings() {
   atomic_reductions_ = false;
   atomics_ = false;
   barriers_ = false;
+  digest_ = false;
   divergence_ = false;
   embedded_ = false;
   emi_ = false;
@@ -20,6 +20,7 @@ class CLOptions {
   DEFINE_CLFLAG(atomic_reductions, bool)
   DEFINE_CLFLAG(atomics, bool)
   DEFINE_CLFLAG(barriers, bool)
+  DEFINE_CLFLAG(digest, bool)
   DEFINE_CLFLAG(divergence, bool)
   DEFINE_CLFLAG(embedded, bool)
   DEFINE_CLFLAG(emi, bool)
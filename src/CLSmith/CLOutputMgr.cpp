@@ -2,6 +2,7 @@
 
 #include <cstdio>
 #include <fstream>
+#include <iostream>
 #include <sstream>
 
 #include "CLSmith/CLOptions.h"
@@ -18,8 +19,46 @@
 #include "VariableSelector.h"
 
 namespace CLSmith {
+namespace {
+// Room reserved for the program up front, enough for most programs.
+const size_t kInitialProgramSize = 1 << 20;
+}  // namespace
 
-CLOutputMgr::CLOutputMgr() : out_(CLOptions::output()) {
+CLOutputMgr::CLOutputMgr() : CLOutputMgr(CLOptions::output()) {
+}
+
+CLOutputMgr::CLOutputMgr(const char *filename)
+    : CLOutputMgr(std::string(filename)) {
+}
+
+CLOutputMgr::CLOutputMgr(const std::string& filename)
+    : filename_(filename), buffer_(&text_), out_(&buffer_) {
+  text_.reserve(kInitialProgramSize);
+}
+
+CLOutputMgr::StringBuffer::int_type CLOutputMgr::StringBuffer::overflow(
+    int_type c) {
+  if (!traits_type::eq_int_type(c, traits_type::eof()))
+    text_->push_back(traits_type::to_char_type(c));
+  return traits_type::not_eof(c);
+}
+
+std::streamsize CLOutputMgr::StringBuffer::xsputn(
+    const char *s, std::streamsize n) {
+  text_->append(s, n);
+  return n;
+}
+
+void CLOutputMgr::WriteProgram() {
+  if (filename_ == "-") {
+    std::cout.write(text_.data(), text_.size());
+    std::cout.flush();
+  } else {
+    std::ofstream file(filename_.c_str(), std::ios::binary);
+    file.write(text_.data(), text_.size());
+    if (!file) std::cerr << "error: can't write " << filename_ << std::endl;
+  }
+  text_.clear();
 }
 
 void CLOutputMgr::OutputRuntimeInfo(
@@ -37,6 +76,8 @@ void CLOutputMgr::OutputRuntimeInfo(
     out << " ---inter_thread_comm";
   if (CLOptions::emi())
     out << " ---emi";
+  if (CLOptions::digest())
+    out << " ---digest";
   out << " -g ";
   for (std::vector<unsigned int>::const_iterator it = global_dims.begin();
       it < global_dims.end(); it++) {
@@ -134,6 +175,7 @@ void CLOutputMgr::Output() {
   OutputForwardDeclarations(out);
   OutputFunctions(out);
   OutputEntryFunction(*globals);
+  WriteProgram();
 }
 
 std::ostream& CLOutputMgr::get_main_out() {
@@ -158,6 +200,8 @@ void CLOutputMgr::OutputEntryFunction(Globals& globals) {
     out << ", __global int *sequence_input";
   if (CLOptions::inter_thread_comm())
     out << ", __global long *g_comm_values";
+  if (CLOptions::digest())
+    out << ", __global volatile uint *digest";
   out << ") {" << std::endl;
   globals.OutputArrayControlVars(out);
   globals.OutputBufferInits(out);
@@ -195,6 +239,13 @@ void CLOutputMgr::OutputEntryFunction(Globals& globals) {
   output_tab(out, 1);
   out << "result[get_linear_global_id()] = crc64_context ^ 0xFFFFFFFFFFFFFFFFUL;"
       << std::endl;
+  // Also add the hash to the digests of the work-group and of the whole range,
+  // so that the launcher can report them rather than every hash.
+  if (CLOptions::digest()) {
+    output_tab(out, 1);
+    out << "add_to_digest(digest, crc64_context ^ 0xFFFFFFFFFFFFFFFFUL);"
+        << std::endl;
+  }
   out << "}" << std::endl;
 }
 
@@ -3,11 +3,14 @@
 // Relies on the caller to disable parts of the program that produce invalid
 // OpenCL C, as this class will call the output function of the standard csmith
 // output managers.
+// The program is built up in memory and written to the file in one go once it
+// is complete. A file name of "-" writes it to stdout instead.
 
 #ifndef _CLSMITH_CLOUTPUTMGR_H_
 #define _CLSMITH_CLOUTPUTMGR_H_
 
-#include <fstream>
+#include <ostream>
+#include <streambuf>
 #include <string>
 
 #include "CommonMacros.h"
@@ -20,9 +23,8 @@ class Globals;
 class CLOutputMgr : public OutputMgr {
  public:
   CLOutputMgr();
-  explicit CLOutputMgr(const std::string& filename) : out_(filename.c_str()) {}
-  explicit CLOutputMgr(const char *filename) : out_(filename) {}
-  ~CLOutputMgr() { out_.close(); }
+  explicit CLOutputMgr(const std::string& filename);
+  explicit CLOutputMgr(const char *filename);
   
   // Outputs information regarding the runtime to be read by the host code
   void OutputRuntimeInfo(const std::vector<unsigned int>& threads,
@@ -32,7 +34,8 @@ class CLOutputMgr : public OutputMgr {
   // declarations.
   void OutputHeader(int argc, char *argv[], unsigned long seed);
 
-  // Inherited from OutputMgr. Outputs all the definitions.
+  // Inherited from OutputMgr. Outputs all the definitions, then writes the
+  // whole program to the file.
   void Output();
 
   // Inherited from OutputMgr. Gets the stream used for printing the output.
@@ -43,7 +46,26 @@ class CLOutputMgr : public OutputMgr {
   void OutputEntryFunction(Globals& globals);
 
  private:
-  std::ofstream out_;
+  // Appends everything written to it to a string.
+  class StringBuffer : public std::streambuf {
+   public:
+    explicit StringBuffer(std::string *text) : text_(text) {}
+
+   protected:
+    int_type overflow(int_type c);
+    std::streamsize xsputn(const char *s, std::streamsize n);
+
+   private:
+    std::string *text_;
+  };
+
+  // Writes the program built up so far to the file, or stdout.
+  void WriteProgram();
+
+  const std::string filename_;
+  std::string text_;
+  StringBuffer buffer_;
+  std::ostream out_;
 
   DISALLOW_COPY_AND_ASSIGN(CLOutputMgr);
 };
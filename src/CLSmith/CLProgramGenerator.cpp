@@ -1,6 +1,7 @@
 #include "CLSmith/CLProgramGenerator.h"
 
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <memory>
 #include <string>
@@ -13,6 +14,7 @@
 #include "CLSmith/ExpressionAtomic.h"
 #include "ExpressionID.h"
 #include "CLSmith/FunctionInvocationBuiltIn.h"
+#include "CLSmith/GenerationContext.h"
 #include "CLSmith/StatementAtomicResult.h"
 #include "CLSmith/Globals.h"
 #include "CLSmith/StatementAtomicReduction.h"
@@ -20,8 +22,12 @@
 #include "CLSmith/StatementComm.h"
 #include "CLSmith/StatementEMI.h"
 #include "CLSmith/StatementMessage.h"
+#include "CLSmith/UseDefIndex.h"
 #include "CLSmith/Vector.h"
+#include "AbsRndNumGenerator.h"
+#include "Bookkeeper.h"
 #include "Function.h"
+#include "RandomNumber.h"
 #include "Type.h"
 
 class OutputMgr;
@@ -32,50 +38,100 @@ static const unsigned int max_threads = 10000;
 static const unsigned int max_thr_per_dim = 100;
 static const unsigned int max_threads_per_group = 256;
 static const unsigned int no_dims = 3;
-static unsigned int noThreads = 1;
-static unsigned int noGroups = 1;
-static std::vector<unsigned int> *globalDim;
-static std::vector<unsigned int> *localDim;
+
+// The runtime parameters are kept in the current generation context.
+GenerationContext::RuntimeParameters *GetRuntimeParameters() {
+  return GenerationContext::GetCurrent()->GetRuntimeParameters();
+}
+
+// Adds the time spent in its scope to a phase of the generation statistics.
+class PhaseTimer {
+ public:
+  explicit PhaseTimer(GenerationContext::Statistics::Phase phase)
+      : phase_(phase), start_(std::chrono::steady_clock::now()) {}
+  ~PhaseTimer() {
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start_;
+    GenerationContext::GetCurrent()->GetStatistics()->phase_seconds[phase_] +=
+        elapsed.count();
+  }
+
+ private:
+  const GenerationContext::Statistics::Phase phase_;
+  const std::chrono::steady_clock::time_point start_;
+
+  DISALLOW_COPY_AND_ASSIGN(PhaseTimer);
+};
 }  // namespace
 
 void CLProgramGenerator::goGenerator() {
-  // Initialise probabilies.
-  CLExpression::InitProbabilityTable();
-  CLStatement::InitProbabilityTable();
-  // Create vector types.
-  Vector::GenerateVectorTypes();
-  // Initialise function tables.
-  FunctionInvocationBuiltIn::InitTables();
-  // Initialise Variable objects used for thread identifiers.
-  ExpressionID::Initialise();
-  // Initialize runtime parameters;
-  InitRuntimeParameters();
-  // Initalize atomic parameters
-  if (CLOptions::atomics())
-    ExpressionAtomic::InitAtomics();
-  // Initialise buffers used for inter-thread communication.
-  StatementComm::InitBuffers();
-  // Initialise Message Passing data.
-  MessagePassing::Initialise();
+  typedef GenerationContext::Statistics Statistics;
+  Statistics *stats = GenerationContext::GetCurrent()->GetStatistics();
+  {
+    PhaseTimer timer(Statistics::kTables);
+    // Initialise probabilies.
+    CLExpression::InitProbabilityTable();
+    CLStatement::InitProbabilityTable();
+    // Create vector types.
+    Vector::GenerateVectorTypes();
+    // Initialise function tables.
+    FunctionInvocationBuiltIn::InitTables();
+    // Initialise Variable objects used for thread identifiers.
+    ExpressionID::Initialise();
+  }
+  {
+    // Initialize runtime parameters;
+    PhaseTimer timer(Statistics::kRuntimeParameters);
+    InitRuntimeParameters();
+  }
+  {
+    PhaseTimer timer(Statistics::kTables);
+    // Initalize atomic parameters
+    if (CLOptions::atomics())
+      ExpressionAtomic::InitAtomics();
+    // Initialise buffers used for inter-thread communication.
+    StatementComm::InitBuffers();
+    // Initialise Message Passing data.
+    MessagePassing::Initialise();
+  }
 
-  // Expects argc, argv and seed. These vars should really be in the output_mgr.
-  output_mgr_->OutputHeader(0, NULL, seed_);
+  {
+    // Expects argc, argv and seed. These vars should really be in the
+    // output_mgr.
+    PhaseTimer timer(Statistics::kOutput);
+    output_mgr_->OutputHeader(0, NULL, seed_);
+  }
 
   // This creates the random program, the rest handles post-processing and
   // outputting the program.
-  GenerateAllTypes();
-  GenerateFunctions();
+  {
+    PhaseTimer timer(Statistics::kTypes);
+    GenerateAllTypes();
+  }
+  {
+    PhaseTimer timer(Statistics::kFunctions);
+    GenerateFunctions();
+  }
+
+  // The later passes that need to know where variables are used share an
+  // index, kept up to date as statements are removed.
+  if (CLOptions::small()) UseDefIndex::BuildUseDefIndex();
 
   // If tracking divergence is set, perform the tracking now.
   std::unique_ptr<Divergence> div;
   if (CLOptions::track_divergence()) {
+    PhaseTimer timer(Statistics::kDivergence);
     div.reset(new Divergence());
     div->ProcessEntryFunction(GetFirstFunction());
+    stats->divergence_function_runs = div->GetFunctionRuns();
+    stats->divergence_summaries_reused = div->GetSummariesReused();
   }
 
   // If EMI block generation is set, prune them.
-  if (CLOptions::emi())
+  if (CLOptions::emi()) {
+    PhaseTimer timer(Statistics::kEMIPruning);
     EMIController::GetEMIController()->PruneEMISections();
+  }
 
   // If atomic blocks are generated, add operations for the special values
   if (CLOptions::atomics())
@@ -86,8 +142,10 @@ void CLProgramGenerator::goGenerator() {
     StatementAtomicReduction::RecordBuffer();
 
   // If Message Passing is enabled, create orderings and message updates.
-  if (CLOptions::message_passing())
+  if (CLOptions::message_passing()) {
+    PhaseTimer timer(Statistics::kMessageOrderings);
     MessagePassing::CreateMessageOrderings();
+  }
 
   // At this point, all the global variables that have been created throughout
   // program generation should have been created. Any global variables added to
@@ -125,6 +183,7 @@ void CLProgramGenerator::goGenerator() {
 
   // If barriers have been set, use the divergence information to place them.
   if (CLOptions::barriers()) {
+    PhaseTimer timer(Statistics::kBarriers);
     if (CLOptions::divergence()) GenerateBarriers(div.get(), globals);
     else { /*TODO Non-div barriers*/ }
   }
@@ -132,19 +191,37 @@ void CLProgramGenerator::goGenerator() {
   if (CLOptions::small())
     CLSmith::CLVariable::ParseUnusedVars();
 
-  // Output the whole program.
-  output_mgr_->Output();
+  {
+    // Output the whole program.
+    PhaseTimer timer(Statistics::kOutput);
+    output_mgr_->Output();
+  }
+
+  // The counters kept by csmith, which are reset with the context.
+  stats->random_draws = RandomNumber::GetRndNumGenerator()->get_draw_count();
+  stats->filter_rejections = Bookkeeper::filter_reject_cnt;
+  stats->fixed_point_iterations = Bookkeeper::fixed_point_iteration_cnt;
+  stats->statements_deleted = Bookkeeper::stm_delete_cnt;
+  Bookkeeper::stat_analyses();
+  stats->statement_analyses.assign(Bookkeeper::stm_analysis_cnts.begin(),
+      Bookkeeper::stm_analysis_cnts.end());
 
   // Release any singleton instances used.
   Globals::ReleaseGlobals();
   EMIController::ReleaseEMIController();
+  UseDefIndex::ReleaseUseDefIndex();
 }
 
 void CLProgramGenerator::InitRuntimeParameters() {
-  globalDim = new std::vector<unsigned int>(no_dims, 1);
-  localDim = new std::vector<unsigned int>(no_dims, 1);
-  std::vector<unsigned int>& globalDim = *CLSmith::globalDim;
-  std::vector<unsigned int>& localDim = *CLSmith::localDim;
+  GenerationContext::RuntimeParameters *params = GetRuntimeParameters();
+  params->global_dims.assign(no_dims, 1);
+  params->local_dims.assign(no_dims, 1);
+  params->threads = 1;
+  params->groups = 1;
+  std::vector<unsigned int>& globalDim = params->global_dims;
+  std::vector<unsigned int>& localDim = params->local_dims;
+  unsigned int& noThreads = params->threads;
+  unsigned int& noGroups = params->groups;
   std::vector<unsigned int> chosen_div;
   std::vector<unsigned int> divisors;
   for (unsigned int i = 0; i < no_dims; i++) {
@@ -174,27 +251,27 @@ std::string CLProgramGenerator::get_count_prefix(const std::string& name) {
 }
 
 const unsigned int CLProgramGenerator::get_threads() {
-  return noThreads;
+  return GetRuntimeParameters()->threads;
 }
 
 const unsigned int CLProgramGenerator::get_groups() {
-  return noGroups;
+  return GetRuntimeParameters()->groups;
 }
 
 const unsigned int CLProgramGenerator::get_total_threads() {
-  return noThreads * noGroups;
+  return get_threads() * get_groups();
 }
 
 const unsigned int CLProgramGenerator::get_threads_per_group() {
-  return noThreads / noGroups;
+  return get_threads() / get_groups();
 }
 
 const std::vector<unsigned int>& CLProgramGenerator::get_global_dims() {
-  return *globalDim;
+  return GetRuntimeParameters()->global_dims;
 }
 
 const std::vector<unsigned int>& CLProgramGenerator::get_local_dims() {
-  return *localDim;
+  return GetRuntimeParameters()->local_dims;
 }
 
 const unsigned int CLProgramGenerator::get_atomic_blocks_no() {
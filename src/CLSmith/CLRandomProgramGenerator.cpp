@@ -1,19 +1,62 @@
 // Entry point to the program.
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "AbsProgramGenerator.h"
+#include "AbsRndNumGenerator.h"
 #include "CGOptions.h"
+#include "CLSmith/ChoiceReducer.h"
 #include "CLSmith/CLOptions.h"
 #include "CLSmith/CLOutputMgr.h"
 #include "CLSmith/CLProgramGenerator.h"
+#include "CLSmith/GenerationContext.h"
+#include "RandomEngine.h"
+#include "RandomNumber.h"
 #include "platform.h"
 
 // Generator seed.
 static unsigned long g_Seed = 0;
+// Number of programs to generate in batch mode, 0 if not in batch mode.
+static unsigned long g_Count = 0;
+// First seed used in batch mode, defaults to the generator seed.
+static unsigned long g_SeedStart = 0;
+static bool g_SeedStartSet = false;
+// Number of threads generating programs in batch mode.
+static unsigned long g_Jobs = 1;
+// Interestingness command the program of the seed is reduced with, empty if
+// not reducing.
+static std::string g_ReduceCommand;
+// Number of draws per engine and round for the random number generator
+// benchmark, 0 if not benchmarking.
+static unsigned long g_RngBenchmark = 0;
+// Whether to report the memory used by each program generated.
+static bool g_MemoryStats = false;
+// Whether to report the time taken by the analyses of each program generated.
+static bool g_Stats = false;
+// File the statistics of each program generated are written to, one JSON
+// record per line, or NULL.
+static std::unique_ptr<std::ofstream> g_StatsJson;
+// Whether to write the features of each program generated next to it.
+static bool g_Features = false;
+// The command line, recorded with the statistics.
+static std::string g_CommandLine;
+// Keeps the reports of several jobs from being interleaved.
+static std::mutex g_ReportMutex;
 
 bool CheckArgExists(int idx, int argc) {
   if (idx >= argc) std::cout << "Expected another argument" << std::endl;
@@ -26,11 +69,237 @@ bool ParseIntArg(const char *arg, unsigned long *value) {
   return res;
 }
 
+// Where the reports on each program go. stdout, unless the program itself is
+// written there.
+std::ostream& ReportStream() {
+  return strcmp(CLSmith::CLOptions::output(), "-") ? std::cout : std::cerr;
+}
+
+// In batch mode, each program is written to the output file name with the seed
+// inserted before the extension, e.g. CLProg.c -> CLProg_42.c.
+std::string BatchOutputFilename(unsigned long seed) {
+  std::string filename(CLSmith::CLOptions::output());
+  size_t dot = filename.find_last_of('.');
+  size_t slash = filename.find_last_of('/');
+  if (dot == std::string::npos ||
+      (slash != std::string::npos && dot < slash)) dot = filename.size();
+  return filename.substr(0, dot) + '_' + std::to_string(seed) +
+      filename.substr(dot);
+}
+
+// The features of a program are written next to it, with its extension
+// replaced, e.g. CLProg_42.c -> CLProg_42.features.json.
+std::string FeaturesFilename(const std::string& filename) {
+  size_t dot = filename.find_last_of('.');
+  size_t slash = filename.find_last_of('/');
+  if (dot == std::string::npos ||
+      (slash != std::string::npos && dot < slash)) dot = filename.size();
+  return filename.substr(0, dot) + ".features.json";
+}
+
+// Quotes a string for JSON.
+std::string JsonString(const std::string& str) {
+  std::string quoted = "\"";
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escape[8];
+      snprintf(escape, sizeof(escape), "\\u%04x", c);
+      quoted += escape;
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + '"';
+}
+
+// Writes the statistics of a program as one JSON record, e.g.
+//   {"seed": 1, "generation_ms": 52.1, "phases_ms": {"tables": 0.3, ...},
+//    "random_draws": 81234, ..., "peak_rss_kb": 20480}
+void WriteStatsJson(std::ostream& out, unsigned long seed,
+    double generation_seconds,
+    const CLSmith::GenerationContext::Statistics& stats, const Arena& arena) {
+  typedef CLSmith::GenerationContext::Statistics Statistics;
+  out << "{\"seed\": " << seed
+      << ", \"command_line\": " << JsonString(g_CommandLine)
+      << ", \"generation_ms\": " << generation_seconds * 1000
+      << ", \"phases_ms\": {";
+  for (int phase = 0; phase < Statistics::kPhaseCount; ++phase) {
+    if (phase) out << ", ";
+    out << '"'
+        << Statistics::GetPhaseName(static_cast<Statistics::Phase>(phase))
+        << "\": " << stats.phase_seconds[phase] * 1000;
+  }
+  out << "}, \"random_draws\": " << stats.random_draws
+      << ", \"filter_rejections\": " << stats.filter_rejections
+      << ", \"fixed_point_iterations\": " << stats.fixed_point_iterations
+      << ", \"statements_deleted\": " << stats.statements_deleted
+      << ", \"statement_analyses\": [";
+  for (size_t i = 0; i < stats.statement_analyses.size(); ++i)
+    out << (i ? ", " : "") << stats.statement_analyses[i];
+  out << "]"
+      << ", \"divergence_function_runs\": " << stats.divergence_function_runs
+      << ", \"divergence_summaries_reused\": "
+      << stats.divergence_summaries_reused
+      << ", \"arena_objects\": " << arena.get_object_count()
+      << ", \"arena_peak_kb\": " << arena.get_peak_bytes() / 1024
+      << ", \"peak_rss_kb\": " << platform_peak_rss_kb() << "}" << std::endl;
+}
+
+// Writes a map of counts as a JSON object.
+template <typename Key>
+void WriteJsonCounts(std::ostream& out,
+    const std::map<Key, unsigned long>& counts) {
+  out << '{';
+  for (auto it = counts.begin(); it != counts.end(); ++it) {
+    if (it != counts.begin()) out << ", ";
+    std::ostringstream key;
+    key << it->first;
+    out << JsonString(key.str()) << ": " << it->second;
+  }
+  out << '}';
+}
+
+// Writes the features of a program as one JSON record, e.g.
+//   {"seed": 1, "global_size": [4, 20, 1], "local_size": [2, 5, 1],
+//    "statements": {"assign": 12, "barrier": 2, ...}, "built_ins": {...},
+//    "vector_widths": {"4": 3}, "memory_buffers": {"local": 1},
+//    "max_block_depth": 3, "max_expr_depth": 7}
+void WriteFeaturesJson(std::ostream& out, unsigned long seed,
+    const CLSmith::GenerationContext::RuntimeParameters& params,
+    const CLSmith::GenerationContext::Features& features) {
+  out << "{\"seed\": " << seed << ", \"global_size\": [";
+  for (size_t dim = 0; dim < params.global_dims.size(); ++dim)
+    out << (dim ? ", " : "") << params.global_dims[dim];
+  out << "], \"local_size\": [";
+  for (size_t dim = 0; dim < params.local_dims.size(); ++dim)
+    out << (dim ? ", " : "") << params.local_dims[dim];
+  out << "], \"statements\": ";
+  WriteJsonCounts(out, features.statements);
+  out << ", \"built_ins\": ";
+  WriteJsonCounts(out, features.built_ins);
+  out << ", \"vector_widths\": ";
+  WriteJsonCounts(out, features.vector_widths);
+  out << ", \"memory_buffers\": ";
+  WriteJsonCounts(out, features.memory_buffers);
+  out << ", \"max_block_depth\": " << features.max_block_depth
+      << ", \"max_expr_depth\": " << features.max_expr_depth << "}"
+      << std::endl;
+}
+
+// Generates a single program from the given seed into the given file, using a
+// fresh context.
+bool GenerateProgram(int argc, char **argv, unsigned long seed,
+    const std::string& filename) {
+  auto start = std::chrono::steady_clock::now();
+  // The context does the csmith initialisation, and its destruction calls
+  // Finalization::doFinalization(), which deletes everything, so it must
+  // outlive the program generator.
+  std::unique_ptr<CLSmith::GenerationContext> context(
+      CLSmith::GenerationContext::CreateGenerationContext(argc, argv, seed));
+  if (!context) {
+    std::cout << "error: can't create AbsProgramGenerator. csmith init failed!"
+              << std::endl;
+    return false;
+  }
+
+  // Start the peak resident size from here, so that it is that of this program.
+  if (g_MemoryStats || g_StatsJson) platform_reset_peak_rss();
+
+  // Now create our program generator for OpenCL.
+  CLSmith::CLProgramGenerator cl_generator(
+      seed, new CLSmith::CLOutputMgr(filename));
+  cl_generator.goGenerator();
+
+  if (g_MemoryStats) {
+    // The peak resident size is for the whole process, so with several jobs it
+    // includes the programs generated at the same time on other threads.
+    const Arena& arena = context->GetArena();
+    std::lock_guard<std::mutex> lock(g_ReportMutex);
+    ReportStream() << "memory: seed " << seed
+        << " arena_kb " << arena.get_reserved_bytes() / 1024
+        << " live_peak_kb " << arena.get_peak_bytes() / 1024
+        << " objects " << arena.get_object_count()
+        << " peak_rss_kb " << platform_peak_rss_kb() << std::endl;
+  }
+  if (g_Stats) {
+    const CLSmith::GenerationContext::Statistics& stats =
+        *context->GetStatistics();
+    std::lock_guard<std::mutex> lock(g_ReportMutex);
+    ReportStream() << "stats: seed " << seed
+        << " divergence_ms " << stats.phase_seconds[
+            CLSmith::GenerationContext::Statistics::kDivergence] * 1000
+        << " divergence_function_runs " << stats.divergence_function_runs
+        << " divergence_summaries_reused "
+        << stats.divergence_summaries_reused << std::endl;
+  }
+  if (g_Features) {
+    const std::string features_filename = FeaturesFilename(filename);
+    std::ofstream out(features_filename.c_str());
+    WriteFeaturesJson(out, seed, *context->GetRuntimeParameters(),
+        context->GetFeatures());
+    if (!out) {
+      std::cout << "error: can't write " << features_filename << std::endl;
+      return false;
+    }
+  }
+  if (g_StatsJson) {
+    // The time includes creating the context, but not deleting it.
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::lock_guard<std::mutex> lock(g_ReportMutex);
+    WriteStatsJson(*g_StatsJson, seed, elapsed.count(),
+        *context->GetStatistics(), context->GetArena());
+  }
+  return true;
+}
+
+// Measures how many numbers DefaultRndNumGenerator::rnd_upto() draws per
+// second under each engine, with csmith set up as for generating a program.
+// The engines take turns over several rounds and the best round of each is
+// reported, so that one slow spell on a busy machine doesn't decide it.
+bool RunRngBenchmark(int argc, char **argv) {
+  const int rounds = 5;
+  const RNDNUM_ENGINE selected = CGOptions::rng_engine();
+  double best[MAX_RNDNUM_ENGINE] = {};
+  // Summed and printed, so the draws can't be optimised away.
+  unsigned long sum[MAX_RNDNUM_ENGINE] = {};
+  for (int round = 0; round < rounds; ++round) {
+    for (int i = 0; i < MAX_RNDNUM_ENGINE; ++i) {
+      RNDNUM_ENGINE engine = static_cast<RNDNUM_ENGINE>(i);
+      CGOptions::rng_engine(engine);
+      std::unique_ptr<CLSmith::GenerationContext> context(
+          CLSmith::GenerationContext::CreateGenerationContext(argc, argv,
+              g_Seed));
+      if (!context) return false;
+      AbsRndNumGenerator *generator = RandomNumber::GetRndNumGenerator();
+      auto start = std::chrono::steady_clock::now();
+      for (unsigned long draw = 0; draw < g_RngBenchmark; ++draw)
+        sum[i] += generator->rnd_upto(draw % 100 + 1);
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      best[i] = std::max(best[i], g_RngBenchmark / elapsed.count());
+    }
+  }
+  for (int i = 0; i < MAX_RNDNUM_ENGINE; ++i)
+    std::cout << RandomEngine::get_name(static_cast<RNDNUM_ENGINE>(i)) << ": "
+              << static_cast<unsigned long>(best[i])
+              << " draws/s (sum " << sum[i] << ")" << std::endl;
+  CGOptions::rng_engine(selected);
+  return true;
+}
+
 int main(int argc, char **argv) {
   g_Seed = platform_gen_seed();
   CGOptions::set_default_settings();
   CLSmith::CLOptions::set_default_settings();
   std::string output_filename = "";
+  for (int idx = 1; idx < argc; ++idx) {
+    if (idx > 1) g_CommandLine += ' ';
+    g_CommandLine += argv[idx];
+  }
 
   // Parse command line arguments.
   for (int idx = 1; idx < argc; ++idx) {
@@ -42,6 +311,82 @@ int main(int argc, char **argv) {
       continue;
     }
 
+    if (!strcmp(argv[idx], "--count")) {
+      ++idx;
+      if (!CheckArgExists(idx, argc)) return -1;
+      if (!ParseIntArg(argv[idx], &g_Count)) return -1;
+      continue;
+    }
+
+    if (!strcmp(argv[idx], "--seed-start")) {
+      ++idx;
+      if (!CheckArgExists(idx, argc)) return -1;
+      if (!ParseIntArg(argv[idx], &g_SeedStart)) return -1;
+      g_SeedStartSet = true;
+      continue;
+    }
+
+    if (!strcmp(argv[idx], "--jobs") ||
+        !strcmp(argv[idx], "-j")) {
+      ++idx;
+      if (!CheckArgExists(idx, argc)) return -1;
+      if (!ParseIntArg(argv[idx], &g_Jobs)) return -1;
+      continue;
+    }
+
+    if (!strcmp(argv[idx], "--reduce")) {
+      ++idx;
+      if (!CheckArgExists(idx, argc)) return -1;
+      g_ReduceCommand = argv[idx];
+      continue;
+    }
+
+    if (!strcmp(argv[idx], "--rng_engine")) {
+      ++idx;
+      if (!CheckArgExists(idx, argc)) return -1;
+      RNDNUM_ENGINE engine;
+      if (!RandomEngine::find_engine(argv[idx], engine)) {
+        std::cout << "Expected one of rand48, xoshiro256ss or pcg64 for "
+                  << argv[idx - 1] << std::endl;
+        return -1;
+      }
+      CGOptions::rng_engine(engine);
+      continue;
+    }
+
+    if (!strcmp(argv[idx], "--rng_benchmark")) {
+      ++idx;
+      if (!CheckArgExists(idx, argc)) return -1;
+      if (!ParseIntArg(argv[idx], &g_RngBenchmark)) return -1;
+      continue;
+    }
+
+    if (!strcmp(argv[idx], "--memory-stats")) {
+      g_MemoryStats = true;
+      continue;
+    }
+
+    if (!strcmp(argv[idx], "--stats")) {
+      g_Stats = true;
+      continue;
+    }
+
+    if (!strcmp(argv[idx], "--stats-json")) {
+      ++idx;
+      if (!CheckArgExists(idx, argc)) return -1;
+      g_StatsJson.reset(new std::ofstream(argv[idx]));
+      if (!*g_StatsJson) {
+        std::cout << "Can't open " << argv[idx] << " for writing" << std::endl;
+        return -1;
+      }
+      continue;
+    }
+
+    if (!strcmp(argv[idx], "--features")) {
+      g_Features = true;
+      continue;
+    }
+
     if (!strcmp(argv[idx], "--no-arrays")) {
       CGOptions::arrays(false);
       continue;
@@ -68,6 +413,11 @@ int main(int argc, char **argv) {
       continue;
     }
 
+    if (!strcmp(argv[idx], "--digest")) {
+      CLSmith::CLOptions::digest(true);
+      continue;
+    }
+
     if (!strcmp(argv[idx], "--divergence")) {
       CLSmith::CLOptions::divergence(true);
       continue;
@@ -169,23 +519,73 @@ int main(int argc, char **argv) {
   // Check for conflicting options
   if (CLSmith::CLOptions::Conflict()) return -1;
 
-  // AbsProgramGenerator does other initialisation stuff, besides itself. So we
-  // call it, disregarding the returned object. Still need to delete it.
-  AbsProgramGenerator *generator =
-      AbsProgramGenerator::CreateInstance(argc, argv, g_Seed);
-  if (!generator) {
-    cout << "error: can't create AbsProgramGenerator. csmith init failed!"
-         << std::endl;
+  if (g_Jobs == 0 || (g_Jobs > 1 && !g_Count && g_ReduceCommand.empty())) {
+    std::cout << "--jobs must be at least 1, and needs --count or --reduce"
+              << std::endl;
     return -1;
   }
 
-  // Now create our program generator for OpenCL.
-  CLSmith::CLProgramGenerator cl_generator(g_Seed);
-  cl_generator.goGenerator();
+  if (!g_ReduceCommand.empty() &&
+      (g_Count || !strcmp(CLSmith::CLOptions::output(), "-"))) {
+    std::cout << "--reduce needs an output file, not stdout, and no --count"
+              << std::endl;
+    return -1;
+  }
 
-  // Calls Finalization::doFinalization(), which deletes everything, so must be
-  // called after program generation.
-  delete generator;
+  if (g_Features &&
+      (!g_ReduceCommand.empty() || !strcmp(CLSmith::CLOptions::output(), "-"))) {
+    std::cout << "--features needs an output file, not stdout, and no --reduce"
+              << std::endl;
+    return -1;
+  }
+
+  if (g_Count && !strcmp(CLSmith::CLOptions::output(), "-")) {
+    std::cout << "--count needs an output file, not stdout" << std::endl;
+    return -1;
+  }
+
+  if (g_RngBenchmark) return RunRngBenchmark(argc, argv) ? 0 : -1;
+
+  if (!g_ReduceCommand.empty()) {
+    CLSmith::ChoiceReducer reducer(argc, argv, g_Seed, g_ReduceCommand,
+        CLSmith::CLOptions::output(), g_Jobs);
+    return reducer.Reduce() ? 0 : -1;
+  }
+
+  if (!g_Count) {
+    return GenerateProgram(argc, argv, g_Seed, CLSmith::CLOptions::output()) ?
+        0 : -1;
+  }
+
+  // Batch mode, all the programs are generated in this process, each with its
+  // own context. With several jobs, the seeds are handed out to the threads in
+  // order, and each thread has its own copy of the generator state.
+  if (!g_SeedStartSet) g_SeedStart = g_Seed;
+  const unsigned long seed_end = g_SeedStart + g_Count;
+  std::atomic<unsigned long> next_seed(g_SeedStart);
+  std::atomic<bool> failed(false);
+  // These are toggled during generation and are kept per thread, so each
+  // thread must start with the values set here.
+  const bool access_once = CGOptions::access_once();
+  const bool match_exact_qualifiers = CGOptions::match_exact_qualifiers();
+  auto worker = [&]() {
+    CGOptions::access_once(access_once);
+    CGOptions::match_exact_qualifiers(match_exact_qualifiers);
+    for (unsigned long seed = next_seed++; seed < seed_end && !failed;
+        seed = next_seed++) {
+      if (!GenerateProgram(argc, argv, seed, BatchOutputFilename(seed)))
+        failed = true;
+    }
+  };
+
+  if (g_Jobs == 1) {
+    worker();
+  } else {
+    std::vector<std::thread> threads;
+    for (unsigned long job = 0; job < g_Jobs && job < g_Count; ++job)
+      threads.emplace_back(worker);
+    for (std::thread& thread : threads) thread.join();
+  }
 
-  return 0;
+  return failed ? -1 : 0;
 }
@@ -14,7 +14,7 @@
 
 namespace CLSmith {
 namespace {
-DistributionTable *cl_stmt_table = NULL;
+thread_local DistributionTable *cl_stmt_table = NULL;
 }  // namespace
 
 CLStatement *CLStatement::make_random(CGContext& cg_context,
@@ -99,6 +99,11 @@ void CLStatement::InitProbabilityTable() {
   cl_stmt_table->add_entry(kMessage, 10);
 }
 
+void CLStatement::ReleaseProbabilityTable() {
+  delete cl_stmt_table;
+  cl_stmt_table = NULL;
+}
+
 Statement *make_random_st(CGContext& cg_context) {
   return CLStatement::make_random(cg_context, CLStatement::kNone);
 }
@@ -48,6 +48,9 @@ class CLStatement : public Statement {
   // be called once on startup.
   static void InitProbabilityTable();
 
+  // Destroy the probability table built by InitProbabilityTable.
+  static void ReleaseProbabilityTable();
+
   // Getter the the statement type.
   enum CLStatementType GetCLStatementType() const { return cl_statement_type_; }
 
@@ -0,0 +1,236 @@
+#include "CLSmith/ChoiceReducer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifndef WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "CGOptions.h"
+#include "CLSmith/CLOutputMgr.h"
+#include "CLSmith/CLProgramGenerator.h"
+#include "CLSmith/GenerationContext.h"
+#include "Error.h"
+
+namespace CLSmith {
+namespace {
+bool ReadFile(const std::string& filename, std::string *contents) {
+  std::ifstream in(filename.c_str(), std::ios::binary);
+  if (!in) return false;
+  contents->assign(std::istreambuf_iterator<char>(in),
+      std::istreambuf_iterator<char>());
+  return true;
+}
+
+// Whether the chunk at the given start has a choice that is not already zero.
+bool ChunkIsNonZero(const DeltaMonitor::Choices& choices, size_t start,
+    size_t chunk) {
+  for (size_t idx = start; idx < start + chunk && idx < choices.size(); ++idx)
+    if (choices[idx].first) return true;
+  return false;
+}
+}  // namespace
+
+bool ChoiceReducer::Reduce() {
+  Result best;
+  const std::string seed_filename = CandidateFilename(0);
+  if (!GenerateProgram(NULL, seed_filename, &best.choices) ||
+      !ReadFile(seed_filename, &best.program)) {
+    std::cout << "reduce: can't generate the program of seed " << seed_
+              << std::endl;
+    return false;
+  }
+  best.size = best.program.size();
+  if (!IsInteresting(seed_filename)) {
+    std::cout << "reduce: the program of seed " << seed_
+              << " is not interesting" << std::endl;
+    std::remove(seed_filename.c_str());
+    return false;
+  }
+  std::cout << "reduce: seed " << seed_ << ", " << best.choices.size()
+            << " choices, " << best.size << " bytes" << std::endl;
+
+  // Options toggled during generation are kept per thread, so each worker
+  // starts from the values of this one.
+  const bool access_once = CGOptions::access_once();
+  const bool match_exact_qualifiers = CGOptions::match_exact_qualifiers();
+  unsigned long max_job = 0;
+  size_t chunk = std::max<size_t>(best.choices.size() / 2, 1);
+  while (chunk > 0 && !best.choices.empty()) {
+    std::vector<size_t> starts;
+    for (size_t start = 0; start < best.choices.size(); start += chunk)
+      if (ChunkIsNonZero(best.choices, start, chunk)) starts.push_back(start);
+
+    // A candidate is only kept if it is smaller than the current program.
+    Result result;
+    result.size = best.size;
+    tested_ = 0;
+    interesting_ = 0;
+    std::atomic<size_t> next(0);
+    auto worker = [&](unsigned long job) {
+      CGOptions::access_once(access_once);
+      CGOptions::match_exact_qualifiers(match_exact_qualifiers);
+      const std::string filename = CandidateFilename(job);
+      for (size_t idx = next++; idx < starts.size(); idx = next++)
+        TryCandidate(best.choices, starts[idx], chunk, filename, &result);
+    };
+    const unsigned long jobs = std::min<unsigned long>(jobs_, starts.size());
+    if (jobs <= 1) {
+      worker(0);
+    } else {
+      std::vector<std::thread> threads;
+      for (unsigned long job = 0; job < jobs; ++job)
+        threads.emplace_back(worker, job);
+      for (std::thread& thread : threads) thread.join();
+    }
+    max_job = std::max(max_job, jobs);
+
+    const bool improved = result.size < best.size;
+    if (improved) best = result;
+    std::cout << "reduce: chunk " << chunk << ", " << tested_
+              << " candidates, " << interesting_ << " interesting, "
+              << best.size << " bytes" << std::endl;
+    // The chunk size is kept while it makes progress, the program may have
+    // lost choices, so it is capped to half of those left.
+    if (improved)
+      chunk = std::min(chunk, std::max<size_t>(best.choices.size() / 2, 1));
+    else
+      chunk /= 2;
+  }
+
+  for (unsigned long job = 0; job < std::max(max_job, 1UL); ++job)
+    std::remove(CandidateFilename(job).c_str());
+
+  std::ofstream out(output_.c_str(), std::ios::binary);
+  out << best.program;
+  if (!out) {
+    std::cout << "reduce: can't write " << output_ << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool ChoiceReducer::GenerateProgram(const DeltaMonitor::Choices *choices,
+    const std::string& filename, DeltaMonitor::Choices *made) {
+  if (choices)
+    DeltaMonitor::replay_on_thread(choices);
+  else
+    DeltaMonitor::record_on_thread();
+  bool generated = false;
+  {
+    std::unique_ptr<GenerationContext> context(
+        GenerationContext::CreateGenerationContext(argc_, argv_, seed_));
+    if (context) {
+      CLProgramGenerator generator(seed_, new CLOutputMgr(filename));
+      generator.goGenerator();
+      // The choices are gone with the context.
+      generated = Error::get_error() == SUCCESS;
+      if (generated) DeltaMonitor::get_choices(*made);
+    }
+  }
+  DeltaMonitor::stop_on_thread();
+  return generated;
+}
+
+bool ChoiceReducer::GenerateCandidate(const DeltaMonitor::Choices& choices,
+    const std::string& filename, DeltaMonitor::Choices *made) {
+#ifdef WIN32
+  return GenerateProgram(&choices, filename, made);
+#else
+  // The choices made come back in a file next to the program, as a count and
+  // then the pairs. A pipe could be held open by the other jobs' children.
+  const std::string choices_filename = filename + ".choices";
+  pid_t pid = fork();
+  if (pid < 0) return false;
+  if (pid == 0) {
+    // _exit() leaves the buffers shared with the parent alone.
+    DeltaMonitor::Choices child_made;
+    if (!GenerateProgram(&choices, filename, &child_made)) _exit(1);
+    std::vector<int> data(1, static_cast<int>(child_made.size()));
+    for (const std::pair<int, int>& choice : child_made) {
+      data.push_back(choice.first);
+      data.push_back(choice.second);
+    }
+    std::ofstream out(choices_filename.c_str(), std::ios::binary);
+    out.write(reinterpret_cast<const char *>(data.data()),
+        data.size() * sizeof(int));
+    out.close();
+    _exit(out ? 0 : 1);
+  }
+
+  int status = 0;
+  pid_t waited;
+  while ((waited = waitpid(pid, &status, 0)) < 0 && errno == EINTR) {}
+  std::string bytes;
+  const bool have_choices = ReadFile(choices_filename, &bytes);
+  std::remove(choices_filename.c_str());
+  // A child that crashed or failed an assertion is just not interesting.
+  if (waited != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+      !have_choices ||
+      bytes.size() % sizeof(int) != 0)
+    return false;
+  std::vector<int> data(bytes.size() / sizeof(int));
+  if (!data.empty()) std::memcpy(data.data(), bytes.data(), bytes.size());
+  if (data.empty() || data.size() != 1 + 2 * static_cast<size_t>(data[0]))
+    return false;
+  made->clear();
+  for (size_t idx = 1; idx < data.size(); idx += 2)
+    made->push_back(std::make_pair(data[idx], data[idx + 1]));
+  return true;
+#endif
+}
+
+bool ChoiceReducer::IsInteresting(const std::string& filename) const {
+  const std::string command = command_ + " \"" + filename + '"';
+  return std::system(command.c_str()) == 0;
+}
+
+void ChoiceReducer::TryCandidate(const DeltaMonitor::Choices& choices,
+    size_t start, size_t chunk, const std::string& filename, Result *result) {
+  DeltaMonitor::Choices candidate(choices);
+  for (size_t idx = start; idx < start + chunk && idx < candidate.size(); ++idx)
+    candidate[idx].first = 0;
+
+  Result tried;
+  const bool generated =
+      GenerateCandidate(candidate, filename, &tried.choices) &&
+      ReadFile(filename, &tried.program);
+  const bool interesting = generated && IsInteresting(filename);
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++tested_;
+  if (!interesting) return;
+  ++interesting_;
+  // Of equal candidates, the first one is kept whatever the order they were
+  // tested in, so that the result does not depend on the number of jobs.
+  const size_t size = tried.program.size();
+  if (size < result->size ||
+      (size == result->size && !result->program.empty() &&
+       start < result->start)) {
+    tried.size = size;
+    tried.start = start;
+    *result = tried;
+  }
+}
+
+std::string ChoiceReducer::CandidateFilename(unsigned long job) const {
+  size_t dot = output_.find_last_of('.');
+  size_t slash = output_.find_last_of('/');
+  if (dot == std::string::npos ||
+      (slash != std::string::npos && dot < slash)) dot = output_.size();
+  return output_.substr(0, dot) + "_reduce" + std::to_string(job) +
+      output_.substr(dot);
+}
+
+}  // namespace CLSmith
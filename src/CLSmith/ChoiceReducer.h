@@ -0,0 +1,90 @@
+// Reduces a generated program by editing the random choices it was made from,
+// instead of its text.
+//
+// The program of the seed is generated once, recording its random choices
+// (see DeltaMonitor). Each round then proposes candidates from the current
+// choices, each with one chunk of them set to zero. A zero mostly picks the
+// first alternative of a choice, such as the shortest block, which drops
+// statements, no further type, the first operator, etc. The candidates are
+// regenerated from their choices by SimpleDeltaRndNumGenerator on several
+// threads at once, each in its own GenerationContext, and each thread runs the
+// interestingness command on the programs it generates. Except on Windows, each
+// candidate is generated in a forked child, as an edited choice sequence can
+// lead the generator into an assertion. The smallest
+// interesting program of a round replaces the current one. Once no candidate
+// of a round is interesting, the chunks are halved, down to single choices.
+
+#ifndef _CLSMITH_CHOICEREDUCER_H_
+#define _CLSMITH_CHOICEREDUCER_H_
+
+#include <mutex>
+#include <string>
+
+#include "CommonMacros.h"
+#include "DeltaMonitor.h"
+
+namespace CLSmith {
+
+class ChoiceReducer {
+ public:
+  // The command is run with the name of a program file appended, and the
+  // program is interesting if it exits with 0. The candidates are written
+  // next to the output file, one file per job.
+  ChoiceReducer(int argc, char **argv, unsigned long seed,
+      const std::string& command, const std::string& output,
+      unsigned long jobs)
+      : argc_(argc), argv_(argv), seed_(seed), command_(command),
+        output_(output), jobs_(jobs) {}
+
+  // Writes the smallest interesting program found to the output file. Returns
+  // false if the program of the seed is not interesting, or on any error.
+  bool Reduce();
+
+ private:
+  // The best candidate of a round.
+  struct Result {
+    Result() : size(0), start(0) {}
+    std::string program;
+    size_t size;
+    DeltaMonitor::Choices choices;
+    // Start of the chunk zeroed to get it.
+    size_t start;
+  };
+
+  // Generates the program of the given choices, or that of the seed if NULL,
+  // into a file, and gets the choices made for it. Returns false if the
+  // program could not be generated.
+  bool GenerateProgram(const DeltaMonitor::Choices *choices,
+      const std::string& filename, DeltaMonitor::Choices *made);
+  // Same as GenerateProgram() for a candidate, but in a child process where
+  // possible, so that a candidate the generator fails an assertion or crashes
+  // on is only not interesting, instead of ending the reduction.
+  bool GenerateCandidate(const DeltaMonitor::Choices& choices,
+      const std::string& filename, DeltaMonitor::Choices *made);
+  bool IsInteresting(const std::string& filename) const;
+  // Generates and tests the candidate with the choices of the chunk at the
+  // given start zeroed, and keeps it in the result if it is the best so far.
+  void TryCandidate(const DeltaMonitor::Choices& choices, size_t start,
+      size_t chunk, const std::string& filename, Result *result);
+  // The file the candidates of a job are written to, the output file with
+  // "_reduce<job>" before its extension.
+  std::string CandidateFilename(unsigned long job) const;
+
+  const int argc_;
+  char **const argv_;
+  const unsigned long seed_;
+  const std::string command_;
+  const std::string output_;
+  const unsigned long jobs_;
+  // Guards the result of the round, and the reports.
+  std::mutex mutex_;
+  // Candidates tested and found interesting in the round.
+  unsigned long tested_;
+  unsigned long interesting_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChoiceReducer);
+};
+
+}  // namespace CLSmith
+
+#endif  // _CLSMITH_CHOICEREDUCER_H_
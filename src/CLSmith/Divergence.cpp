@@ -5,6 +5,7 @@
 #include <memory>
 #include <set>
 #include <stack>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -55,8 +56,88 @@ SubBlock *SubBlock::SplitAt(Statement *statement) {
   return next_sub_block_.get();
 }
 
+bool VariableDivergence::Find(unsigned id, bool *divergent) const {
+  unsigned word = id / 64;
+  uint64_t bit = uint64_t(1) << (id % 64);
+  if (word >= present_.size() || !(present_[word] & bit)) return false;
+  *divergent = divergent_[word] & bit;
+  return true;
+}
+
+void VariableDivergence::Set(unsigned id, bool divergent) {
+  unsigned word = id / 64;
+  uint64_t bit = uint64_t(1) << (id % 64);
+  if (word >= present_.size()) {
+    present_.resize(word + 1, 0);
+    divergent_.resize(word + 1, 0);
+  }
+  present_[word] |= bit;
+  if (divergent) divergent_[word] |= bit;
+  else divergent_[word] &= ~bit;
+}
+
+void VariableDivergence::Erase(unsigned id) {
+  unsigned word = id / 64;
+  if (word >= present_.size()) return;
+  uint64_t bit = uint64_t(1) << (id % 64);
+  present_[word] &= ~bit;
+  divergent_[word] &= ~bit;
+}
+
+bool VariableDivergence::Merge(const VariableDivergence& other) {
+  if (other.present_.size() > present_.size()) {
+    present_.resize(other.present_.size(), 0);
+    divergent_.resize(other.present_.size(), 0);
+  }
+  bool change = false;
+  for (unsigned word = 0; word < other.present_.size(); ++word) {
+    change |= (other.divergent_[word] & ~divergent_[word]) != 0;
+    present_[word] |= other.present_[word];
+    divergent_[word] |= other.divergent_[word];
+  }
+  return change;
+}
+
+void VariableDivergence::Overlay(const VariableDivergence& other) {
+  if (other.present_.size() > present_.size()) {
+    present_.resize(other.present_.size(), 0);
+    divergent_.resize(other.present_.size(), 0);
+  }
+  for (unsigned word = 0; word < other.present_.size(); ++word) {
+    present_[word] |= other.present_[word];
+    divergent_[word] = (divergent_[word] & ~other.present_[word]) |
+        other.divergent_[word];
+  }
+}
+
+int VariableDivergence::Compare(const VariableDivergence& other) const {
+  size_t words = std::max(present_.size(), other.present_.size());
+  for (unsigned word = 0; word < words; ++word) {
+    uint64_t present = word < present_.size() ? present_[word] : 0;
+    uint64_t other_present =
+        word < other.present_.size() ? other.present_[word] : 0;
+    if (present != other_present) return present < other_present ? -1 : 1;
+    uint64_t divergent = word < divergent_.size() ? divergent_[word] : 0;
+    uint64_t other_divergent =
+        word < other.divergent_.size() ? other.divergent_[word] : 0;
+    if (divergent != other_divergent)
+      return divergent < other_divergent ? -1 : 1;
+  }
+  return 0;
+}
+
+bool CallContext::operator<(const CallContext& other) const {
+  return std::tie(parameters, divergent, global_derefs_version, param_ref_div,
+      global_var_div, saved_global_var_div, param_derefs_to) <
+      std::tie(other.parameters, other.divergent, other.global_derefs_version,
+      other.param_ref_div, other.global_var_div, other.saved_global_var_div,
+      other.param_derefs_to);
+}
+
 }  // namespace Internal
 
+using Internal::CallContext;
+using Internal::CallSummary;
 using Internal::SubBlock;
 using Internal::SavedState;
 
@@ -78,15 +159,17 @@ void FunctionDivergence::GetDivergentCodeSectionsForBlock(Block *block,
 }
 
 void FunctionDivergence::ProcessWithContext(const std::vector<bool>& parameters,
-    const std::map<const Variable *, std::set<const Variable *> *>&
+    const std::map<const Variable *, std::set<const Variable *>>&
         param_derefs_to,
     const std::map<const Variable *, bool>& param_ref_div, bool divergent) {
   assert(status_ != kMidProcess && "Loopy program.");
+  if (status_ == kNotDone) ++div_->first_runs_;
+  ++div_->function_runs_;
   status_ = kMidProcess;
 
   // Reset the object state.
   sub_block_div_.clear();
-  variable_div_.clear();
+  variable_div_.Clear();
   divergent_value_ = false;
   var_derefs_to_.clear();
   return_derefs_to_.clear();
@@ -94,11 +177,13 @@ void FunctionDivergence::ProcessWithContext(const std::vector<bool>& parameters,
   // Put passed parameters into the variable divergence map.
   assert(parameters.size() == function_->param.size());
   for (unsigned param_idx = 0; param_idx < parameters.size(); ++param_idx)
-    variable_div_[function_->param[param_idx]] = parameters[param_idx];
+    variable_div_.Set(div_->GetVariableId(function_->param[param_idx]),
+        parameters[param_idx]);
 
   // Put in the extra contextual information.
-  for (auto item : param_derefs_to) var_derefs_to_[item.first] = *item.second;
-  for (auto item : param_ref_div) variable_div_[item.first] = item.second;
+  for (auto& item : param_derefs_to) var_derefs_to_[item.first] = item.second;
+  for (auto& item : param_ref_div)
+    variable_div_.Set(div_->GetVariableId(item.first), item.second);
 
   // Set up state to begin processing.
   sub_block_ = block_to_sub_block_final_[function_->body].get();
@@ -307,16 +392,14 @@ void FunctionDivergence::ProcessStatementArray(Statement *statement) {
   // Remove any references to array members.
   const ArrayVariable *array_var = statement_arr->array_var;
   bool expr_div = IsExpressionDivergent(*statement_arr->init_value);
-  std::map<const Variable *, bool> *div_map = array_var->is_global() ?
+  Internal::VariableDivergence *div_map = array_var->is_global() ?
       &div_->global_var_div_ : &variable_div_;
-  for (auto map_it = div_map->begin(); map_it != div_map->end();) {
-    if (map_it->first->get_collective() == array_var) {
-      auto map_it_rem = map_it++;
-      div_map->erase(map_it_rem);
-    } else {
-      ++map_it;
-    }
-  }
+  std::vector<unsigned> member_ids;
+  div_map->ForEach([this, array_var, &member_ids](unsigned id) {
+    if (div_->variables_[id]->get_collective() == array_var)
+      member_ids.push_back(id);
+  });
+  for (unsigned id : member_ids) div_map->Erase(id);
   SetVariableDivergence(array_var, expr_div || divergent_);
   assert(array_var->type->get_indirect_level() == 0 && "Not implemented.");
 }
@@ -341,7 +424,7 @@ void FunctionDivergence::ProcessEndStatementFor(Statement *statement) {
 
   // Restore, check for changes.
   assert(!div_->saved_states_.empty());
-  SavedState *saved_state = div_->saved_states_.back();
+  SavedState *saved_state = div_->saved_states_.back().get();
   assert(saved_state->function_owner_ == this);
   assert(saved_state->statement_ == statement);
   bool change = RestoreAndMergeSavedState(saved_state);
@@ -353,12 +436,15 @@ void FunctionDivergence::ProcessEndStatementFor(Statement *statement) {
     function_walker_.reset(
         Walker::FunctionWalker::CreateFunctionWalkerAtStatement(
         function_, statement));
-    divergent_ = *branch_block_div;
+    // The restore replaced the map branch_block_div pointed into.
+    divergent_ = sub_block_div_[sub_block_];
     div_->saved_states_.emplace_back(SaveState(statement));
 
     // Loop through the for manually. Do not assert the Advance, as if the for
     // ends at the end of the function, Advance returns false.
-    assert(function_walker_->Advance());
+    bool advanced = function_walker_->Advance();
+    assert(advanced);
+    (void)advanced;
     while (*function_walker_ != *saved_walker) {
       ProcessStep();
       function_walker_->Advance();
@@ -377,7 +463,7 @@ void FunctionDivergence::ProcessEndStatementFor(Statement *statement) {
 
     // Restore, check for changes.
     assert(!div_->saved_states_.empty());
-    SavedState *saved_state = div_->saved_states_.back();
+    SavedState *saved_state = div_->saved_states_.back().get();
     assert(saved_state->function_owner_ == this);
     assert(saved_state->statement_ == statement);
     change = RestoreAndMergeSavedState(saved_state);
@@ -409,7 +495,7 @@ void FunctionDivergence::ProcessEndStatementIf(Statement *statement) {
   }
 
   assert(!div_->saved_states_.empty());
-  SavedState *saved_state = div_->saved_states_.back();
+  SavedState *saved_state = div_->saved_states_.back().get();
   assert(saved_state->function_owner_ == this);
   assert(saved_state->statement_ == statement);
   RestoreAndMergeSavedState(saved_state);
@@ -483,18 +569,12 @@ bool FunctionDivergence::IsExpressionDivergent(const Expression& expression) {
 }
 
 bool FunctionDivergence::IsVariableDivergent(const Variable& variable) {
-  bool global = variable.is_global();
-  std::map<const Variable *, bool>& div_map =
-      global ? div_->global_var_div_ : variable_div_;
-  std::map<const Variable *, bool> SavedState:: *SaveMapPtr =
-      global ? &SavedState::global_var_div_ : &SavedState::variable_div_;
-
   // Special case for arrays. For an itemised array member, only process its
   // initialisation when necessary.
   if (variable.isArray) {
     bool found_entry;
     bool div;
-    div = SearchMap(div_map, SaveMapPtr, &variable, global, &found_entry);
+    div = SearchVariable(&variable, &found_entry);
     if (found_entry) return div;
     const ArrayVariable& var_arr = dynamic_cast<const ArrayVariable&>(variable);
     const Variable *coll = var_arr.get_collective();
@@ -508,7 +588,7 @@ bool FunctionDivergence::IsVariableDivergent(const Variable& variable) {
   }
 
   bool unused_b;
-  return SearchMap(div_map, SaveMapPtr, &variable, global, &unused_b);
+  return SearchVariable(&variable, &unused_b);
 }
 
 bool FunctionDivergence::IsSubBlockDivergent(SubBlock *sub_block) {
@@ -522,7 +602,8 @@ bool FunctionDivergence::IsFunctionCallDivergent(
     std::set<const Variable *> *return_refs) {
   Function *callee = const_cast<Function *>(invoke.get_func()); //const again, will todo later.
   const std::vector<Variable *>& param_vars = callee->param;
-  std::vector<bool> param_div;
+  CallContext context;
+  std::vector<bool>& param_div = context.parameters;
 
   assert(invoke.param_value.size() == param_vars.size());
   for (unsigned param_idx = 0; param_idx < param_vars.size(); ++param_idx)
@@ -532,8 +613,9 @@ bool FunctionDivergence::IsFunctionCallDivergent(
   // For parameters that are pointers, the dereferencing information must be
   // passed into the function. Must also inform it which of them are divergent.
   // We do it manually, instead of using DereferencePointerVaribale.
-  std::map<const Variable *, std::set<const Variable *> *> param_derefs_to;
-  std::map<const Variable *, bool> param_ref_div;
+  std::map<const Variable *, std::set<const Variable *>>& param_derefs_to =
+      context.param_derefs_to;
+  std::map<const Variable *, bool>& param_ref_div = context.param_ref_div;
   for (Variable *param_var : callee->param) {
     std::set<const Variable *> vars_to_deref({param_var});
     for (int deref_lvl = param_var->type->get_indirect_level(); deref_lvl > 0;
@@ -544,7 +626,7 @@ bool FunctionDivergence::IsFunctionCallDivergent(
         if (deref_var->is_global()) continue;
         auto map_it = var_derefs_to_.find(deref_var);
         if(map_it == var_derefs_to_.end()) continue;
-        param_derefs_to[map_it->first] = &map_it->second;
+        param_derefs_to[map_it->first] = map_it->second;
         // csmith will not pass pointers to other parameters, so ignore them.
         for (const Variable *var : map_it->second)
           if (!var->is_argument()) new_vars_to_deref.insert(var);
@@ -557,34 +639,36 @@ bool FunctionDivergence::IsFunctionCallDivergent(
     }
   }
 
+  // The rest of the context, the globals are seen through all saved states.
+  context.divergent = divergent_;
+  context.global_var_div = div_->global_var_div_;
+  for (auto& saved_state : div_->saved_states_)
+    context.saved_global_var_div.Overlay(saved_state->global_var_div_);
+  context.global_derefs_version = div_->global_derefs_version_;
+
   // Retrieve or create new FunctionDivergence for the function.
   std::unique_ptr<FunctionDivergence> *func_div = &div_->function_div_[callee];
   if (func_div->get() == NULL)
     func_div->reset(new FunctionDivergence(div_, callee));
-  (*func_div)->ProcessWithContext(
-    param_div, param_derefs_to, param_ref_div, divergent_);
+  const CallSummary& summary = (*func_div)->ProcessCall(std::move(context));
 
   // Retrieve any information relevant to the calling context. For local
   // pointers passed by pointers, check whether they may point to extra global
   // vars.
-  bool div = (*func_div)->divergent_value_final_;
-  if (return_refs != NULL)
-    *return_refs = std::move((*func_div)->return_derefs_to_);
-  for (auto& it_pair : param_derefs_to) {
+  bool div = summary.divergent_value;
+  if (return_refs != NULL) *return_refs = summary.return_derefs_to;
+  for (auto& it_pair : summary.passed_vars) {
     const Variable *passed_var = it_pair.first;
-    if (passed_var->is_global() || passed_var->is_argument()) continue;
-    const std::set<const Variable *>& passed_var_derefs =
-        (*func_div)->var_derefs_to_[passed_var];
     std::set<const Variable *> *our_var_derefs = &var_derefs_to_[passed_var];
-    for (const Variable *var_deref : passed_var_derefs)
-      if (var_deref->is_global()) our_var_derefs->insert(var_deref);
-    SetVariableDivergence(passed_var, (*func_div)->variable_div_[passed_var]);
+    our_var_derefs->insert(it_pair.second.first.begin(),
+        it_pair.second.first.end());
+    SetVariableDivergence(passed_var, it_pair.second.second);
   }
 
   // Clean up.
   for (Variable *param_var : callee->param) {
     var_derefs_to_.erase(param_var);
-    variable_div_.erase(param_var);
+    variable_div_.Erase(div_->GetVariableId(param_var));
   }
 
   return div;
@@ -617,7 +701,10 @@ bool FunctionDivergence::IsAssignmentDivergent(
       // TODO uncomment when pointers properly saved.
       //if (!deref_div && lhs_derefs_to.size() == 1 && !divergent_)
       //  lhs_var_derefs->clear();
+      size_t derefs_count = lhs_var_derefs->size();
       lhs_var_derefs->insert(rhs_var_derefs.begin(), rhs_var_derefs.end());
+      if (lhs_var->is_global() && lhs_var_derefs->size() != derefs_count)
+        ++div_->global_derefs_version_;
       SetVariableDivergence(lhs_var, rhs_div || deref_div || divergent_);
     }
     return rhs_div;
@@ -727,9 +814,29 @@ void FunctionDivergence::MarkSubBlockDivergentViral(SubBlock *sub_block) {
 void FunctionDivergence::SetVariableDivergence(
     const Variable *var, bool divergent) {
   if (var->is_global())
-    div_->global_var_div_[var] = divergent;
+    div_->global_var_div_.Set(div_->GetVariableId(var), divergent);
   else
-    variable_div_[var] = divergent;
+    variable_div_.Set(div_->GetVariableId(var), divergent);
+}
+
+bool FunctionDivergence::SearchVariable(
+    const Variable *var, bool *found_entry) {
+  // Same as SearchMap(), globals are visible in every saved state.
+  bool global = var->is_global();
+  unsigned id = div_->GetVariableId(var);
+  bool divergent;
+  *found_entry = true;
+  if ((global ? div_->global_var_div_ : variable_div_).Find(id, &divergent))
+    return divergent;
+  for (auto save_it = div_->saved_states_.rbegin();
+      save_it != div_->saved_states_.rend(); ++save_it) {
+    if (!global && (*save_it)->function_owner_ != this) continue;
+    const Internal::VariableDivergence& saved_div = global ?
+        (*save_it)->global_var_div_ : (*save_it)->variable_div_;
+    if (saved_div.Find(id, &divergent)) return divergent;
+  }
+  *found_entry = false;
+  return false;
 }
 
 SubBlock *FunctionDivergence::GetSubBlockForBranchFromBlock(
@@ -756,10 +863,10 @@ SavedState *FunctionDivergence::SaveState(Statement *statement) {
   saved_state->sub_block_div_ = std::move(sub_block_div_);
   saved_state->variable_div_ = std::move(variable_div_);
   sub_block_div_.clear();
-  variable_div_.clear();
+  variable_div_.Clear();
 
   saved_state->global_var_div_ = std::move(div_->global_var_div_);
-  div_->global_var_div_.clear();
+  div_->global_var_div_.Clear();
 
   return saved_state;
 }
@@ -772,10 +879,10 @@ bool FunctionDivergence::RestoreAndMergeSavedState(SavedState *saved_state) {
   change |= MergeMap(&saved_state->sub_block_div_, &sub_block_div_);
   sub_block_div_ = std::move(saved_state->sub_block_div_);
   // Restore local variables.
-  change |= MergeMap(&saved_state->variable_div_, &variable_div_);
+  change |= saved_state->variable_div_.Merge(variable_div_);
   variable_div_ = std::move(saved_state->variable_div_);
   // Restore global variables.
-  change |= MergeMap(&saved_state->global_var_div_, &div_->global_var_div_);
+  change |= saved_state->global_var_div_.Merge(div_->global_var_div_);
   div_->global_var_div_ = std::move(saved_state->global_var_div_);
 
   return change;
@@ -809,14 +916,59 @@ bool FunctionDivergence::SearchMap(const std::map<T *, bool>& mapping,
   for (auto save_it = div_->saved_states_.rbegin();
       save_it != div_->saved_states_.rend(); ++save_it) {
     if (!is_global && (*save_it)->function_owner_ != this) continue;
-    auto save_map_it = ((*save_it)->*SaveMapPtr).find(item);
-    if (save_map_it != ((*save_it)->*SaveMapPtr).end())
+    auto save_map_it = (save_it->get()->*SaveMapPtr).find(item);
+    if (save_map_it != (save_it->get()->*SaveMapPtr).end())
       return save_map_it->second;
   }
   *found_entry = false;
   return false;
 }
 
+const CallSummary& FunctionDivergence::ProcessCall(CallContext&& context) {
+  auto summary_it = call_summaries_.find(context);
+  if (summary_it != call_summaries_.end()) {
+    ++div_->summaries_reused_;
+    div_->global_var_div_ = summary_it->second.global_var_div;
+    return summary_it->second;
+  }
+
+  unsigned first_runs = div_->first_runs_;
+  unsigned global_derefs_version = div_->global_derefs_version_;
+  ProcessWithContext(context.parameters, context.param_derefs_to,
+      context.param_ref_div, context.divergent);
+
+  CallSummary summary;
+  summary.divergent_value = divergent_value_final_;
+  summary.return_derefs_to = std::move(return_derefs_to_);
+  for (auto& it_pair : context.param_derefs_to) {
+    const Variable *passed_var = it_pair.first;
+    if (passed_var->is_global() || passed_var->is_argument()) continue;
+    std::pair<std::set<const Variable *>, bool> *passed =
+        &summary.passed_vars[passed_var];
+    for (const Variable *var_deref : var_derefs_to_[passed_var])
+      if (var_deref->is_global()) passed->first.insert(var_deref);
+    passed->second = variable_div_.Get(div_->GetVariableId(passed_var));
+  }
+
+  // Processing a function for the first time, or letting a global pointer
+  // point to more variables, means the same context would not give the same
+  // result again.
+  if (first_runs != div_->first_runs_ ||
+      global_derefs_version != div_->global_derefs_version_) {
+    last_summary_ = std::move(summary);
+    return last_summary_;
+  }
+  summary.global_var_div = div_->global_var_div_;
+  return call_summaries_.emplace(
+      std::move(context), std::move(summary)).first->second;
+}
+
+unsigned Divergence::GetVariableId(const Variable *var) {
+  auto id_it = variable_ids_.emplace(var, variables_.size());
+  if (id_it.second) variables_.push_back(var);
+  return id_it.first->second;
+}
+
 void Divergence::ProcessEntryFunction(Function *function) {
   FunctionDivergence *function_div = new FunctionDivergence(this, function);
   function_div_[function].reset(function_div);
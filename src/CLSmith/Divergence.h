@@ -14,8 +14,8 @@
 //   create a walker interface. This allows us to plug this code in to other
 //   ASTs as long as the walker interface is implemented.
 // - Const correctness.
-// - Prevent repeated processing of functions, loops, etc. by storing the
-//   initial state of the last time we processed.
+// - Prevent repeated processing of loops by storing the initial state of the
+//   last time we processed (functions are summarised per calling context).
 // - Use the strict method of pointer analysis, instead of the bounded method.
 //   This would be expensive, as pointer sets would have to be copied when the
 //   state is saved.
@@ -42,10 +42,12 @@
 #ifndef _CLSMITH_DIVERGENCE_H_
 #define _CLSMITH_DIVERGENCE_H_
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <set>
 #include <stack>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -100,6 +102,85 @@ class SubBlock {
   DISALLOW_COPY_AND_ASSIGN(SubBlock);
 };
 
+// The divergence of a set of variables, kept as two bitsets indexed by the ids
+// Divergence gives the variables. A variable can be absent from the set, which
+// is not the same as being convergent, as lookups then go on to the saved
+// states.
+class VariableDivergence {
+ public:
+  VariableDivergence() {}
+
+  // Returns true if the variable is in the set, putting its divergence in
+  // divergent.
+  bool Find(unsigned id, bool *divergent) const;
+  // Absent variables are convergent.
+  bool Get(unsigned id) const {
+    bool divergent;
+    return Find(id, &divergent) && divergent;
+  }
+  void Set(unsigned id, bool divergent);
+  void Erase(unsigned id);
+  void Clear() { present_.clear(); divergent_.clear(); }
+
+  // Adds the variables of other to the set, those that are divergent in other
+  // becoming divergent. Returns true if any variable became divergent.
+  bool Merge(const VariableDivergence& other);
+  // Replaces the variables that are in other with their entry in other, as if
+  // other was a saved state above this one.
+  void Overlay(const VariableDivergence& other);
+
+  // Calls func with the id of each variable in the set.
+  template<typename Func>
+  void ForEach(Func func) const {
+    for (unsigned word = 0; word < present_.size(); ++word)
+      for (uint64_t bits = present_[word]; bits != 0; bits &= bits - 1)
+        func(word * 64 + __builtin_ctzll(bits));
+  }
+
+  // Sets that differ only in trailing unused words compare equal.
+  bool operator<(const VariableDivergence& other) const {
+    return Compare(other) < 0;
+  }
+  bool operator==(const VariableDivergence& other) const {
+    return Compare(other) == 0;
+  }
+
+ private:
+  int Compare(const VariableDivergence& other) const;
+
+  std::vector<uint64_t> present_;
+  std::vector<uint64_t> divergent_;
+};
+
+// Everything that processing a function depends on, apart from the function.
+// Processing is deterministic, so a function processed again in the same
+// context has the same result, which lets us reuse it.
+struct CallContext {
+  std::vector<bool> parameters;
+  std::map<const Variable *, std::set<const Variable *>> param_derefs_to;
+  std::map<const Variable *, bool> param_ref_div;
+  bool divergent;
+  // The global variables, as they are at the top of the saved states and as
+  // they are seen through all of the saved states below.
+  VariableDivergence global_var_div;
+  VariableDivergence saved_global_var_div;
+  // Changes whenever a global pointer may point to more variables.
+  unsigned global_derefs_version;
+
+  bool operator<(const CallContext& other) const;
+};
+
+// The effects of processing a function in a context, as seen by the caller.
+struct CallSummary {
+  bool divergent_value;
+  std::set<const Variable *> return_derefs_to;
+  // For local variables passed by pointer, the globals they may now point to,
+  // and whether they are divergent.
+  std::map<const Variable *, std::pair<std::set<const Variable *>, bool>>
+      passed_vars;
+  VariableDivergence global_var_div;
+};
+
 // At some points during processing, we need use a temporary state, without
 // modifying the actual state. But we still need refer to the original state.
 // This class will store the state of the whole process, but make it available
@@ -119,10 +200,10 @@ class SavedState {
 
   // Saved state of the owner's members (minus the context).
   std::map<SubBlock *, bool> sub_block_div_;
-  std::map<const Variable *, bool> variable_div_;
+  VariableDivergence variable_div_;
 
   // Globals
-  std::map<const Variable *, bool> global_var_div_;
+  VariableDivergence global_var_div_;
  private:
   DISALLOW_COPY_AND_ASSIGN(SavedState);
 };
@@ -184,10 +265,15 @@ class FunctionDivergence {
   // dereference to, param_deref_div contains all the variable divergence
   // information for variable outside this function that it may refer to.
   void ProcessWithContext(const std::vector<bool>& parameters,
-      const std::map<const Variable *, std::set<const Variable *> *>&
+      const std::map<const Variable *, std::set<const Variable *>>&
           param_derefs_to,
       const std::map<const Variable *, bool>& param_ref_div, bool divergent);
 
+  // Processes a call to the function in the given context, unless it has
+  // already been processed in the same context, and returns its effects. The
+  // returned summary is only valid until the next call.
+  const Internal::CallSummary& ProcessCall(Internal::CallContext&& context);
+
   Function *GetFunction() const { return function_; }
   ProcessStatus GetProcessStatus() const { return status_; }
 
@@ -261,6 +347,8 @@ class FunctionDivergence {
 
   // Helper function for correctly assigning the divergence of a variable.
   void SetVariableDivergence(const Variable *var, bool divergent);
+  // Looks up a variable, going through saved states if necessary.
+  bool SearchVariable(const Variable *var, bool *found_entry);
 
   // Helper functions for accessing this class' ridiculous data structures.
   Internal::SubBlock *GetSubBlockForBranch(Statement *statement, Block *block) {
@@ -295,7 +383,7 @@ class FunctionDivergence {
   // Which sub blocks we have marked as divergent.
   std::map<Internal::SubBlock *, bool> sub_block_div_;
   // Which (local) variables are divergent.
-  std::map<const Variable *, bool> variable_div_;
+  Internal::VariableDivergence variable_div_;
   // Is the return value possible divergent.
   bool divergent_value_;
 
@@ -331,6 +419,13 @@ class FunctionDivergence {
   // Does the return value of the function have a divergent value.
   bool divergent_value_final_;
 
+  // The effects of the calls processed so far, by calling context. Only calls
+  // that did not process any function for the first time are kept, as the
+  // first time through a function can mark fewer sub blocks than later ones.
+  std::map<Internal::CallContext, Internal::CallSummary> call_summaries_;
+  // The effects of the last call that could not be kept.
+  Internal::CallSummary last_summary_;
+
   Divergence *div_;
   Function *function_;
   ProcessStatus status_;
@@ -346,7 +441,9 @@ class FunctionDivergence {
 // variables, functions).
 class Divergence {
  public:
-  Divergence() {}
+  Divergence()
+      : first_runs_(0), global_derefs_version_(0), function_runs_(0),
+        summaries_reused_(0) {}
   virtual ~Divergence() {}
 
   // Processes the whole program, given the entry function.
@@ -356,19 +453,39 @@ class Divergence {
   // and last statement of a divergent section.
   void GetDivergentCodeSectionsForFunction(Function *function,
       std::vector<std::pair<Statement *, Statement *>> *divergent_sections);
+
+  // How many times a function was processed, and how many times processing a
+  // call was avoided by reusing the summary of an earlier call.
+  unsigned long GetFunctionRuns() const { return function_runs_; }
+  unsigned long GetSummariesReused() const { return summaries_reused_; }
+
  private:
+  // Gives each variable a small id, for indexing VariableDivergence.
+  unsigned GetVariableId(const Variable *var);
+
   // Each function has its own instance of the FunctionDivergence class. 
   std::map<Function *, std::unique_ptr<FunctionDivergence>> function_div_;
   // Tracks divergence of the global variables. This means that the order in
   // which we process the functions affects the outcome.
-  std::map<const Variable *, bool> global_var_div_;
+  Internal::VariableDivergence global_var_div_;
 
   // Keeps track of what pointers global variables may be pointing to.
   std::map<const Variable *, std::set<const Variable *>> global_var_derefs_to_;
 
   // Saved states that need to be visible to all FunctionDivergence objects.
   // Order matters, acessed from back to front.
-  std::vector<Internal::SavedState *> saved_states_;
+  std::vector<std::unique_ptr<Internal::SavedState>> saved_states_;
+
+  // Variable ids, and the variable for each id.
+  std::unordered_map<const Variable *, unsigned> variable_ids_;
+  std::vector<const Variable *> variables_;
+
+  // Number of functions processed for the first time so far.
+  unsigned first_runs_;
+  // Incremented whenever a global pointer may point to more variables.
+  unsigned global_derefs_version_;
+  unsigned long function_runs_;
+  unsigned long summaries_reused_;
 
   friend class FunctionDivergence;
   DISALLOW_COPY_AND_ASSIGN(Divergence);
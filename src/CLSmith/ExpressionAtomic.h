@@ -117,6 +117,9 @@ class ExpressionAtomic : public CLExpression {
   
   // Initialize various parameters related to atomic blocks
   static void InitAtomics(void);
+
+  // Reset the atomic block state so that another program can be generated.
+  static void ReleaseAtomics(void);
   
   // Return the number of maximum atomic blocks for the current program
   static int get_atomic_blocks_no(void);
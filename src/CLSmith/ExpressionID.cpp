@@ -23,8 +23,8 @@
 
 namespace CLSmith {
 namespace {
-MemoryBuffer *sequence_input;
-Variable *offsets[9];
+thread_local MemoryBuffer *sequence_input;
+thread_local Variable *offsets[9];
 }  // namespace
 
 ExpressionID *ExpressionID::make_random(CGContext& cg_context,
@@ -70,6 +70,11 @@ void ExpressionID::Initialise() {
   }
 }
 
+void ExpressionID::Release() {
+  sequence_input = NULL;
+  for (int idx = 0; idx < 9; ++idx) offsets[idx] = NULL;
+}
+
 void ExpressionID::AddVarsToGlobals(Globals *globals) {
   for (int idx = 0; idx < 9; ++idx)
     globals->AddGlobalVariable(offsets[idx]);
@@ -52,6 +52,10 @@ class ExpressionID : public CLExpression {
   // Initialise the static data used for divergence faking.
   static void Initialise();
 
+  // Forget the static data, so that Initialise will create it again for the
+  // next program.
+  static void Release();
+
   // Add any variables referred to throughout the program to the globals struct.
   static void AddVarsToGlobals(Globals *globals);
 
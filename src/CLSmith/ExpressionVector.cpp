@@ -21,8 +21,8 @@
 
 namespace CLSmith {
 namespace {
-DistributionTable *vector_expr_table = NULL;
-DistributionTable *suffix_table = NULL;
+thread_local DistributionTable *vector_expr_table = NULL;
+thread_local DistributionTable *suffix_table = NULL;
 }  // namespace
 
 ExpressionVector *ExpressionVector::make_random(CGContext &cg_context,
@@ -139,6 +139,13 @@ void ExpressionVector::InitProbabilityTable() {
   suffix_table->add_entry(kOdd, 10);
 }
 
+void ExpressionVector::ReleaseProbabilityTable() {
+  delete vector_expr_table;
+  vector_expr_table = NULL;
+  delete suffix_table;
+  suffix_table = NULL;
+}
+
 ExpressionVector *ExpressionVector::clone() const {
   std::vector<std::unique_ptr<const Expression>> exprs;
   for (const auto& expr : exprs_) exprs.emplace_back(expr->clone());
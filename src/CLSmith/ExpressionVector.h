@@ -84,6 +84,9 @@ class ExpressionVector : public CLExpression {
   // once on start-up.
   static void InitProbabilityTable();
 
+  // Destroy the tables built by InitProbabilityTable.
+  static void ReleaseProbabilityTable();
+
   // Implementations of pure virtual methods in Expression. Most of these are
   // trivial, as the expression evaluates to a runtime constant.
   ExpressionVector *clone() const;
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "CLSmith/CLOptions.h"
+#include "CLSmith/GenerationContext.h"
 #include "CLSmith/Vector.h"
 #include "ProbabilityTable.h"
 #include "Type.h"
@@ -13,12 +14,18 @@
 namespace CLSmith {
 namespace {
 // Integer function tables.
-DistributionTable *integer_func_table = NULL;
+thread_local DistributionTable *integer_func_table = NULL;
 // Internal::ParameterType::ParameterTypeMap<enum FunctionInvocationIntegerBuiltIn::BuiltIn> *integer_param_map;
-std::map<enum FunctionInvocationIntegerBuiltIn::BuiltIn,
-         std::vector<Internal::ParameterType::TypeConversion>> *
+thread_local std::map<enum FunctionInvocationIntegerBuiltIn::BuiltIn,
+                      std::vector<Internal::ParameterType::TypeConversion>> *
     integer_param_map = NULL;
 
+// Used by ConvertParameterType to keep the conversion of a pair of parameters
+// consistent. For kFlipSignChance2.
+thread_local int flip_next = 0;
+// For kDemoteChance2.
+thread_local int demote_next = 0;
+
 // Integer function names. The array indices line up with the enum value.
 const char *const kIntegerNames[20] = {
     ""     ,  "abs"    , "abs_diff", "add_sat" , "hadd" , "rhadd", "clamp" ,
@@ -34,10 +41,6 @@ const Type& ConvertParameterType(
     const Type& type, enum TypeConversion conversion) {
   // Only convert scalar and vector types. Other types should never get here.
   assert(type.eType == eSimple || type.eType == eVector);
-  // For kFlipSignChance2.
-  static int flip_next = 0;
-  // For kDemoteChance2.
-  static int demote_next = 0;
 
   const Type *t = NULL;
   switch (conversion) {
@@ -113,7 +116,16 @@ void FunctionInvocationBuiltIn::InitTables() {
   FunctionInvocationIntegerBuiltIn::InitTables();
 }
 
+void FunctionInvocationBuiltIn::ReleaseTables() {
+  FunctionInvocationIntegerBuiltIn::ReleaseTables();
+  flip_next = 0;
+  demote_next = 0;
+}
+
 void FunctionInvocationBuiltIn::Output(std::ostream& out) const {
+  GenerationContext::Features *features =
+      GenerationContext::GetCurrentFeatures();
+  if (features) features->RecordBuiltIn(GetFuncName());
   if (CLOptions::safe_math()) {
     OutputSafeMacro(out);
   } else {
@@ -227,6 +239,13 @@ void FunctionInvocationIntegerBuiltIn::InitTables() {
   (*integer_param_map)[kMul24]    = { kExact, kExact };
 }
 
+void FunctionInvocationIntegerBuiltIn::ReleaseTables() {
+  delete integer_func_table;
+  integer_func_table = NULL;
+  delete integer_param_map;
+  integer_param_map = NULL;
+}
+
 FunctionInvocationIntegerBuiltIn *FunctionInvocationIntegerBuiltIn::clone()
     const {
   FunctionInvocationIntegerBuiltIn *fi =
@@ -237,7 +256,11 @@ FunctionInvocationIntegerBuiltIn *FunctionInvocationIntegerBuiltIn::clone()
 }
 
 void FunctionInvocationIntegerBuiltIn::OutputFuncName(std::ostream& out) const {
-  out << kIntegerNames[built_in_];
+  out << GetFuncName();
+}
+
+const char *FunctionInvocationIntegerBuiltIn::GetFuncName() const {
+  return kIntegerNames[built_in_];
 }
 
 const Type& FunctionInvocationIntegerBuiltIn::GetParameterType(size_t idx)
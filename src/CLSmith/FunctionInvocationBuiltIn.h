@@ -82,6 +82,9 @@ class FunctionInvocationBuiltIn : public FunctionInvocation {
   // Initialises the probability tables and type mappings.
   static void InitTables();
 
+  // Destroys the tables created by InitTables.
+  static void ReleaseTables();
+
   // Pure virtual in FunctionInvocation.
   const Type &get_type() const { return type_; }
   void Output(std::ostream &) const;
@@ -90,6 +93,8 @@ class FunctionInvocationBuiltIn : public FunctionInvocation {
 
   // Output only the name of the built-in function (no brackets or params).
   virtual void OutputFuncName(std::ostream& out) const = 0;
+  // The name of the built-in function.
+  virtual const char *GetFuncName() const = 0;
 
   // Get the expected type of the function paramter at index idx.
   virtual const Type& GetParameterType(size_t idx) const = 0;
@@ -139,11 +144,15 @@ class FunctionInvocationIntegerBuiltIn : public FunctionInvocationBuiltIn {
   // Initialises the probability tables and type mappings.
   static void InitTables();
 
+  // Destroys the tables created by InitTables.
+  static void ReleaseTables();
+
   // Pure virtual in FunctionInvocation.
   FunctionInvocationIntegerBuiltIn *clone() const;
 
   // Pure virtual in FunctionInvocationBuiltIn.
   void OutputFuncName(std::ostream& out) const;
+  const char *GetFuncName() const;
   const Type& GetParameterType(size_t idx) const;
 
   enum BuiltIn GetBuiltIn() const { return built_in_; }
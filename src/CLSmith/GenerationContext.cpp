@@ -0,0 +1,140 @@
+#include "CLSmith/GenerationContext.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "AbsProgramGenerator.h"
+#include "Block.h"
+#include "CLSmith/CLExpression.h"
+#include "CLSmith/CLStatement.h"
+#include "CLSmith/ExpressionAtomic.h"
+#include "CLSmith/ExpressionID.h"
+#include "CLSmith/FunctionInvocationBuiltIn.h"
+#include "CLSmith/Globals.h"
+#include "CLSmith/MemoryBuffer.h"
+#include "CLSmith/StatementAtomicReduction.h"
+#include "CLSmith/StatementAtomicResult.h"
+#include "CLSmith/StatementComm.h"
+#include "CLSmith/StatementEMI.h"
+#include "CLSmith/StatementMessage.h"
+#include "CLSmith/Vector.h"
+#include "Expression.h"
+#include "PartialExpander.h"
+#include "Statement.h"
+
+namespace CLSmith {
+namespace {
+thread_local GenerationContext *current_context = NULL;
+
+const char *const phase_names[GenerationContext::Statistics::kPhaseCount] = {
+  "tables", "runtime_parameters", "types", "functions", "divergence",
+  "emi_pruning", "message_orderings", "barriers", "output"
+};
+
+// Statement names. The array indices line up with eStatementType, and with
+// CLStatementType for the OpenCL statements.
+const char *const statement_names[MAX_STATEMENT_TYPE] = {
+  "assign", "block", "for", "if_else", "invoke", "return", "continue", "break",
+  "goto", "opencl", "array_op"
+};
+const char *const cl_statement_names[CLStatement::kMessage + 1] = {
+  "opencl", "barrier", "emi", "atomic_reduction", "fake_divergence", "atomic",
+  "comm", "message"
+};
+const char *const memory_space_names[MemoryBuffer::kConst + 1] = {
+  "global", "local", "private", "constant"
+};
+}  // namespace
+
+const char *GenerationContext::Statistics::GetPhaseName(Phase phase) {
+  return phase_names[phase];
+}
+
+void GenerationContext::Features::RecordStatement(const Statement& statement) {
+  if (statement.eType == eBlock) return;
+  const CLStatement *cl_statement =
+      dynamic_cast<const CLStatement *>(&statement);
+  const char *name = cl_statement ?
+      cl_statement_names[cl_statement->GetCLStatementType()] :
+      statement_names[statement.eType];
+  // Atomic reductions and the statements ending atomic sections are both
+  // kAtomic. Each atomic section ends with one statement setting its special
+  // value; the others add the section's variables to its result.
+  if (const StatementAtomicResult *result =
+      dynamic_cast<const StatementAtomicResult *>(&statement))
+    name = result->GetResultType() == StatementAtomicResult::kSetSpVal ?
+        "atomic_section" : "atomic_result";
+  else if (dynamic_cast<const StatementAtomicReduction *>(&statement))
+    name = "atomic_reduction";
+  ++statements[name];
+  std::vector<const Expression *> exprs;
+  statement.get_exprs(exprs);
+  for (const Expression *expr : exprs)
+    max_expr_depth = std::max(max_expr_depth, expr->get_complexity());
+}
+
+void GenerationContext::Features::RecordBlock(const Block& block) {
+  ++statements[statement_names[eBlock]];
+  max_block_depth = std::max(max_block_depth, block.get_blk_depth() + 1);
+}
+
+void GenerationContext::Features::RecordBuiltIn(const char *name) {
+  ++built_ins[name];
+}
+
+void GenerationContext::Features::RecordVector(int width) {
+  ++vector_widths[width];
+}
+
+void GenerationContext::Features::RecordMemoryBuffer(int memory_space) {
+  ++memory_buffers[memory_space_names[memory_space]];
+}
+
+GenerationContext *GenerationContext::CreateGenerationContext(
+    int argc, char **argv, unsigned long seed) {
+  assert(current_context == NULL && "Only one context per thread.");
+  std::unique_ptr<Arena> arena(new Arena());
+  Arena::set_current(arena.get());
+  // The expansion flags are changed while generating, and are per thread.
+  PartialExpander::restore_init_values();
+  AbsProgramGenerator *generator =
+      AbsProgramGenerator::CreateInstance(argc, argv, seed);
+  if (!generator) {
+    Arena::set_current(NULL);
+    return NULL;
+  }
+  current_context = new GenerationContext(std::move(arena), generator, seed);
+  return current_context;
+}
+
+GenerationContext::~GenerationContext() {
+  assert(current_context == this);
+  // CLSmith state first, as some of it refers to csmith types.
+  CLExpression::ReleaseProbabilityTable();
+  CLStatement::ReleaseProbabilityTable();
+  FunctionInvocationBuiltIn::ReleaseTables();
+  ExpressionID::Release();
+  ExpressionAtomic::ReleaseAtomics();
+  StatementAtomicReduction::ReleaseBuffers();
+  StatementComm::ReleaseBuffers();
+  MessagePassing::Release();
+  Globals::ReleaseGlobals();
+  EMIController::ReleaseEMIController();
+  Vector::ReleaseVectorTypes();
+  // Calls Finalization::doFinalization(), which deletes everything else.
+  delete generator_;
+  current_context = NULL;
+  // Anything left in the arena is freed with it.
+  Arena::set_current(NULL);
+}
+
+GenerationContext *GenerationContext::GetCurrent() {
+  assert(current_context != NULL);
+  return current_context;
+}
+
+GenerationContext::Features *GenerationContext::GetCurrentFeatures() {
+  return current_context ? &current_context->features_ : NULL;
+}
+
+}  // namespace CLSmith
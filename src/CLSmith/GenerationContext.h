@@ -0,0 +1,173 @@
+// Owns the lifetime of a single program generation run.
+//
+// Generating a program touches a lot of static state, both in csmith (the
+// random number generator, the output manager, the variable and type tables)
+// and in CLSmith (the probability tables, the vector types, the runtime
+// parameters and the various buffers created on start-up). The state stays
+// with the modules that use it, but creating a GenerationContext initialises
+// all of it for one seed, and deleting the context resets it again. This lets
+// a single process create, run and tear down CLProgramGenerator repeatedly:
+//
+//   for (seed ...) {
+//     std::unique_ptr<GenerationContext> ctx(
+//         GenerationContext::CreateGenerationContext(argc, argv, seed));
+//     CLProgramGenerator(seed, new CLOutputMgr(file)).goGenerator();
+//   }
+//
+// Only one context may exist at a time on each thread. Each thread has its own
+// copy of the per-run state, so several threads may generate programs at once.
+//
+// The context also owns the arena the nodes of the program are allocated in
+// (see Arena.h), which is current on the thread for as long as the context
+// exists, and freed with it.
+
+#ifndef _CLSMITH_GENERATIONCONTEXT_H_
+#define _CLSMITH_GENERATIONCONTEXT_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Arena.h"
+#include "CommonMacros.h"
+
+class AbsProgramGenerator;
+class Block;
+class Statement;
+
+namespace CLSmith {
+
+class GenerationContext {
+ public:
+  // Runtime parameters that the generated program decided upon. Filled in by
+  // CLProgramGenerator before any of the program is generated.
+  struct RuntimeParameters {
+    RuntimeParameters() : threads(1), groups(1) {}
+    std::vector<unsigned int> global_dims;
+    std::vector<unsigned int> local_dims;
+    unsigned int threads;
+    unsigned int groups;
+  };
+
+  // Figures about the generation run, filled in by CLProgramGenerator.
+  struct Statistics {
+    // The phases of CLProgramGenerator::goGenerator() that are timed.
+    enum Phase {
+      kTables = 0,  // Probability, vector and built-in function tables.
+      kRuntimeParameters,
+      kTypes,
+      kFunctions,
+      kDivergence,
+      kEMIPruning,
+      kMessageOrderings,
+      kBarriers,
+      kOutput,
+      kPhaseCount
+    };
+
+    Statistics()
+        : phase_seconds(), divergence_function_runs(0),
+          divergence_summaries_reused(0), random_draws(0),
+          filter_rejections(0), fixed_point_iterations(0),
+          statements_deleted(0) {}
+
+    // Name of a phase, as used in reports.
+    static const char *GetPhaseName(Phase phase);
+
+    // Time taken by each phase.
+    double phase_seconds[kPhaseCount];
+    // The number of times the divergence analysis processed a function, and
+    // the number of calls it did not have to process again.
+    unsigned long divergence_function_runs;
+    unsigned long divergence_summaries_reused;
+    // Numbers drawn from the random engine, and numbers drawn that a filter
+    // then rejected.
+    unsigned long random_draws;
+    unsigned long filter_rejections;
+    // Iterations of the fact analysis of blocks to reach a fixed point, and
+    // the statements it deleted because the analysis failed on them.
+    unsigned long fixed_point_iterations;
+    unsigned long statements_deleted;
+    // Statements of the program by the times the fact analysis visited them.
+    std::vector<unsigned long> statement_analyses;
+  };
+
+  // What the generated kernel is made of, so that a corpus of kernels can be
+  // filtered without reading their sources. Filled in as the program is
+  // output, so only what is left in the kernel is counted.
+  struct Features {
+    Features() : max_block_depth(0), max_expr_depth(0) {}
+
+    // Counts a statement, but not its blocks, which are counted when they are
+    // output themselves.
+    void RecordStatement(const Statement& statement);
+    void RecordBlock(const Block& block);
+    void RecordBuiltIn(const char *name);
+    void RecordVector(int width);
+    // The memory space is a MemoryBuffer::MemorySpace.
+    void RecordMemoryBuffer(int memory_space);
+
+    // Statements by kind, named after eStatementType ("assign", "for", ...),
+    // or after CLStatementType for the OpenCL statements ("barrier", ...).
+    // Every block output is counted as a "block". Atomic sections count as
+    // "atomic_section", and the statements adding their variables to the
+    // section's result as "atomic_result".
+    std::map<std::string, unsigned long> statements;
+    // Calls of each built-in function.
+    std::map<std::string, unsigned long> built_ins;
+    // Vector variables declared, by width.
+    std::map<int, unsigned long> vector_widths;
+    // Memory buffers, by address space ("global", "local", ...).
+    std::map<std::string, unsigned long> memory_buffers;
+    // The function bodies are at depth 1. The depth of an expression is its
+    // complexity, as in csmith's statistics.
+    int max_block_depth;
+    unsigned int max_expr_depth;
+  };
+
+  // Initialises csmith for generating a program from the given seed. The
+  // options must have been parsed and resolved already. Returns NULL if csmith
+  // fails to initialise.
+  static GenerationContext *CreateGenerationContext(
+      int argc, char **argv, unsigned long seed);
+
+  // Releases all the state used by the generation run, so that another context
+  // can be created.
+  ~GenerationContext();
+
+  // The context of the run in progress on this thread. Must not be called when
+  // there is none.
+  static GenerationContext *GetCurrent();
+
+  // The features of the kernel being generated on this thread, or NULL if
+  // there is no context, as when csmith generates a C program.
+  static Features *GetCurrentFeatures();
+
+  unsigned long GetSeed() const { return seed_; }
+  RuntimeParameters *GetRuntimeParameters() { return &runtime_parameters_; }
+  Statistics *GetStatistics() { return &statistics_; }
+  const Features& GetFeatures() const { return features_; }
+  const Arena& GetArena() const { return *arena_; }
+
+ private:
+  GenerationContext(std::unique_ptr<Arena> arena,
+      AbsProgramGenerator *generator, unsigned long seed)
+      : arena_(std::move(arena)), generator_(generator), seed_(seed) {
+  }
+
+  // Declared first, so that it is freed after everything else.
+  std::unique_ptr<Arena> arena_;
+  // The csmith generator, only used for its initialisation and finalization.
+  AbsProgramGenerator *generator_;
+  unsigned long seed_;
+  RuntimeParameters runtime_parameters_;
+  Statistics statistics_;
+  Features features_;
+
+  DISALLOW_COPY_AND_ASSIGN(GenerationContext);
+};
+
+}  // namespace CLSmith
+
+#endif  // _CLSMITH_GENERATIONCONTEXT_H_
@@ -9,6 +9,7 @@
 
 #include "ArrayVariable.h"
 #include "util.h"
+#include "CLSmith/GenerationContext.h"
 #include "CLSmith/MemoryBuffer.h"
 #include "CVQualifiers.h"
 #include "Expression.h"
@@ -21,7 +22,7 @@
 
 namespace CLSmith {
 namespace {
-Globals *globals_inst = NULL;  // Singleton instance.
+thread_local Globals *globals_inst = NULL;  // Singleton instance.
 }  // namespace
 
 void Globals::AddLocalMemoryBuffer(MemoryBuffer *buffer) {
@@ -69,8 +70,11 @@ void Globals::OutputStructDefinition(std::ostream& out) {
     var->OutputDecl(out);
     out << ";" << std::endl;
   }
+  GenerationContext::Features *features =
+      GenerationContext::GetCurrentFeatures();
   for (MemoryBuffer *buffer : buffers_) {
     if (buffer->collective) continue;
+    if (features) features->RecordMemoryBuffer(buffer->GetMemorySpace());
     output_tab(out, 1);
     buffer->OutputAliasDecl(out);
     out << ";" << std::endl;
@@ -15,12 +15,12 @@ namespace CLSmith {
   
 namespace {
 // Variable to store the value of a modified variable.
-Variable* hash_buffer = NULL;
+thread_local Variable* hash_buffer = NULL;
 
 // Variable representing the reduction target (either local or global);
 // if global, must be a buffer, indexing at the current linear group id.
-MemoryBuffer* local_reduction = NULL;
-MemoryBuffer* global_reduction = NULL;
+thread_local MemoryBuffer* local_reduction = NULL;
+thread_local MemoryBuffer* global_reduction = NULL;
 }
   
 StatementAtomicReduction* StatementAtomicReduction::make_random(CGContext &cg_context) {
@@ -60,6 +60,12 @@ MemoryBuffer* StatementAtomicReduction::get_global_rvar() {
   return global_reduction;
 }
 
+void StatementAtomicReduction::ReleaseBuffers() {
+  hash_buffer = NULL;
+  local_reduction = NULL;
+  global_reduction = NULL;
+}
+
 void StatementAtomicReduction::RecordBuffer() {
   Variable* buf = get_hash_buffer();
   if (buf != NULL)
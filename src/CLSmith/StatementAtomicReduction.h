@@ -49,6 +49,8 @@ class StatementAtomicReduction : public CLStatement {
   
   static void AddVarsToGlobals(Globals* globals);
   static void RecordBuffer();
+  // Forgets the lazily created buffers, so another program can be generated.
+  static void ReleaseBuffers();
         
   // Pure virtual methods from Statement
   void get_blocks(std::vector<const Block*>& blks) const {};
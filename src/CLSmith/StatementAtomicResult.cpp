@@ -1,6 +1,7 @@
 #include "CLSmith/StatementAtomicResult.h"
 #include "CLSmith/ExpressionAtomic.h"
 #include "CLSmith/CLStatement.h"
+#include "CLSmith/UseDefIndex.h"
 
 #include "Block.h"
 #include "Expression.h"
@@ -16,17 +17,24 @@
 namespace CLSmith {
   
 namespace {
-static std::map<int, const ExpressionAtomicAccess*>* atomic_blocks = NULL;
+static thread_local std::map<int, const ExpressionAtomicAccess*>* atomic_blocks = NULL;
 }
 
 void StatementAtomicResult::InitResults() {
   atomic_blocks = new std::map<int, const ExpressionAtomicAccess*>();
 }
+
+void StatementAtomicResult::ReleaseResults() {
+  delete atomic_blocks;
+  atomic_blocks = NULL;
+}
   
 void StatementAtomicResult::GenSpecialVals() {
+  UseDefIndex* index = UseDefIndex::GetUseDefIndex();
   for (Function* f : get_all_functions()) {
     for (Block* b : f->blocks) {
       if (atomic_blocks->find(b->stm_id) != atomic_blocks->end()) {
+        size_t first_new = b->stms.size();
         StatementAtomicResult* sar_decl = new StatementAtomicResult(b);
         b->stms.push_back(sar_decl);
         for (Variable* v : b->local_vars) {
@@ -61,7 +69,7 @@ void StatementAtomicResult::GenSpecialVals() {
                 do {
                   curr_index[index] = accesses[index];
                   index--;
-                } while (curr_index[index] == 0);
+                } while (index >= 0 && curr_index[index] == 0);
                 if (index < 0) break;
                 curr_index[index]--;
                 index = curr_index.size() - 1;
@@ -79,6 +87,10 @@ void StatementAtomicResult::GenSpecialVals() {
         }
         StatementAtomicResult* sar_sv = new StatementAtomicResult((*atomic_blocks->find(b->stm_id)).second, b);
         b->stms.push_back(sar_sv);
+        // The variables added to the result are now used.
+        if (index != NULL)
+          for (size_t i = first_new; i < b->stms.size(); i++)
+            index->AddStatement(b->stms[i]);
       }
     }
   }
@@ -39,6 +39,7 @@ class StatementAtomicResult : public CLStatement {
     var_(NULL), av_(NULL), access_(NULL), result_type_(kDecl), type_(Type::get_simple_type(eInt)) {}
   
   static void InitResults(void);
+  static void ReleaseResults(void);
   static void DefineLocalResultVar(std::ostream& out);
   static void GenSpecialVals(void);
   static void RecordIfID(int id, Expression* expr);
@@ -46,6 +47,13 @@ class StatementAtomicResult : public CLStatement {
   // Pure virtual methods from Statement (need only Output)
   void get_blocks(std::vector<const Block*>&) const {};
   void get_exprs(std::vector<const Expression*>&) const {};
+
+  AtomicResultType GetResultType() const { return result_type_; }
+
+  // The variable or array added to the result, or NULL for the other kinds.
+  const Variable* GetVariable() const {
+    return var_ != NULL ? var_ : av_;
+  }
   
   void Output(std::ostream& out, FactMgr* fm = 0, int indent = 0) const;
   
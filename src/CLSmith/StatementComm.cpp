@@ -10,6 +10,7 @@
 #include "CLSmith/CLOptions.h"
 #include "CLSmith/CLProgramGenerator.h" // temp
 #include "CLSmith/ExpressionID.h"
+#include "CLSmith/GenerationContext.h"
 #include "CLSmith/Globals.h"
 #include "CLSmith/MemoryBuffer.h"
 #include "CLSmith/StatementBarrier.h"
@@ -30,19 +31,19 @@ namespace {
 const int kPermCount = 10;
 
 // Const buffer that holds the random permutations of [0..31].
-MemoryBuffer *permutations;
+thread_local MemoryBuffer *permutations;
 // Each permutation.
-std::vector<int> *permute_values[kPermCount];
+thread_local std::vector<int> *permute_values[kPermCount];
 // Local buffer that holds the intermediate values.
-MemoryBuffer *local_values;
+thread_local MemoryBuffer *local_values;
 // Global buffer that holds the intermediate values.
-MemoryBuffer *global_values;
+thread_local MemoryBuffer *global_values;
 // Variable that holds the random thread ID.
-Variable *tid;
+thread_local Variable *tid;
 // Local Variable used in random expressions throughout the program.
-MemoryBuffer *local_var;
+thread_local MemoryBuffer *local_var;
 // Global Variable used in random expressions throughout the program.
-MemoryBuffer *global_var;
+thread_local MemoryBuffer *global_var;
 }  // namespace
 
 StatementComm *StatementComm::make_random(CGContext& cg_context) {
@@ -123,7 +124,23 @@ void StatementComm::InitBuffers() {
   }
 }
 
+void StatementComm::ReleaseBuffers() {
+  for (int idx = 0; idx < kPermCount; ++idx) {
+    delete permute_values[idx];
+    permute_values[idx] = NULL;
+  }
+  permutations = NULL;
+  local_values = NULL;
+  global_values = NULL;
+  tid = NULL;
+  local_var = NULL;
+  global_var = NULL;
+}
+
 void StatementComm::OutputPermutations(std::ostream& out) {
+  GenerationContext::Features *features =
+      GenerationContext::GetCurrentFeatures();
+  if (features) features->RecordMemoryBuffer(permutations->GetMemorySpace());
   permutations->OutputDecl(out);
   out << " = {" << std::endl;
   for (int idx = 0; idx < kPermCount; ++idx) {
@@ -41,6 +41,9 @@ class StatementComm : public CLStatement {
   // Creates the buffers used to hold thread IDs and intermediate values.
   static void InitBuffers();
 
+  // Forgets the buffers created by InitBuffers.
+  static void ReleaseBuffers();
+
   // Outputs the memory buffer holding the permutations.
   // TODO move to globals.h.
   static void OutputPermutations(std::ostream& out);
@@ -54,9 +57,11 @@ class StatementComm : public CLStatement {
   static void HashCommValues(std::ostream& out);
   static void HashCommValuesGlobalBuffer(std::ostream& out);
 
-  // Pure virtual in Statement. Not really needed.
+  // Pure virtual in Statement. The expressions are those of the assignment.
   void get_blocks(std::vector<const Block *>& blks) const {}
-  void get_exprs(std::vector<const Expression *>& exps) const {}  // TODO
+  void get_exprs(std::vector<const Expression *>& exps) const {
+    assign_->get_exprs(exps);
+  }
 
   // Outputs the barrier followed by the assignment.
   void Output(std::ostream& out, FactMgr *fm, int indent) const;
@@ -19,12 +19,13 @@
 
 namespace CLSmith {
 namespace {
-EMIController *emi_controller_inst = NULL;  // Singleton instance.
+thread_local EMIController *emi_controller_inst = NULL;  // Singleton instance.
+// Next free index into the EMI input buffer.
+thread_local int item_count = 0;
 }  // namespace
 
 StatementEMI *StatementEMI::make_random(CGContext& cg_context) {
   // TODO, better exprs, for now, just do 0>1, 2>3, etc.
-  static int item_count = 0;
   assert(item_count < 1024);
   MemoryBuffer *emi_input = EMIController::GetEMIController()->GetEMIInput();
 //   MemoryBuffer *item1 = emi_input->itemize({item_count++});
@@ -158,8 +159,8 @@ void StatementEMI::PruneBlock(Block *block) {
 
 std::vector<Statement *>::iterator StatementEMI::MergeBlock(
     std::vector<Statement *>::iterator position, Block *former, Block *merger) {
-  former->local_vars.insert(former->local_vars.end(),
-      merger->local_vars.begin(), merger->local_vars.end());
+  former->local_vars.append(merger->local_vars.begin(),
+      merger->local_vars.end());
   for (Statement *st : merger->deleted_stms) st->parent = former;
   former->deleted_stms.insert(former->deleted_stms.end(),
       merger->deleted_stms.begin(), merger->deleted_stms.end());
@@ -204,6 +205,7 @@ EMIController *EMIController::GetEMIController() {
 void EMIController::ReleaseEMIController() {
   delete emi_controller_inst;
   emi_controller_inst = NULL;
+  item_count = 0;
 }
 
 EMIController *EMIController::CreateEMIController() {
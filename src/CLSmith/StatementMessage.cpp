@@ -35,19 +35,33 @@ namespace CLSmith {
 namespace MessagePassing {
 namespace {
 // Local memory buffer for the messages.
-MemoryBuffer *message_buf;
+thread_local MemoryBuffer *message_buf;
 // Holds all the messages used in the program. Will probably never deallocate.
-std::vector<Message *> *messages;
+thread_local std::vector<Message *> *messages;
 // The message type of all the messages.
-Type *message_type;
+thread_local Type *message_type;
 }  // namespace
 
+bool ConstraintLess::operator()(
+    const Constraint& lhs, const Constraint& rhs) const {
+  if (lhs.first->name != rhs.first->name)
+    return lhs.first->name < rhs.first->name;
+  return lhs.second < rhs.second;
+}
+
 void Initialise() {
   messages = new std::vector<Message *>();
   // Message type will be created lazily, after all the other initialisation
   // has occured. // TODO
 }
 
+void Release() {
+  delete messages;
+  messages = NULL;
+  message_buf = NULL;
+  message_type = NULL;
+}
+
 void OutputMessageType(std::ostream& out) {
   if (message_type != NULL) OutputStructUnion(message_type, out);
 }
@@ -156,13 +170,14 @@ void Message::CreateOrdering() {
   // The graph is complete now, so we need to make the constraints each node
   // must wait for before it can update.
   using MessagePassing::Constraint;
+  using MessagePassing::ConstraintSet;
   using MessagePassing::MakeConstraint;
   // Constraint values for the flags. We have two pairs, as if we have two async
   // nodes, they must signal differenet flags to prevent interfering.
   int flag1 = 0, flag2 = 0, flag3 = 0, flag4 = 0;
   // Map from the nodes to the set of constraints to check for and set.
   std::map<Node, std::vector<
-      std::pair<std::set<Constraint>,std::set<Constraint>>>> unlock_map;
+      std::pair<ConstraintSet,ConstraintSet>>> unlock_map;
   // Variable objects corresponding to the flags in the message.
   Variable *fvar1 = message_var_->field_vars[0];
   Variable *fvar2 = message_var_->field_vars[1];
@@ -178,7 +193,7 @@ void Message::CreateOrdering() {
   for (; node_it != nodes_order_.end(); ++node_it) {
     std::set<Node> async;
     GetAsynchronousNodes(*node_it, &async);
-    std::set<Constraint> constraints;
+    ConstraintSet constraints;
     constraints.insert(SelectConstraint(fvar1, flag1, fvar3, flag3));
     if (previous.size() == 0 || previous.size() == 2)
       constraints.insert(SelectConstraint(fvar2, flag2, fvar4, flag4));
@@ -189,7 +204,7 @@ void Message::CreateOrdering() {
     flag_set = flip_flag_set ? (flag_set ? 0 : 1) : flag_set;
     // Each async node must check all the constraints, but signal only one.
     Node node = *node_it;
-    std::set<Constraint> checks = constraints;
+    ConstraintSet checks = constraints;
     if (flip_flag_set)
       checks.insert(SelectConstraint(fvar1, flag1, fvar3, flag3));
     Constraint signal = SelectConstraint(fvar1, ++flag1, fvar3, ++flag3);
@@ -199,9 +214,9 @@ void Message::CreateOrdering() {
     std::vector<Node>::iterator sb_it = GetsbIterator(node) + 1;
     for (; sb_it != sb_graph_[node->Gettid()].end(); ++sb_it)
       unlock_map[*sb_it].push_back(
-          std::make_pair(checks, std::set<Constraint>({signal})));
+          std::make_pair(checks, ConstraintSet({signal})));
     end_checks_[node->Gettid()].push_back(
-        std::make_pair(checks, std::set<Constraint>({signal})));
+        std::make_pair(checks, ConstraintSet({signal})));
     if (async.size() == 2) {
       node = *async.rbegin();
       if (node == *node_it) node = *async.begin();
@@ -215,9 +230,9 @@ void Message::CreateOrdering() {
       sb_it = GetsbIterator(node) + 1;
       for (; sb_it != sb_graph_[node->Gettid()].end(); ++sb_it)
         unlock_map[*sb_it].push_back(
-            std::make_pair(checks, std::set<Constraint>({signal})));
+            std::make_pair(checks, ConstraintSet({signal})));
       end_checks_[node->Gettid()].push_back(
-          std::make_pair(checks, std::set<Constraint>({signal})));
+          std::make_pair(checks, ConstraintSet({signal})));
     }
     previous = async;
   }
@@ -355,8 +370,8 @@ void Message::OutputEndChecks(std::ostream& out) {
     output_tab(out, 2);
     out << "for (;;) {" << std::endl;
     StatementMemFence(NULL).Output(out, NULL, 3);
-    for (const std::pair<std::set<MessagePassing::Constraint>,
-                         std::set<MessagePassing::Constraint>>& lock :
+    for (const std::pair<MessagePassing::ConstraintSet,
+                         MessagePassing::ConstraintSet>& lock :
         tid_it->second) {
       Block *block = new Block(NULL, 0);
       StatementMessage::MakeConstraintUpdate(lock.second, block);
@@ -367,7 +382,7 @@ void Message::OutputEndChecks(std::ostream& out) {
     // Break out if the constraints for the final unlock and the signal have
     // been exceeded.
     const auto& last_unlock = tid_it->second.back();
-    std::set<MessagePassing::Constraint> break_checks = last_unlock.first;
+    MessagePassing::ConstraintSet break_checks = last_unlock.first;
     break_checks.insert(last_unlock.second.begin(), last_unlock.second.end());
     Block dummy(NULL, 0);  // StatementBreak needs this, but doesn't use it :/
     Expression *break_out =
@@ -400,7 +415,6 @@ std::vector<StatementMessage *>::iterator Message::GetsbIterator(Node node) {
 StatementMessage *StatementMessage::make_random(CGContext& cg_context) {
   Message *message = MessagePassing::RandomMessage();
   unsigned int tid_max = CLProgramGenerator::get_threads_per_group();
-  std::cout << tid_max << std::endl; // TODO deleteme
   // Limit threads to at most 5.
   if (tid_max > 5) tid_max = 5;
   StatementMessage *st_msg = new StatementMessage(
@@ -410,10 +424,10 @@ StatementMessage *StatementMessage::make_random(CGContext& cg_context) {
 }
 
 void StatementMessage::MakeWait(
-    const std::vector<std::pair<std::set<MessagePassing::Constraint>,
-                                std::set<MessagePassing::Constraint>>>& unlocks,
-    const std::set<MessagePassing::Constraint>& constraints,
-    const std::set<MessagePassing::Constraint>& signals) {
+    const std::vector<std::pair<MessagePassing::ConstraintSet,
+                                MessagePassing::ConstraintSet>>& unlocks,
+    const MessagePassing::ConstraintSet& constraints,
+    const MessagePassing::ConstraintSet& signals) {
   assert(!wait_ && "wait_ already initialised.");
   wait_.reset(new Block(parent, 0));
   // First stage is to synchronise the message.
@@ -421,14 +435,14 @@ void StatementMessage::MakeWait(
   wait_->stms.push_back(new StatementMemFence(wait_.get()));
   // Break out quick if already passed by checking the constraints and signals.
   // There will be some overlap on the constraints, which is acceptable.
-  std::set<MessagePassing::Constraint> early_break = constraints;
+  MessagePassing::ConstraintSet early_break = constraints;
   early_break.insert(signals.begin(), signals.end());
   wait_->stms.push_back(new StatementBreak(
       wait_.get(), *MakeConstraintCheck(eCmpGe, early_break), *wait_.get()));
   // Check for the conditions of each unlock, and set the unlock constraint.
   // These are not StatementIfs, they should be small and have no false branch.
-  for (const std::pair<std::set<MessagePassing::Constraint>,
-                       std::set<MessagePassing::Constraint>>& lock : unlocks) {
+  for (const std::pair<MessagePassing::ConstraintSet,
+                       MessagePassing::ConstraintSet>& lock : unlocks) {
     Block *block = new Block(wait_.get(), 0);
     MakeConstraintUpdate(lock.second, block);
     wait_->stms.push_back(new CompactIf(
@@ -461,7 +475,7 @@ void StatementMessage::MakeUpdate() {
 }
 
 void StatementMessage::MakeSignal(
-    const std::set<MessagePassing::Constraint>& constraints) {
+    const MessagePassing::ConstraintSet& constraints) {
   assert(!signal_ && "signal_ already initialised.");
   signal_.reset(new Block(parent, 0));
   MakeConstraintUpdate(constraints, signal_.get());
@@ -529,9 +543,9 @@ void StatementMessage::Output(std::ostream& out, FactMgr *fm, int indent) const
 }
 
 Expression *StatementMessage::MakeConstraintCheck(int binary_op,
-    const std::set<MessagePassing::Constraint>& check) {
+    const MessagePassing::ConstraintSet& check) {
   eBinaryOps op = static_cast<eBinaryOps>(binary_op);
-  std::set<MessagePassing::Constraint>::iterator check_it = check.begin();
+  MessagePassing::ConstraintSet::iterator check_it = check.begin();
   Expression *expr = new ExpressionFuncall(*new FunctionInvocationBinary(op,
       new ExpressionVariable(*check_it->first),
       Constant::make_int(check_it->second), NULL));
@@ -545,7 +559,7 @@ Expression *StatementMessage::MakeConstraintCheck(int binary_op,
 }
 
 void StatementMessage::MakeConstraintUpdate(
-    const std::set<MessagePassing::Constraint>& updates, Block *block) {
+    const MessagePassing::ConstraintSet& updates, Block *block) {
   for (const MessagePassing::Constraint& update : updates)
     block->stms.push_back(new StatementAssign(
         block, *new Lhs(*update.first), *Constant::make_int(update.second)));
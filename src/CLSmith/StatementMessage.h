@@ -44,9 +44,19 @@ inline Constraint MakeConstraint(Variable *flag, int value) {
   return std::make_pair(flag, value);
 }
 
+// Orders constraints by the name of the flag instead of its address, so the
+// generated program does not depend on where the flags were allocated.
+struct ConstraintLess {
+  bool operator()(const Constraint& lhs, const Constraint& rhs) const;
+};
+typedef std::set<Constraint, ConstraintLess> ConstraintSet;
+
 // Initialises the message passing data.
 void Initialise();
 
+// Forgets the message passing data, so another program can be generated.
+void Release();
+
 // Print the type of message_t.
 void OutputMessageType(std::ostream& out);
 
@@ -130,8 +140,8 @@ class Message {
   std::map<Node, std::set<Node>> nodes_async_;
   // Check to be performed for each thread when it reaches the end.
   std::map<size_t, std::vector<std::pair<
-      std::set<MessagePassing::Constraint>,
-      std::set<MessagePassing::Constraint>>>> end_checks_;
+      MessagePassing::ConstraintSet,
+      MessagePassing::ConstraintSet>>> end_checks_;
 
   DISALLOW_COPY_AND_ASSIGN(Message);
 };
@@ -177,12 +187,12 @@ class StatementMessage : public CLStatement {
   //   f = strcat(x, y)  (e.g. x << 4 + y, with 0 <= y < 16)
   // Currently uses the first choice.
   void MakeWait(const std::vector<std::pair<
-      std::set<MessagePassing::Constraint>,
-      std::set<MessagePassing::Constraint>>>& unlocks,
-      const std::set<MessagePassing::Constraint>& constraints,
-      const std::set<MessagePassing::Constraint>& signals);
+      MessagePassing::ConstraintSet,
+      MessagePassing::ConstraintSet>>& unlocks,
+      const MessagePassing::ConstraintSet& constraints,
+      const MessagePassing::ConstraintSet& signals);
   void MakeUpdate();
-  void MakeSignal(const std::set<MessagePassing::Constraint>& constraints);
+  void MakeSignal(const MessagePassing::ConstraintSet& constraints);
 
   // Like MakeUpdate, only the update occurs at the same time as another, so
   // the set of variable in the message must be distinct.
@@ -207,10 +217,10 @@ class StatementMessage : public CLStatement {
   // Helpers for creating the actual statements.
   // Creates an Expression that checks whether all the constraints hold.
   static Expression *MakeConstraintCheck(int binary_op,
-      const std::set<MessagePassing::Constraint>& check);
+      const MessagePassing::ConstraintSet& check);
   // Creates an assignment for each constraint and appends the to block.
   static void MakeConstraintUpdate(
-      const std::set<MessagePassing::Constraint>& updates, Block *block);
+      const MessagePassing::ConstraintSet& updates, Block *block);
 
  private:
   Message *message_;
@@ -0,0 +1,244 @@
+#include "CLSmith/UseDefIndex.h"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "ArrayVariable.h"
+#include "Block.h"
+#include "CLSmith/CLExpression.h"
+#include "CLSmith/ExpressionVector.h"
+#include "CLSmith/StatementAtomicResult.h"
+#include "Expression.h"
+#include "ExpressionAssign.h"
+#include "ExpressionComma.h"
+#include "ExpressionFuncall.h"
+#include "ExpressionVariable.h"
+#include "Function.h"
+#include "FunctionInvocation.h"
+#include "Lhs.h"
+#include "Statement.h"
+#include "StatementArrayOp.h"
+#include "StatementAssign.h"
+#include "StatementBreak.h"
+#include "StatementContinue.h"
+#include "StatementExpr.h"
+#include "StatementFor.h"
+#include "StatementGoto.h"
+#include "StatementIf.h"
+#include "StatementReturn.h"
+#include "Variable.h"
+
+namespace CLSmith {
+namespace {
+thread_local UseDefIndex *use_def_index_inst = NULL;  // Singleton instance.
+}  // namespace
+
+UseDefIndex *UseDefIndex::GetUseDefIndex() {
+  return use_def_index_inst;
+}
+
+void UseDefIndex::BuildUseDefIndex() {
+  assert(use_def_index_inst == NULL);
+  use_def_index_inst = new UseDefIndex();
+  for (Function *function : get_all_functions())
+    for (Block *block : function->blocks)
+      use_def_index_inst->AddBlock(block);
+}
+
+void UseDefIndex::ReleaseUseDefIndex() {
+  delete use_def_index_inst;
+  use_def_index_inst = NULL;
+}
+
+const std::vector<UseDefIndex::Access>& UseDefIndex::GetAccesses(
+    const Variable *var) const {
+  static const std::vector<Access> no_accesses;
+  auto it = accesses_.find(var);
+  return it == accesses_.end() ? no_accesses : it->second;
+}
+
+void UseDefIndex::RemoveStatement(const Statement *statement) {
+  RemoveAccesses(statement);
+}
+
+void UseDefIndex::RemoveBlock(const Block *block) {
+  for (const Variable *var : block->local_vars) RemoveAccesses(var);
+  for (const Statement *statement : block->stms) RemoveAccesses(statement);
+}
+
+void UseDefIndex::AddBlock(const Block *block) {
+  for (const Variable *var : block->local_vars) {
+    if (var->init != NULL) AddExpression(NULL, var, var->init);
+    if (!var->isArray) continue;
+    // The rest of the initialiser of an array.
+    for (const Expression *init :
+        dynamic_cast<const ArrayVariable *>(var)->get_init_values())
+      AddExpression(NULL, var, init);
+  }
+  for (const Statement *statement : block->stms) AddStatement(statement);
+}
+
+void UseDefIndex::AddStatement(const Statement *statement) {
+  switch (statement->eType) {
+    case eAssign: {
+      const StatementAssign *st_ass =
+          dynamic_cast<const StatementAssign *>(statement);
+      AddAccess(statement, NULL, st_ass->get_lhs(),
+          st_ass->get_lhs()->get_var(), true);
+      AddExpression(statement, NULL, st_ass->get_expr());
+      break;
+    }
+    case eReturn: {
+      const StatementReturn *st_ret =
+          dynamic_cast<const StatementReturn *>(statement);
+      AddAccess(statement, NULL, st_ret->get_var(),
+          st_ret->get_var()->get_var(), false);
+      break;
+    }
+    case eFor: {
+      const StatementFor *st_for =
+          dynamic_cast<const StatementFor *>(statement);
+      const StatementAssign *init = st_for->get_init();
+      const StatementAssign *incr = st_for->get_incr();
+      AddAccess(statement, NULL, init->get_lhs(),
+          init->get_lhs()->get_var(), true);
+      AddExpression(statement, NULL, init->get_expr());
+      AddExpression(statement, NULL, st_for->get_test());
+      AddAccess(statement, NULL, incr->get_lhs(),
+          incr->get_lhs()->get_var(), true);
+      AddExpression(statement, NULL, incr->get_expr());
+      break;
+    }
+    case eIfElse:
+      AddExpression(statement, NULL,
+          dynamic_cast<const StatementIf *>(statement)->get_test());
+      break;
+    case eInvoke:
+      AddExpression(statement, NULL,
+          dynamic_cast<const StatementExpr *>(statement)->get_call());
+      break;
+    case eContinue:
+      AddExpression(statement, NULL,
+          &dynamic_cast<const StatementContinue *>(statement)->test);
+      break;
+    case eBreak:
+      AddExpression(statement, NULL,
+          &dynamic_cast<const StatementBreak *>(statement)->test);
+      break;
+    case eGoto:
+      AddExpression(statement, NULL,
+          &dynamic_cast<const StatementGoto *>(statement)->test);
+      break;
+    case eArrayOp: {
+      const StatementArrayOp *st_arr =
+          dynamic_cast<const StatementArrayOp *>(statement);
+      for (const Variable *ctrl_var : st_arr->ctrl_vars)
+        AddAccess(statement, NULL, NULL, ctrl_var, true);
+      AddAccess(statement, NULL, NULL, st_arr->array_var,
+          st_arr->init_value != NULL);
+      if (st_arr->init_value != NULL)
+        AddExpression(statement, NULL, st_arr->init_value);
+      break;
+    }
+    case eCLStatement: {
+      std::vector<const Expression *> exprs;
+      statement->get_exprs(exprs);
+      for (const Expression *expr : exprs)
+        AddExpression(statement, NULL, expr);
+      const StatementAtomicResult *st_res =
+          dynamic_cast<const StatementAtomicResult *>(statement);
+      if (st_res != NULL && st_res->GetVariable() != NULL)
+        AddAccess(statement, NULL, NULL, st_res->GetVariable(), false);
+      break;
+    }
+    case eBlock:
+      break;
+    default:
+      assert(false);
+  }
+}
+
+void UseDefIndex::AddExpression(const Statement *statement,
+    const Variable *declaration, const Expression *expression) {
+  switch (expression->term_type) {
+    case eVariable:
+      AddAccess(statement, declaration, expression,
+          dynamic_cast<const ExpressionVariable *>(expression)->get_var(),
+          false);
+      break;
+    case eFunction:
+      for (const Expression *param : dynamic_cast<const ExpressionFuncall *>(
+          expression)->get_invoke()->param_value)
+        AddExpression(statement, declaration, param);
+      break;
+    case eAssignment: {
+      const ExpressionAssign *expr_ass =
+          dynamic_cast<const ExpressionAssign *>(expression);
+      AddAccess(statement, declaration, expression,
+          expr_ass->get_lhs()->get_var(), true);
+      AddExpression(statement, declaration, expr_ass->get_rhs());
+      break;
+    }
+    case eCLExpression: {
+      // Other than vectors, the CLExpressions only refer to variables of their
+      // own.
+      const CLExpression *cl_expr =
+          dynamic_cast<const CLExpression *>(expression);
+      if (cl_expr->GetCLExpressionType() != CLExpression::kVector) break;
+      for (const std::unique_ptr<const Expression>& expr :
+          dynamic_cast<const ExpressionVector *>(expression)->GetExpressions())
+        AddExpression(statement, declaration, expr.get());
+      break;
+    }
+    case eCommaExpr: {
+      const ExpressionComma *expr_comma =
+          dynamic_cast<const ExpressionComma *>(expression);
+      AddExpression(statement, declaration, expr_comma->get_lhs());
+      AddExpression(statement, declaration, expr_comma->get_rhs());
+      break;
+    }
+    case eConstant:
+    case eLhs:
+      break;
+    default:
+      assert(false);
+  }
+}
+
+void UseDefIndex::AddAccess(const Statement *statement,
+    const Variable *declaration, const Expression *expression,
+    const Variable *var, bool write) {
+  // Accesses to array elements and struct fields are accesses to the variable
+  // they are part of, and read the variables in the array indices.
+  const Variable *container = var->get_top_container();
+  if (container->isArray)
+    for (const Expression *index :
+        dynamic_cast<const ArrayVariable *>(container)->get_indices())
+      AddExpression(statement, declaration, index);
+  var = var->get_named_var();
+  accesses_[var].push_back({statement, declaration, expression, write});
+  const void *accessor = statement != NULL ?
+      static_cast<const void *>(statement) : declaration;
+  std::vector<const Variable *> *accessed = &accessed_[accessor];
+  if (std::find(accessed->begin(), accessed->end(), var) == accessed->end())
+    accessed->push_back(var);
+}
+
+void UseDefIndex::RemoveAccesses(const void *accessor) {
+  auto accessed_it = accessed_.find(accessor);
+  if (accessed_it == accessed_.end()) return;
+  for (const Variable *var : accessed_it->second) {
+    std::vector<Access> *accesses = &accesses_[var];
+    accesses->erase(std::remove_if(accesses->begin(), accesses->end(),
+        [accessor](const Access& access) {
+          return access.statement == accessor ||
+              (access.statement == NULL && access.declaration == accessor);
+        }), accesses->end());
+  }
+  accessed_.erase(accessed_it);
+}
+
+}  // namespace CLSmith
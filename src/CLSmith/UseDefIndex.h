@@ -0,0 +1,89 @@
+// Index of where each variable of the program is used and defined.
+//
+// The index is built once the functions of the program have been generated,
+// by going over the statements of every block of every function, and the
+// initialisers of the local variables. Each variable is mapped to the
+// statements and expressions that read or write it, or any of its array
+// elements and struct fields. Block::remove_stmt() keeps it up to date when
+// statements are removed afterwards, such as by EMI pruning, and the passes
+// that add statements afterwards, such as the atomic section results, add them
+// to it, so that any later pass can query it instead of walking the program
+// again.
+//
+// The CLStatements (barriers, atomic reductions, messages, etc.) are indexed
+// through their expressions, and the variables added to the result of the
+// atomic sections; the blocks nested in them are indexed as any other block.
+
+#ifndef _CLSMITH_USEDEFINDEX_H_
+#define _CLSMITH_USEDEFINDEX_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "CommonMacros.h"
+
+class Block;
+class Expression;
+class Statement;
+class Variable;
+
+namespace CLSmith {
+
+class UseDefIndex {
+ public:
+  // A single use or definition of a variable. Uses in the initialiser of a
+  // local variable have no statement, but the declared variable instead.
+  struct Access {
+    const Statement *statement;
+    const Variable *declaration;
+    const Expression *expression;
+    bool write;
+  };
+
+  // Accessors for the index of the program being generated on this thread.
+  // GetUseDefIndex() returns NULL if it has not been built.
+  static UseDefIndex *GetUseDefIndex();
+  static void BuildUseDefIndex();
+  static void ReleaseUseDefIndex();
+
+  // All the uses and definitions of a variable, in no particular order.
+  const std::vector<Access>& GetAccesses(const Variable *var) const;
+  // Whether the variable is used or defined anywhere in the program.
+  bool IsReferenced(const Variable *var) const {
+    return !GetAccesses(var).empty();
+  }
+
+  // Records the accesses of a statement added to the program after the index
+  // was built. The blocks nested in it are added separately.
+  void AddStatement(const Statement *statement);
+  // Drops the accesses of a statement that is no longer in the program. The
+  // blocks nested in it are removed separately.
+  void RemoveStatement(const Statement *statement);
+  // Drops the accesses of all the statements of a block, and of the
+  // initialisers of its local variables.
+  void RemoveBlock(const Block *block);
+
+ private:
+  UseDefIndex() {}
+
+  void AddBlock(const Block *block);
+  // Records the variables referenced in an expression, as read, except for
+  // the left hand side of assignments.
+  void AddExpression(const Statement *statement, const Variable *declaration,
+      const Expression *expression);
+  void AddAccess(const Statement *statement, const Variable *declaration,
+      const Expression *expression, const Variable *var, bool write);
+  // Removes the accesses made by the given statement or declaration.
+  void RemoveAccesses(const void *accessor);
+
+  std::unordered_map<const Variable *, std::vector<Access>> accesses_;
+  // The variables accessed by each statement or declaration, for removing
+  // them.
+  std::unordered_map<const void *, std::vector<const Variable *>> accessed_;
+
+  DISALLOW_COPY_AND_ASSIGN(UseDefIndex);
+};
+
+}  // namespace CLSmith
+
+#endif  // _CLSMITH_USEDEFINDEX_H_
@@ -11,6 +11,7 @@
 #include "Block.h"
 #include "CGContext.h"
 #include "CLSmith/CLOptions.h"
+#include "CLSmith/GenerationContext.h"
 #include "Constant.h"
 #include "random.h"
 #include "Type.h"
@@ -37,7 +38,7 @@ const char *const kEvenStr = "even";
 const char *const kOddStr = "odd";
 }  // namespace
 
-std::map<std::pair<enum eSimpleType, unsigned>, const Type *>
+thread_local std::map<std::pair<enum eSimpleType, unsigned>, const Type *>
     Vector::vector_types_;
 
 Vector *Vector::CreateVectorVariable(const CGContext& cg_context, Block *blk,
@@ -133,6 +134,9 @@ void Vector::OutputDef(std::ostream& out, int indent) const {
 }
 
 void Vector::OutputDecl(std::ostream& out) const {
+  GenerationContext::Features *features =
+      GenerationContext::GetCurrentFeatures();
+  if (features) features->RecordVector(sizes[0]);
   // Trying to print all qualifiers prints the type as well. We don't allow
   // vector pointers regardless.
   qfer.OutputFirstQuals(out);
@@ -241,6 +245,11 @@ void Vector::GenerateVectorTypes() {
   }
 }
 
+void Vector::ReleaseVectorTypes() {
+  for (const auto& vector_type : vector_types_) delete vector_type.second;
+  vector_types_.clear();
+}
+
 ArrayVariable *itemize_simd_hook(const ArrayVariable *av, int access_count) {
   const Vector *vec = dynamic_cast<const Vector *>(av);
   assert(vec != NULL);
@@ -110,6 +110,9 @@ class Vector : public ArrayVariable {
   // Must be called on startup, generates all the vector types.
   static void GenerateVectorTypes();
 
+  // Deletes the vector types created by GenerateVectorTypes.
+  static void ReleaseVectorTypes();
+
  private:
   // Keeps track of multiple accesses in a single itemisation.
   // e.g. 'vec.wy' will be {3, 1}
@@ -118,8 +121,8 @@ class Vector : public ArrayVariable {
   // All vector types. These will be pre-generated, as many of the functions
   // that check for type compatibilities between variables rely on the types
   // being identical.
-  static std::map<std::pair<enum eSimpleType, unsigned>, const Type *>
-      vector_types_;
+  static thread_local std::map<std::pair<enum eSimpleType, unsigned>,
+                               const Type *> vector_types_;
 };
 
 }  // namespace CLSmith
@@ -22,7 +22,9 @@ BlockWalker *CreateBlockWalker(Block *block) {
 
 BlockWalker *CreateBlockWalkerAtStatement(Block *block, Statement *statement) {
   std::unique_ptr<BlockWalker> block_walker(new BlockWalker(block));
-  assert(block_walker->AdvanceToStatement(statement));
+  bool found = block_walker->AdvanceToStatement(statement);
+  assert(found && "Statement is not in the block.");
+  (void)found;
   block_walker->AdvanceSelector(statement);
   return block_walker.release();
 }
@@ -225,7 +227,9 @@ bool FunctionWalker::Advance() {
     }
     // Advance if we enter the else block. As long as there are no empty blocks,
     // we should not have to do anything else.
-    assert(block_walker_->AdvanceBlock());
+    bool advanced = block_walker_->AdvanceBlock();
+    assert(advanced);
+    (void)advanced;
   }
 
   return true;
@@ -250,7 +254,9 @@ bool FunctionWalker::Next() {
       assert(block_walker_->WalkerImpl<eIfElse>::if_body_.get() == NULL);
       EnterBranch(block_walker_->WalkerImpl<eIfElse>::else_body_.release());
       ++blocks_entered_;
-      assert(block_walker_->AdvanceBlock());
+      bool advanced = block_walker_->AdvanceBlock();
+      assert(advanced);
+      (void)advanced;
       break;
     }
   }
@@ -1,5 +1,12 @@
 // Runs a randomly generated program on a device via OpenCL.
 // Usage: cl_launcher <cl_program> <platform_id> <device_id> [flags...]
+//
+// With --batch, runs every program named in a list file instead. A worker
+// process keeps one context and command queue for all the programs, and is
+// respawned if a program crashes it or runs out of time.
+//
+// With --configs, runs one program several times in one context, under
+// different build options or sizes, and compares the results.
 
 #define CL_USE_DEPRECATED_OPENCL_2_0_APIS
 
@@ -17,8 +24,22 @@
 #include <stdbool.h>
 
 #if defined(_MSC_VER) || defined(WINDOWS)
+#include <fcntl.h>
+#include <io.h>
 #include <windows.h>
 #include <rtcapi.h>
+#else
+#define HAVE_BATCH_MODE
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER) || defined(WINDOWS)
 
 #ifdef XOPENME
 #include <xopenme.h>
@@ -57,6 +78,8 @@ int runtime_check_handler(int errorType, const char *filename, int linenumber, c
 #define DEF_LOCAL_SIZE 32
 #define DEF_GLOBAL_SIZE 1024
 #define REQ_ARG_COUNT 2
+#define MAX_KERNEL_BUFFERS 8
+#define DEF_BATCH_TIMEOUT 150
 
 // User input.
 const char *file;
@@ -72,7 +95,12 @@ bool disable_fake = false;
 bool disable_group = false;
 bool disable_atomics = false;
 bool output_binary = false;
+bool full_output = false;
 bool set_device_from_name = false;
+const char *batch_list = NULL;
+int batch_timeout = DEF_BATCH_TIMEOUT;
+const char *cache_dir = NULL;
+const char *configs = NULL;
 
 // Kernel parameters.
 bool atomics = false;
@@ -81,10 +109,11 @@ bool atomic_reductions = false;
 bool emi = false;
 bool fake_divergence = false;
 bool inter_thread_comm = false;
+bool digest = false;
 
-// Data to free.
+// Data to free. The test, read whole, and its length.
 char *source_text = NULL;
-char *buf = NULL;
+size_t source_length = 0;
 RES_TYPE * init_result = NULL;
 cl_uint *init_atomic_vals = NULL;
 cl_uint *init_special_vals = NULL;
@@ -95,8 +124,16 @@ char* local_dims = "";
 char* global_dims = "";
 int *sequence_input = NULL;
 cl_long *comm_vals = NULL;
+RES_TYPE *results = NULL;
+cl_uint *digests = NULL;
+cl_program program = NULL;
+cl_kernel kernel = NULL;
+cl_mem kernel_buffers[MAX_KERNEL_BUFFERS];
+int kernel_buffer_count = 0;
 
 // Other parameters
+cl_platform_id *platforms = NULL;
+cl_device_id *devices = NULL;
 cl_platform_id *platform;
 cl_device_id *device;
 int total_threads = 1;
@@ -108,7 +145,27 @@ char platformName[256];
 char deviceName[256];
 int compute_units=0;
 
+// Programs built, from the cache (--cache) or from source, since the process
+// started. A stale entry is one that could not be loaded or built.
+int cache_hits = 0;
+int cache_misses = 0;
+int cache_stale = 0;
+
 int run_on_platform_device(cl_platform_id *, cl_device_id *, cl_uint);
+int run_kernel(cl_context, cl_command_queue, cl_device_id *, cl_uint);
+void print_results(FILE *, bool);
+uint64_t *sorted_results(void);
+void release_kernel_objects(void);
+void release_source(void);
+void print_cache_stats(void);
+int parse_dims(void);
+int open_platform_device(void);
+int check_device_limits(void);
+#ifdef HAVE_BATCH_MODE
+int run_batch(int argc, char **argv);
+#endif
+bool is_config_arg(const char *arg);
+int run_configs(void);
 void
 #ifdef _MSC_VER
   __stdcall
@@ -117,12 +174,15 @@ void
 int cl_error_check(cl_int, const char *);
 int parse_arg(char* arg, char* val);
 int parse_file_args(const char* filename);
+int parse_line_args(char *line);
+int parse_args(int argc, char **argv);
+char *read_test_file(const char *filename, size_t *length);
 
 void print_help() {
   fprintf(stderr, "Usage: ./cl_launcher -f <cl_program> -p <platform_idx> -d <device_idx> [flags...]\n");
   fprintf(stderr, "\n");
   fprintf(stderr, "Required flags are:\n");
-  fprintf(stderr, "  -f FILE --filename FILE                   Test file\n");
+  fprintf(stderr, "  -f FILE --filename FILE                   Test file (- for stdin)\n");
   fprintf(stderr, "  -p IDX  --platform_idx IDX                Target platform\n");
   fprintf(stderr, "  -d IDX  --device_idx IDX                  Target device\n");
   fprintf(stderr, "\n");
@@ -133,11 +193,20 @@ void print_help() {
   fprintf(stderr, "  -g N    --groups N                        Same as -l, but representing the total number of work-units per dimension\n");
   fprintf(stderr, "  -n NAME --name NAME                       Ensure the device name contains this string\n");
   fprintf(stderr, "  -a FILE --args FILE                       Look for file-defined arguments in this file, rather than the test file\n");
+  fprintf(stderr, "          --batch FILE                      Run each test listed in FILE (- for stdin) instead of -f, one per line,\n");
+  fprintf(stderr, "                                            optionally followed by a tab and its arguments file\n");
+  fprintf(stderr, "          --timeout N                       Seconds each test may take in batch mode (%d by default, 0 for none)\n", DEF_BATCH_TIMEOUT);
+  fprintf(stderr, "          --cache DIR                       Keep the compiled programs in DIR, which must exist, and reuse them\n");
+  fprintf(stderr, "          --configs LIST                    Run the test once for each configuration in LIST, separated by ';', each\n");
+  fprintf(stderr, "                                            made of the flags ---disable_*, -g and -l (an empty one runs the\n");
+  fprintf(stderr, "                                            test as is), and report any whose results differ from the first\n");
   fprintf(stderr, "          --atomics                         Test uses atomic sections\n");
   fprintf(stderr, "                      ---atomic_reductions  Test uses atomic reductions\n");
   fprintf(stderr, "                      ---emi                Test uses EMI\n");
   fprintf(stderr, "                      ---fake_divergence    Test uses fake divergence\n");
   fprintf(stderr, "                      ---inter_thread_comm  Test uses inter-thread communication\n");
+  fprintf(stderr, "                      ---digest             Test computes digests of the results\n");
+  fprintf(stderr, "                      ---full_output        Print the result of every thread, even if the test computes digests\n");
   fprintf(stderr, "                      ---debug              Print debug info\n");
   fprintf(stderr, "                      ---bin                Output disassembly of kernel in out.bin\n");
   fprintf(stderr, "                      ---disable_opts       Disable OpenCL compile optimisations\n");
@@ -225,13 +294,9 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  int req_arg = 0;
-
   // Parsing arguments
   int arg_no = 0;
-  int parse_ret;
   char* curr_arg;
-  char* next_arg;
   while (++arg_no < argc) {
     curr_arg = argv[arg_no];
     if (!strcmp(curr_arg, "-h") || !strcmp(curr_arg, "--help")) {
@@ -244,51 +309,126 @@ int main(int argc, char **argv) {
     if (!strcmp(curr_arg, "-a") || !strcmp(curr_arg, "--args")) {
       args_file = argv[++arg_no];
     }
+    if (!strcmp(curr_arg, "--batch")) {
+      batch_list = argv[++arg_no];
+    }
   }
 
-  if (!file) {
-    fprintf(stderr, "Require file (-f) argument!\n");
+  if (!file && !batch_list) {
+    fprintf(stderr, "Require file (-f) or batch list (--batch) argument!\n");
     return 1;
   }
 
-  // Parse arguments found in the given source file
-  if (args_file == NULL) {
-    if (!parse_file_args(file)) {
-      fprintf(stderr, "Failed parsing file for arguments.\n");
-      return 1;
-    }
-  }
-  // Parse arguments in defined args file
-  else {
-    if (!parse_file_args(args_file)) {
-      fprintf(stderr, "Failed parsing given arguments file.\n");
+  // A test on stdin can only be read once, so read it now for its arguments
+  // and keep it for running.
+  if (!batch_list && !strcmp(file, "-")) {
+    source_text = read_test_file(file, &source_length);
+    if (source_text == NULL)
       return 1;
-    }
   }
 
-  arg_no = 0;
-  while (++arg_no < argc) {
-    curr_arg = argv[arg_no];
-    if (strncmp(curr_arg, "---", 3)) {
-      if (++arg_no >= argc) {
-        fprintf(stderr, "Found option %s with no value.\n", curr_arg);
+  // Parse arguments found in the given source file. In batch mode this is
+  // done for each test by the worker.
+  if (!batch_list) {
+    if (args_file == NULL && source_text != NULL) {
+      char first_line[128];
+      strncpy(first_line, source_text, sizeof(first_line) - 1);
+      first_line[sizeof(first_line) - 1] = '\0';
+      if (!parse_line_args(first_line)) {
+        fprintf(stderr, "Failed parsing file for arguments.\n");
+        return 1;
+      }
+    }
+    else if (args_file == NULL) {
+      if (!parse_file_args(file)) {
+        fprintf(stderr, "Failed parsing file for arguments.\n");
+        return 1;
+      }
+    }
+    // Parse arguments in defined args file
+    else {
+      if (!parse_file_args(args_file)) {
+        fprintf(stderr, "Failed parsing given arguments file.\n");
         return 1;
       }
-      next_arg = argv[arg_no];
     }
-    parse_ret = parse_arg(curr_arg, next_arg);
-    if (!parse_ret)
-      return 1;
-    req_arg += parse_ret - 1;
   }
 
+  int req_arg = parse_args(argc, argv);
+  if (req_arg < 0)
+    return 1;
+
   if (req_arg < REQ_ARG_COUNT) {
     fprintf(stderr, "Require device index (-d) and platform index (-p) arguments, or device name (-n)!\n");
     return 1;
   }
 
-  // TODO function this
-  // Parsing thread and group dimension information
+  // Platform ID, the index in the array of platforms.
+  if (platform_index < 0) {
+    fprintf(stderr, "Could not parse platform id \"%s\"\n", argv[2]);
+    return 1;
+  }
+
+  // Device ID, not used atm.
+  if (device_index < 0) {
+    fprintf(stderr, "Could not parse device id \"%s\"\n", argv[3]);
+    return 1;
+  }
+
+  if (batch_list && configs) {
+    fprintf(stderr, "Cannot run configurations (--configs) in batch mode\n");
+    return 1;
+  }
+
+  if (batch_list) {
+#ifdef HAVE_BATCH_MODE
+    return run_batch(argc, argv);
+#else
+    fprintf(stderr, "Batch mode is not supported on this platform\n");
+    return 1;
+#endif
+  }
+
+  if (configs) {
+    int run_err = run_configs();
+    release_kernel_objects();
+    release_source();
+    free(platforms);
+    free(devices);
+    print_cache_stats();
+    return run_err;
+  }
+
+  if (parse_dims())
+    return 1;
+
+  if (open_platform_device())
+    return 1;
+
+  if (check_device_limits())
+    return 1;
+
+  int run_err = run_on_platform_device(platform, device, (cl_uint) l_dim);
+  release_kernel_objects();
+  release_source();
+  print_cache_stats();
+  free(local_size);
+  free(global_size);
+  free(platforms);
+  free(devices);
+
+#ifdef XOPENME
+  xopenme_dump_state();
+  xopenme_finish();
+#endif
+
+  return run_err;
+}
+
+// Parses the thread and group dimension information given by -l and -g, and
+// computes the number of work-units and groups from it.
+// Return 0 on success, 1 on error.
+int parse_dims(void) {
   if (strcmp(local_dims, "") == 0) {
     local_size = (size_t*)malloc(sizeof(size_t));
     local_size[0] = DEF_LOCAL_SIZE;
@@ -305,6 +445,7 @@ int main(int argc, char **argv) {
       tok = strtok(NULL, ",");
     }
   	free(local_dims);
+    local_dims = "";
   }
   if (strcmp(global_dims, "") == 0) {
     global_size = (size_t*)malloc(sizeof(size_t));
@@ -322,6 +463,7 @@ int main(int argc, char **argv) {
       tok = strtok(NULL, ",");
     }
   	free(global_dims);
+    global_dims = "";
   }
 
   // print global and local sizes in debug mode
@@ -369,19 +511,12 @@ int main(int argc, char **argv) {
     total_threads *= global_size[i];
     no_groups *= global_size[i] / local_size[i];
   }
+  return 0;
+}
 
-  // Platform ID, the index in the array of platforms.
-  if (platform_index < 0) {
-    fprintf(stderr, "Could not parse platform id \"%s\"\n", argv[2]);
-    return 1;
-  }
-
-  // Device ID, not used atm.
-  if (device_index < 0) {
-    fprintf(stderr, "Could not parse device id \"%s\"\n", argv[3]);
-    return 1;
-  }
-
+// Looks up the platform and device to run on, setting platform and device.
+// Return 0 on success, 1 on error.
+int open_platform_device(void) {
   if (set_device_from_name) {
     if (strcmp(device_name_given, "") == 0) {
       fprintf(stderr, "Must give '-n NAME' to use --set_device_from_name\n");
@@ -395,7 +530,7 @@ int main(int argc, char **argv) {
 
   // Query the OpenCL API for the given platform ID.
   cl_int err;
-  cl_platform_id * platforms = (cl_platform_id*)malloc(sizeof(cl_platform_id)*(platform_index + 1));
+  platforms = (cl_platform_id*)malloc(sizeof(cl_platform_id)*(platform_index + 1));
   cl_uint platform_count;
   err = clGetPlatformIDs(platform_index + 1, platforms, &platform_count);
   if (cl_error_check(err, "clGetPlatformIDs error"))
@@ -425,7 +560,7 @@ int main(int argc, char **argv) {
 #endif
 
   // Find all the devices for the platform.
-  cl_device_id * devices = (cl_device_id*)malloc(sizeof(cl_device_id)*(device_index + 1));
+  devices = (cl_device_id*)malloc(sizeof(cl_device_id)*(device_index + 1));
   cl_uint device_count;
   err = clGetDeviceIDs(
       *platform, CL_DEVICE_TYPE_ALL, device_index + 1, devices, &device_count);
@@ -454,6 +589,30 @@ int main(int argc, char **argv) {
     }
   }
 
+  if (debug_build) {
+    err = clGetDeviceInfo(*device, CL_DEVICE_NAME, sizeof(deviceName), deviceName, NULL);
+    if (cl_error_check(err, "Get Device Info error")) return 1;
+    fprintf(stderr, "Device: %s\n", deviceName);
+  }
+
+#ifdef XOPENME
+  err = clGetDeviceInfo(*device, CL_DEVICE_NAME, sizeof(deviceName), deviceName, NULL);
+  if (cl_error_check(err, "Get Device Info error")) return 1;
+
+  err = clGetDeviceInfo(*device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &compute_units, NULL);
+  if (cl_error_check(err, "Get Device compute units error")) return 1;
+
+  xopenme_add_var_s(1, (char*) "  \"opencl_device\":\"%s\"", deviceName);
+  xopenme_add_var_i(2, (char*) "  \"opencl_device_units\":%u", compute_units);
+#endif
+  return 0;
+}
+
+// Checks that the device can run the test with the sizes from parse_dims().
+// Return 0 on success, 1 on error.
+int check_device_limits(void) {
+  cl_int err;
+
   // Checking device supports given number of dimensions
   cl_uint max_dimensions;
   err = clGetDeviceInfo(*device, CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS, sizeof(cl_uint), &max_dimensions, NULL);
@@ -490,106 +649,386 @@ int main(int argc, char **argv) {
     fprintf(stderr, "Kernel work group size is %zd, which exceeds the maximum work group size of %zd for this device\n", given_work_group_size, max_work_group_size);
     return 1;
   }
+  return 0;
+}
 
-  if (debug_build) {
-    err = clGetDeviceInfo(*device, CL_DEVICE_NAME, sizeof(deviceName), deviceName, NULL);
-    if (cl_error_check(err, "Get Device Info error")) return 1;
-    fprintf(stderr, "Device: %s\n", deviceName);
-  }
+// Creates a context and command queue for the device.
+// Return 0 on success, 1 on error.
+int create_context_queue(cl_platform_id *platform, cl_device_id *device,
+    cl_context *context, cl_command_queue *com_queue) {
+  // Create a context, that uses our specified platform and device.
+  cl_int err;
+  cl_context_properties properties[3] = {
+      CL_CONTEXT_PLATFORM, (cl_context_properties)*platform, 0 };
+  *context = clCreateContext(properties, 1, device, error_callback, NULL, &err);
+  if (cl_error_check(err, "Error creating context"))
+    return 1;
 
-#ifdef XOPENME
-  err = clGetDeviceInfo(*device, CL_DEVICE_NAME, sizeof(deviceName), deviceName, NULL);
-  if (cl_error_check(err, "Get Device Info error")) return 1;
+  // Create a command queue for the device in the context just created.
+  // CHANGE when cl 2.0 is released.
+  //*com_queue =
+  //    clCreateCommandQueueWithProperties(*context, *device, NULL, &err);
+  *com_queue = clCreateCommandQueue(*context, *device, 0, &err);
+  if (cl_error_check(err, "Error creating command queue"))
+    return 1;
+  return 0;
+}
 
-  err = clGetDeviceInfo(*device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &compute_units, NULL);
-  if (cl_error_check(err, "Get Device compute units error")) return 1;
+int run_on_platform_device(cl_platform_id *platform, cl_device_id *device, cl_uint work_dim) {
+  cl_context context;
+  cl_command_queue com_queue;
+  if (create_context_queue(platform, device, &context, &com_queue))
+    return 1;
 
-  xopenme_add_var_s(1, (char*) "  \"opencl_device\":\"%s\"", deviceName);
-  xopenme_add_var_i(2, (char*) "  \"opencl_device_units\":%u", compute_units);
-#endif
+  int run_err = run_kernel(context, com_queue, device, work_dim);
+  if (!run_err)
+    print_results(stdout, true);
 
+  clReleaseCommandQueue(com_queue);
+  clReleaseContext(context);
+  return run_err;
+}
 
-  int run_err = run_on_platform_device(platform, device, (cl_uint) l_dim);
-  free(source_text);
-  free(buf);
+// Return true if arg may be used in a configuration of --configs. Only the
+// flags that run_configs() resets before each configuration are allowed; the
+// others would apply to the rest of the run, or do nothing.
+bool is_config_arg(const char *arg) {
+  return !strcmp(arg, "---disable_opts") || !strcmp(arg, "---disable_fake") ||
+      !strcmp(arg, "---disable_group") || !strcmp(arg, "---disable_atomics") ||
+      !strcmp(arg, "-l") || !strcmp(arg, "--locals") ||
+      !strcmp(arg, "-g") || !strcmp(arg, "--groups");
+}
+
+// Runs the test once for each configuration in configs. The configurations are
+// separated by ';', and each is a list of flags, such as ---disable_opts or -g
+// and -l, added to those of the test and of the command line. They all run in
+// the same context, from the test read once. Prints a line for each: the
+// configuration, a tab, then "ok" or "differs" and a tab and the results, or
+// "error". The results of a configuration differ if its distinct results are
+// not those of the first configuration that ran.
+// Return 0 if they all ran, 1 otherwise.
+int run_configs(void) {
+  if (open_platform_device())
+    return 1;
+  cl_context context = NULL;
+  cl_command_queue com_queue = NULL;
+  int failed = 1;
+  if (create_context_queue(platform, device, &context, &com_queue))
+    goto release;
+  if (source_text == NULL) {
+    source_text = read_test_file(file, &source_length);
+    if (source_text == NULL)
+      goto release;
+  }
+
+  // What each configuration starts from.
+  bool base_disable_opts = disable_opts;
+  bool base_disable_group = disable_group;
+  bool base_disable_fake = disable_fake;
+  bool base_disable_atomics = disable_atomics;
+  char *base_local_dims = local_dims;
+  char *base_global_dims = global_dims;
+  local_dims = "";
+  global_dims = "";
+
+  uint64_t *reference = NULL;
+  int reference_count = 0;
+  failed = 0;
+  char *list = (char*)malloc(strlen(configs) + 1);
+  strcpy(list, configs);
+  char *config = list;
+  while (config != NULL) {
+    char *next = strchr(config, ';');
+    if (next != NULL)
+      *next++ = '\0';
+
+    disable_opts = base_disable_opts;
+    disable_group = base_disable_group;
+    disable_fake = base_disable_fake;
+    disable_atomics = base_disable_atomics;
+    if (strcmp(local_dims, ""))
+      free(local_dims);
+    local_dims = "";
+    if (strcmp(global_dims, ""))
+      free(global_dims);
+    global_dims = "";
+    free(local_size);
+    local_size = NULL;
+    free(global_size);
+    global_size = NULL;
+    l_dim = 1;
+    g_dim = 1;
+    total_threads = 1;
+    no_groups = 1;
+
+    // The flags are all parsed before parse_dims(), which also uses strtok().
+    char *flags = (char*)malloc(strlen(config) + 1);
+    strcpy(flags, config);
+    int run_err = 0;
+    char *tok = strtok(flags, " ");
+    while (tok && !run_err) {
+      char *val = strncmp(tok, "---", 3) ? strtok(NULL, " ") : NULL;
+      if (!is_config_arg(tok)) {
+        fprintf(stderr, "Cannot use %s in a configuration\n", tok);
+        run_err = 1;
+      } else if (val == NULL && strncmp(tok, "---", 3)) {
+        fprintf(stderr, "Found option %s with no value.\n", tok);
+        run_err = 1;
+      } else if (parse_arg(tok, val) != 1) {
+        fprintf(stderr, "Cannot use %s in a configuration\n", tok);
+        run_err = 1;
+      }
+      tok = strtok(NULL, " ");
+    }
+    free(flags);
+    // parse_dims() frees the dimensions, so they are copied.
+    if (!strcmp(local_dims, "") && strcmp(base_local_dims, "")) {
+      local_dims = (char*)malloc(strlen(base_local_dims) + 1);
+      strcpy(local_dims, base_local_dims);
+    }
+    if (!strcmp(global_dims, "") && strcmp(base_global_dims, "")) {
+      global_dims = (char*)malloc(strlen(base_global_dims) + 1);
+      strcpy(global_dims, base_global_dims);
+    }
+    if (!run_err)
+      run_err = parse_dims() || check_device_limits() ||
+          run_kernel(context, com_queue, device, (cl_uint) l_dim);
+
+    uint64_t *hashes = run_err ? NULL : sorted_results();
+    const char *status = "ok";
+    if (hashes == NULL) {
+      status = "error";
+      failed = 1;
+    } else {
+      int count = 0, i;
+      for (i = 0; i < total_threads; ++i)
+        if (count == 0 || hashes[i] != hashes[count - 1])
+          hashes[count++] = hashes[i];
+      if (reference == NULL) {
+        reference = hashes;
+        reference_count = count;
+      } else {
+        if (count != reference_count ||
+            memcmp(hashes, reference, count * sizeof(uint64_t)))
+          status = "differs";
+        free(hashes);
+      }
+    }
+    if (!strcmp(status, "differs"))
+      fprintf(stderr, "Results of configuration \"%s\" differ from the first\n", config);
+    fprintf(stdout, "%s\t%s\t", config, status);
+    if (!run_err)
+      print_results(stdout, false);
+    fprintf(stdout, "\n");
+    fflush(stdout);
+    release_kernel_objects();
+    config = next;
+  }
+
+  free(list);
+  free(reference);
+  if (strcmp(local_dims, ""))
+    free(local_dims);
+  local_dims = "";
+  if (strcmp(global_dims, ""))
+    free(global_dims);
+  global_dims = "";
   free(local_size);
+  local_size = NULL;
   free(global_size);
-  free(platforms);
-  free(devices);
-  free(init_result);
+  global_size = NULL;
+  if (strcmp(base_local_dims, ""))
+    free(base_local_dims);
+  if (strcmp(base_global_dims, ""))
+    free(base_global_dims);
+
+release:
+  // create_context_queue() may have made the context but not the queue.
+  if (com_queue != NULL)
+    clReleaseCommandQueue(com_queue);
+  if (context != NULL)
+    clReleaseContext(context);
+  return failed;
+}
 
-  if (atomics) {
-    free(init_atomic_vals);
-    free(init_special_vals);
+// Same as clCreateBuffer(), but remembers the buffer so that
+// release_kernel_objects() can release it.
+cl_mem create_buffer(cl_context context, cl_mem_flags flags, size_t size,
+    void *host_ptr, cl_int *err) {
+  cl_mem buffer = clCreateBuffer(context, flags, size, host_ptr, err);
+  if (*err == CL_SUCCESS) {
+    assert(kernel_buffer_count < MAX_KERNEL_BUFFERS);
+    kernel_buffers[kernel_buffer_count++] = buffer;
   }
-  if (atomic_reductions) {
-    free(global_reduction_target);
+  return buffer;
+}
+
+// Adds size bytes of data to a 64 bit FNV-1a hash.
+uint64_t hash_bytes(uint64_t hash, const void *data, size_t size) {
+  const unsigned char *bytes = (const unsigned char *)data;
+  size_t i;
+  for (i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ULL;
   }
-  if (fake_divergence) {
-    free(sequence_input);
+  return hash;
+}
+
+// Returns the path of the cache entry for the test built with options, named
+// after a hash of the test, the options, the runtime headers the test includes
+// and the versions of the platform, device and driver. The caller frees it.
+// Returns NULL on error.
+char *cache_entry_path(const char *options) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  hash = hash_bytes(hash, source_text, source_length);
+  hash = hash_bytes(hash, options, strlen(options) + 1);
+
+  static const char *const headers[] = {
+      "CLSmith.h", "cl_safe_math_macros.h", "safe_math_macros.h" };
+  char buf[4096];
+  size_t i;
+  for (i = 0; i < sizeof(headers) / sizeof(headers[0]); ++i) {
+    snprintf(buf, sizeof(buf), "%s/%s", include_path, headers[i]);
+    FILE *header = fopen(buf, "rb");
+    if (header == NULL)
+      continue;
+    size_t got;
+    while ((got = fread(buf, 1, sizeof(buf), header)) > 0)
+      hash = hash_bytes(hash, buf, got);
+    fclose(header);
+  }
+
+  static const cl_platform_info platform_params[] = {
+      CL_PLATFORM_NAME, CL_PLATFORM_VERSION };
+  static const cl_device_info device_params[] = {
+      CL_DEVICE_NAME, CL_DEVICE_VERSION, CL_DRIVER_VERSION };
+  cl_int err;
+  for (i = 0; i < sizeof(platform_params) / sizeof(platform_params[0]); ++i) {
+    err = clGetPlatformInfo(*platform, platform_params[i], sizeof(buf), buf, NULL);
+    if (cl_error_check(err, "Error getting platform info for the program cache"))
+      return NULL;
+    buf[sizeof(buf) - 1] = '\0';
+    hash = hash_bytes(hash, buf, strlen(buf) + 1);
+  }
+  for (i = 0; i < sizeof(device_params) / sizeof(device_params[0]); ++i) {
+    err = clGetDeviceInfo(*device, device_params[i], sizeof(buf), buf, NULL);
+    if (cl_error_check(err, "Error getting device info for the program cache"))
+      return NULL;
+    buf[sizeof(buf) - 1] = '\0';
+    hash = hash_bytes(hash, buf, strlen(buf) + 1);
+  }
+
+  size_t size = strlen(cache_dir) + 64;
+  char *path = (char*)malloc(size);
+  snprintf(path, size, "%s/%016" PRIx64 "-%lu.bin", cache_dir, hash,
+      (unsigned long)source_length);
+  return path;
+}
+
+// Loads the program from its cache entry at path, and builds it. An entry that
+// cannot be loaded or built, say because the driver changed without changing
+// its version, is stale, and is replaced once the program is built from the
+// test.
+// Return 0 on success, 1 if the program must be built from the test.
+int load_cached_program(cl_context context, cl_device_id *device,
+    const char *path, const char *options) {
+  FILE *entry = fopen(path, "rb");
+  if (entry == NULL) {
+    ++cache_misses;
+    return 1;
   }
-  if (inter_thread_comm) {
-    free(comm_vals);
+  fclose(entry);
+  size_t size;
+  unsigned char *binary = (unsigned char*)read_test_file(path, &size);
+  cl_int err = CL_INVALID_BINARY, status = CL_SUCCESS;
+  if (binary != NULL) {
+    program = clCreateProgramWithBinary(context, 1, device, &size,
+        (const unsigned char **)&binary, &status, &err);
+    free(binary);
+  }
+  if (err == CL_SUCCESS && status == CL_SUCCESS)
+    err = clBuildProgram(program, 0, NULL, options, NULL, NULL);
+  if (err != CL_SUCCESS || status != CL_SUCCESS) {
+    if (debug_build)
+      fprintf(stderr, "Stale program cache entry %s: %d\n", path,
+          err != CL_SUCCESS ? err : status);
+    if (program != NULL)
+      clReleaseProgram(program);
+    program = NULL;
+    ++cache_stale;
+    return 1;
   }
+  ++cache_hits;
+  return 0;
+}
 
-#ifdef XOPENME
-  xopenme_dump_state();
-  xopenme_finish();
+// Writes the binary of the program just built to its cache entry at path. It
+// is written under another name first and then renamed, so that the other
+// launchers sharing the cache never load part of it. Failing to store it only
+// gives a warning.
+void store_cached_program(const char *path) {
+  size_t size;
+  cl_int err = clGetProgramInfo(
+      program, CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &size, NULL);
+  if (cl_error_check(err, "Error getting binary info for the program cache") ||
+      size == 0)
+    return;
+  unsigned char *binary = (unsigned char*)malloc(size);
+  if (binary == NULL) {
+    fprintf(stderr, "Failed to malloc %lu bytes\n", (unsigned long)size);
+    return;
+  }
+  err = clGetProgramInfo(
+      program, CL_PROGRAM_BINARIES, sizeof(unsigned char *), &binary, NULL);
+  if (cl_error_check(err, "Error getting binary for the program cache")) {
+    free(binary);
+    return;
+  }
+
+  size_t tmp_size = strlen(path) + 32;
+  char *tmp_path = (char*)malloc(tmp_size);
+#ifdef HAVE_BATCH_MODE
+  snprintf(tmp_path, tmp_size, "%s.%d", path, (int)getpid());
+#else
+  snprintf(tmp_path, tmp_size, "%s.tmp", path);
 #endif
-
-  return run_err;
+  FILE *entry = fopen(tmp_path, "wb");
+  bool stored = entry != NULL && fwrite(binary, 1, size, entry) == size;
+  if (entry != NULL && fclose(entry))
+    stored = false;
+#if defined(_MSC_VER) || defined(WINDOWS)
+  // rename() does not replace a stale entry here.
+  if (stored)
+    remove(path);
+#endif
+  if (stored && rename(tmp_path, path))
+    stored = false;
+  if (!stored) {
+    fprintf(stderr, "Could not write program cache entry %s\n", path);
+    remove(tmp_path);
+  }
+  free(tmp_path);
+  free(binary);
 }
 
-int run_on_platform_device(cl_platform_id *platform, cl_device_id *device, cl_uint work_dim) {
-
-  // Try to read source file into a binary buffer
-  FILE *source = fopen(file, "rb");
-  if (source == NULL) {
-    fprintf(stderr, "Could not open %s.\n", file);
-    return 1;
-  }
+// Prints how many programs came from the cache, if it is used.
+void print_cache_stats(void) {
+  if (cache_dir != NULL)
+    fprintf(stderr, "Program cache: %d hits, %d misses, %d stale\n",
+        cache_hits, cache_misses, cache_stale);
+}
 
-  size_t source_size;
-  if (!binary_size) {
-    char temp[1024];
-    while (!feof(source)) fread(temp, 1, 1024, source);
-    source_size = ftell(source);
-    rewind(source);
-
-    source_text = (char*)calloc(1, source_size + 1);
-    if (source_text == NULL) {
-      fprintf(stderr, "Failed to calloc %ld bytes.\n", source_size);
-      return 1;
-    }
-    fread(source_text, 1, source_size, source);
-    fclose(source);
-  }
-  else {
-    buf = (char *) malloc (binary_size);
-    source_size = fread(buf, 1, binary_size, source);
-    fclose(source);
-  }
+// Creates the program from the test, as source or as binary, and builds it.
+// Return 0 on success, 1 on error.
+int build_program(cl_context context, cl_device_id *device, const char *options) {
+  size_t source_size = source_length;
+  if (binary_size && source_size > binary_size)
+    source_size = binary_size;
 
-  // Create a context, that uses our specified platform and device.
   cl_int err;
-  cl_context_properties properties[3] = {
-      CL_CONTEXT_PLATFORM, (cl_context_properties)*platform, 0 };
-  cl_context context =
-      clCreateContext(properties, 1, device, error_callback, NULL, &err);
-  if (cl_error_check(err, "Error creating context"))
-    return 1;
-
-  // Create a command queue for the device in the context just created.
-  // CHANGE when cl 2.0 is released.
-  //cl_command_queue com_queue =
-  //    clCreateCommandQueueWithProperties(context, *device, NULL, &err);
-  cl_command_queue com_queue = clCreateCommandQueue(context, *device, 0, &err);
-  if (cl_error_check(err, "Error creating command queue"))
-    return 1;
 
   // Create a kernel from the source program. This involves turning the source
   // into a program object, compiling it and creating a kernel object from it.
-  cl_program program;
   if (!binary_size) {
     const char *const_source = source_text;
     program =
@@ -598,23 +1037,11 @@ int run_on_platform_device(cl_platform_id *platform, cl_device_id *device, cl_ui
   else {
     program =
         clCreateProgramWithBinary(context, 1, device, (const size_t *)&source_size,
-                                  (const unsigned char **)&buf, NULL, &err);
+                                  (const unsigned char **)&source_text, NULL, &err);
   }
   if (cl_error_check(err, "Error creating program"))
     return 1;
 
-  // Add optimisation to options later.
-  char* options = (char*)malloc(sizeof(char)*256);
-  sprintf(options, "-w -I%s", include_path);
-  if (disable_opts)
-    sprintf(options, "%s -cl-opt-disable", options);
-  if (disable_group)
-    sprintf(options, "%s -D NO_GROUP_DIVERGENCE", options);
-  if (disable_fake)
-    sprintf(options, "%s -D NO_FAKE_DIVERGENCE", options);
-  if (disable_atomics)
-    sprintf(options, "%s -D NO_ATOMICS", options);
-
 #ifdef _MSC_VER
   build_in_progress = true;
 #endif
@@ -647,7 +1074,50 @@ int run_on_platform_device(cl_platform_id *platform, cl_device_id *device, cl_ui
     }
     return 1;
   }
+  return 0;
+}
+
+// Builds the test in file and runs it on the queue, leaving the value computed
+// by each thread in results.
+// Return 0 on success, 1 on error.
+int run_kernel(cl_context context, cl_command_queue com_queue, cl_device_id *device, cl_uint work_dim) {
+
+  // Read the source file, or binary, unless it came from stdin and has been
+  // read already.
+  if (source_text == NULL) {
+    source_text = read_test_file(file, &source_length);
+    if (source_text == NULL)
+      return 1;
+  }
+  cl_int err;
+
+  // Add optimisation to options later.
+  char* options = (char*)malloc(sizeof(char)*256);
+  sprintf(options, "-w -I%s", include_path);
+  if (disable_opts)
+    sprintf(options, "%s -cl-opt-disable", options);
+  if (disable_group)
+    sprintf(options, "%s -D NO_GROUP_DIVERGENCE", options);
+  if (disable_fake)
+    sprintf(options, "%s -D NO_FAKE_DIVERGENCE", options);
+  if (disable_atomics)
+    sprintf(options, "%s -D NO_ATOMICS", options);
+
+  // Use the program in the cache if there is one, or build it from the test
+  // and add it to the cache.
+  char *cache_path = NULL;
+  if (cache_dir != NULL && !binary_size)
+    cache_path = cache_entry_path(options);
+  int build_err = 0;
+  if (cache_path == NULL || load_cached_program(context, device, cache_path, options)) {
+    build_err = build_program(context, device, options);
+    if (!build_err && cache_path != NULL)
+      store_cached_program(cache_path);
+  }
+  free(cache_path);
   free(options);
+  if (build_err)
+    return 1;
 
   fprintf(stderr, "Compilation terminated successfully...\n");
   fflush(stdout);
@@ -686,7 +1156,7 @@ int run_on_platform_device(cl_platform_id *platform, cl_device_id *device, cl_ui
   }
 
   // Create the kernel
-  cl_kernel kernel = clCreateKernel(program, "entry", &err);
+  kernel = clCreateKernel(program, "entry", &err);
   if (cl_error_check(err, "Error creating kernel"))
     return 1;
 
@@ -695,7 +1165,7 @@ int run_on_platform_device(cl_platform_id *platform, cl_device_id *device, cl_ui
   int counter;
   for (counter = 0; counter < total_threads; counter++)
     init_result[counter] = 0;
-  cl_mem result = clCreateBuffer(
+  cl_mem result = create_buffer(
       context, CL_MEM_WRITE_ONLY | CL_MEM_COPY_HOST_PTR, total_threads * sizeof(RES_TYPE), init_result, &err);
   if (cl_error_check(err, "Error creating output buffer"))
     return 1;
@@ -719,14 +1189,14 @@ int run_on_platform_device(cl_platform_id *platform, cl_device_id *device, cl_ui
       init_special_vals[i] = 0;
     }
 
-    cl_mem atomic_input = clCreateBuffer(
+    cl_mem atomic_input = create_buffer(
         context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, total_counters * sizeof(cl_uint),
         init_atomic_vals, &err);
     if (cl_error_check(err, "Error creating atomic input buffer"))
       return 1;
 
     // Create buffer to store special values for the atomic blocks
-    cl_mem special_values = clCreateBuffer(
+    cl_mem special_values = create_buffer(
         context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, total_counters * sizeof(cl_uint),
         init_special_vals, &err);
     if (cl_error_check(err, "Error creating special values input buffer"))
@@ -746,7 +1216,7 @@ int run_on_platform_device(cl_platform_id *platform, cl_device_id *device, cl_ui
     for (i = 0; i < no_groups; i++)
       global_reduction_target[i] = 0;
 
-    cl_mem atomic_reduction_vars = clCreateBuffer(
+    cl_mem atomic_reduction_vars = create_buffer(
         context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, no_groups * sizeof(cl_int),
         global_reduction_target, &err);
     if (cl_error_check(err, "Error creating atomic reduction variable input buffer"))
@@ -761,7 +1231,7 @@ int run_on_platform_device(cl_platform_id *platform, cl_device_id *device, cl_ui
     int emi_values[1024];
     int i;
     for (i = 0; i < 1024; ++i) emi_values[i] = 1024 - i;
-    cl_mem emi_input = clCreateBuffer(
+    cl_mem emi_input = create_buffer(
         context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, 1024 * sizeof(cl_int), &emi_values, &err);
     if (cl_error_check(err, "Error creating emi buffer"))
       return 1;
@@ -778,7 +1248,7 @@ int run_on_platform_device(cl_platform_id *platform, cl_device_id *device, cl_ui
       if (global_size[i] > max_dimen) max_dimen = global_size[i];
     sequence_input = (int *)malloc(sizeof(int) * max_dimen);
     for (i = 0; i < max_dimen; ++i) sequence_input[i] = 10 + i;
-    cl_mem seq_input = clCreateBuffer(
+    cl_mem seq_input = create_buffer(
         context, CL_MEM_READ_ONLY, max_dimen * sizeof(cl_int), NULL, &err);
     if (cl_error_check(err, "Error creating fake divergence buffer"))
       return 1;
@@ -797,7 +1267,7 @@ int run_on_platform_device(cl_platform_id *platform, cl_device_id *device, cl_ui
     comm_vals = (cl_long*)malloc(sizeof(cl_long) * total_threads);
     int i;
     for (i = 0; i < total_threads; ++i) comm_vals[i] = 1;
-    cl_mem inter_thread = clCreateBuffer(
+    cl_mem inter_thread = create_buffer(
         context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, total_threads * sizeof(cl_long), comm_vals, &err);
     if (cl_error_check(err, "Error creating fake inter thread comm buffer"))
       return 1;
@@ -806,6 +1276,21 @@ int run_on_platform_device(cl_platform_id *platform, cl_device_id *device, cl_ui
       return 1;
   }
 
+  cl_mem digest_buffer = NULL;
+  if (digest) {
+    // Create the buffer for the digest of all the threads, followed by the
+    // digests of each group, all starting from zero.
+    size_t digest_words = 4 * (no_groups + 1);
+    digests = (cl_uint*)calloc(digest_words, sizeof(cl_uint));
+    digest_buffer = create_buffer(
+        context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, digest_words * sizeof(cl_uint), digests, &err);
+    if (cl_error_check(err, "Error creating digest buffer"))
+      return 1;
+    err = clSetKernelArg(kernel, kernel_arg++, sizeof(cl_mem), &digest_buffer);
+    if (cl_error_check(err, "Error setting kernel argument for digest"))
+      return 1;
+  }
+
 
   // Create command to launch the kernel.
 #ifdef _MSC_VER
@@ -825,16 +1310,126 @@ int run_on_platform_device(cl_platform_id *platform, cl_device_id *device, cl_ui
 #endif
 
   // Read back the reults of each thread.
-  RES_TYPE * c = (RES_TYPE*)malloc(sizeof(RES_TYPE)*total_threads);
+  results = (RES_TYPE*)malloc(sizeof(RES_TYPE)*total_threads);
   err = clEnqueueReadBuffer(
-      com_queue, result, CL_TRUE, 0, total_threads * sizeof(RES_TYPE), c, 0, NULL, NULL);
+      com_queue, result, CL_TRUE, 0, total_threads * sizeof(RES_TYPE), results, 0, NULL, NULL);
   if (cl_error_check(err, "Error reading output buffer"))
     return 1;
 
-  ////
+  if (digest) {
+    err = clEnqueueReadBuffer(
+        com_queue, digest_buffer, CL_TRUE, 0, 4 * (no_groups + 1) * sizeof(cl_uint), digests, 0, NULL, NULL);
+    if (cl_error_check(err, "Error reading digest buffer"))
+      return 1;
+  }
+
+  return 0;
+}
+
+// Orders hashes for counting the distinct ones.
+int compare_hashes(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+// Returns a sorted copy of the results of the last test run, to be freed by the
+// caller, or NULL if it cannot be allocated.
+uint64_t *sorted_results(void) {
+  uint64_t *hashes = (uint64_t *)malloc(sizeof(uint64_t) * total_threads);
+  if (hashes == NULL) {
+    fprintf(stderr, "Failed to malloc %lu bytes\n",
+        (unsigned long)(sizeof(uint64_t) * total_threads));
+    return NULL;
+  }
   int i;
   for (i = 0; i < total_threads; ++i)
-    printf(
+    hashes[i] = results[i];
+  qsort(hashes, total_threads, sizeof(uint64_t), compare_hashes);
+  return hashes;
+}
+
+// Appends size bytes of data to the record at *pos.
+void put_record(unsigned char **pos, const void *data, size_t size) {
+  memcpy(*pos, data, size);
+  *pos += size;
+}
+
+// Prints the results of a test that computes digests: the digests read back
+// and how many threads computed each distinct hash, rather than every hash.
+// The record is, in host byte order:
+//   "CLSD", uint32 threads, uint32 groups, uint32 distinct hashes,
+//   uint64 XOR and uint64 sum of the hashes of all the threads,
+//   uint64 XOR and uint64 sum of the hashes of each group,
+//   uint64 hash and uint32 count of each distinct hash, in increasing order.
+// It is written as is if binary is set, and in hex otherwise, so that it fits
+// on the line of the test in batch mode.
+void print_digests(FILE *out, bool binary) {
+  uint64_t *hashes = sorted_results();
+  unsigned char *record = (unsigned char *)malloc(
+      16 + 16 * (no_groups + 1) + 12 * total_threads);
+  if (hashes == NULL || record == NULL) {
+    fprintf(stderr, "Failed to malloc the digest record\n");
+    free(hashes);
+    free(record);
+    return;
+  }
+  int i;
+  uint32_t distinct = 0;
+  for (i = 0; i < total_threads; ++i)
+    if (i == 0 || hashes[i] != hashes[i - 1])
+      ++distinct;
+
+  unsigned char *pos = record;
+  uint32_t threads = total_threads, groups = no_groups;
+  put_record(&pos, "CLSD", 4);
+  put_record(&pos, &threads, sizeof(threads));
+  put_record(&pos, &groups, sizeof(groups));
+  put_record(&pos, &distinct, sizeof(distinct));
+  for (i = 0; i <= no_groups; ++i) {
+    const cl_uint *words = digests + 4 * i;
+    uint64_t xor_value = words[0] | (uint64_t)words[1] << 32;
+    uint64_t sum = words[2] | (uint64_t)words[3] << 32;
+    put_record(&pos, &xor_value, sizeof(xor_value));
+    put_record(&pos, &sum, sizeof(sum));
+  }
+  int first = 0;
+  for (i = 1; i <= total_threads; ++i) {
+    if (i < total_threads && hashes[i] == hashes[first])
+      continue;
+    uint32_t count = i - first;
+    put_record(&pos, &hashes[first], sizeof(uint64_t));
+    put_record(&pos, &count, sizeof(count));
+    first = i;
+  }
+
+  size_t size = pos - record;
+  if (binary) {
+#ifdef _MSC_VER
+    _setmode(_fileno(out), _O_BINARY);
+#endif
+    fwrite(record, 1, size, out);
+  } else {
+    size_t j;
+    for (j = 0; j < size; ++j)
+      fprintf(out, "%02x", record[j]);
+  }
+  free(hashes);
+  free(record);
+}
+
+// Prints the values computed by the threads of the last test run, if any, or
+// their digests if the test computes them and the full output was not asked
+// for. binary is set when the digests may be written as binary.
+void print_results(FILE *out, bool binary) {
+  if (results == NULL)
+    return;
+  if (digest && !full_output) {
+    print_digests(out, binary);
+    return;
+  }
+  int i;
+  for (i = 0; i < total_threads; ++i)
+    fprintf(out,
 #ifdef _MSC_VER
     "%I64x,"
 #elif EMBEDDED
@@ -842,12 +1437,46 @@ int run_on_platform_device(cl_platform_id *platform, cl_device_id *device, cl_ui
 #else
     "%#"PRIx64","
 #endif
-    , c[i]);
-////
+    , results[i]);
+}
 
-  free(c);
+// Releases the OpenCL objects and frees the host data of the last test run,
+// so that it can be run again, or another test run, in the same context.
+void release_kernel_objects(void) {
+  int i;
+  for (i = 0; i < kernel_buffer_count; ++i)
+    clReleaseMemObject(kernel_buffers[i]);
+  kernel_buffer_count = 0;
+  if (kernel != NULL)
+    clReleaseKernel(kernel);
+  kernel = NULL;
+  if (program != NULL)
+    clReleaseProgram(program);
+  program = NULL;
 
-  return 0;
+  free(init_result);
+  init_result = NULL;
+  free(init_atomic_vals);
+  init_atomic_vals = NULL;
+  free(init_special_vals);
+  init_special_vals = NULL;
+  free(global_reduction_target);
+  global_reduction_target = NULL;
+  free(sequence_input);
+  sequence_input = NULL;
+  free(comm_vals);
+  comm_vals = NULL;
+  free(results);
+  results = NULL;
+  free(digests);
+  digests = NULL;
+}
+
+// Frees the test read by the last run.
+void release_source(void) {
+  free(source_text);
+  source_text = NULL;
+  source_length = 0;
 }
 
 int parse_file_args(const char* filename) {
@@ -859,13 +1488,22 @@ int parse_file_args(const char* filename) {
   }
 
   char arg_buf[128];
-  fgets(arg_buf, 128, source);
+  if (fgets(arg_buf, 128, source) == NULL)
+    arg_buf[0] = '\0';
+  fclose(source);
+
+  return parse_line_args(arg_buf);
+}
+
+// Parses the arguments in the first line of a test, which is modified. Lines
+// that are not a comment have none.
+int parse_line_args(char *line) {
   char* new_line;
-  if ((new_line = strchr(arg_buf, '\n')))
-    arg_buf[(int) (new_line - arg_buf)] = '\0';
+  if ((new_line = strchr(line, '\n')))
+    *new_line = '\0';
 
-  if (!strncmp(arg_buf, "//", 2)) {
-    char* tok = strtok(arg_buf, " ");
+  if (!strncmp(line, "//", 2)) {
+    char* tok = strtok(line, " ");
     while (tok) {
       if (!strncmp(tok, "---", 3))
         parse_arg(tok, NULL);
@@ -875,11 +1513,77 @@ int parse_file_args(const char* filename) {
     }
   }
 
-  fclose(source);
-
   return 1;
 }
 
+// Reads the whole of the named file, or stdin for "-", into a NUL terminated
+// buffer to be freed by the caller. Returns NULL on error.
+char *read_test_file(const char *filename, size_t *length) {
+  bool from_stdin = !strcmp(filename, "-");
+  FILE *source = from_stdin ? stdin : fopen(filename, "rb");
+  if (source == NULL) {
+    fprintf(stderr, "Could not open %s.\n", filename);
+    return NULL;
+  }
+
+  size_t capacity = 64 * 1024;
+  size_t size = 0;
+  char *text = (char*)malloc(capacity + 1);
+  size_t read;
+  while (text != NULL &&
+      (read = fread(text + size, 1, capacity - size, source)) > 0) {
+    size += read;
+    if (size == capacity) {
+      capacity *= 2;
+      char *grown = (char*)realloc(text, capacity + 1);
+      if (grown == NULL)
+        free(text);
+      text = grown;
+    }
+  }
+  if (text == NULL)
+    fprintf(stderr, "Failed to allocate %zu bytes.\n", capacity + 1);
+  else if (ferror(source)) {
+    fprintf(stderr, "Could not read %s.\n", filename);
+    free(text);
+    text = NULL;
+  }
+  if (!from_stdin)
+    fclose(source);
+  if (text == NULL)
+    return NULL;
+
+  text[size] = '\0';
+  *length = size;
+  return text;
+}
+
+// Parses the command line arguments with parse_arg(), on top of the ones
+// already found in the test file. Returns the total return value of the
+// required arguments, or -1 on error.
+int parse_args(int argc, char **argv) {
+  int req_arg = 0;
+  int arg_no = 0;
+  int parse_ret;
+  char* curr_arg;
+  char* next_arg = NULL;
+  while (++arg_no < argc) {
+    curr_arg = argv[arg_no];
+    if (strncmp(curr_arg, "---", 3)) {
+      if (++arg_no >= argc) {
+        fprintf(stderr, "Found option %s with no value.\n", curr_arg);
+        return -1;
+      }
+      next_arg = argv[arg_no];
+    }
+    parse_ret = parse_arg(curr_arg, next_arg);
+    if (!parse_ret)
+      return -1;
+    req_arg += parse_ret - 1;
+  }
+  return req_arg;
+}
+
 
 /* Function used to parse given arguments. All optional arguments must have a
  * return value of 1. The total return value of required arguments must be
@@ -892,6 +1596,21 @@ int parse_arg(char* arg, char* val) {
   if (!strcmp(arg, "-a") || !strcmp(arg, "--args")) {
     return 1;
   }
+  if (!strcmp(arg, "--batch")) {
+    return 1;
+  }
+  if (!strcmp(arg, "--timeout")) {
+    batch_timeout = atoi(val);
+    return 1;
+  }
+  if (!strcmp(arg, "--cache")) {
+    cache_dir = val;
+    return 1;
+  }
+  if (!strcmp(arg, "--configs")) {
+    configs = val;
+    return 1;
+  }
   if (!strcmp(arg, "-d") || !strcmp(arg, "--device_idx")) {
     device_index = atoi(val);
     return 2;
@@ -951,6 +1670,14 @@ int parse_arg(char* arg, char* val) {
     inter_thread_comm = true;
     return 1;
   }
+  if (!strcmp(arg, "---digest")) {
+    digest = true;
+    return 1;
+  }
+  if (!strcmp(arg, "---full_output")) {
+    full_output = true;
+    return 1;
+  }
   if (!strcmp(arg, "---debug")) {
     debug_build = true;
     return 1;
@@ -998,3 +1725,294 @@ int cl_error_check(cl_int err, const char *err_string) {
   fprintf(stderr, "%s: %d\n", err_string, err);
   return 1;
 }
+
+#ifdef HAVE_BATCH_MODE
+
+// Exit status of a worker that could not set up the device, so that the batch
+// is stopped rather than a new worker started for each test.
+#define BATCH_SETUP_FAILED 2
+
+enum batch_status { BATCH_DONE, BATCH_TIMEOUT, BATCH_CRASH };
+
+// A worker process, running the tests the parent writes to requests, one path
+// per line, and writing back one line per test on results_fd.
+typedef struct {
+  pid_t pid;
+  FILE *requests;
+  int results_fd;
+} batch_worker;
+
+// Resets everything the arguments of a test can set, before parsing the
+// arguments of the next one.
+void reset_kernel_params(void) {
+  atomics = false;
+  atomic_counter_no = 0;
+  atomic_reductions = false;
+  emi = false;
+  fake_divergence = false;
+  inter_thread_comm = false;
+  digest = false;
+  binary_size = 0;
+  include_path = ".";
+  debug_build = false;
+  disable_opts = false;
+  disable_fake = false;
+  disable_group = false;
+  disable_atomics = false;
+  output_binary = false;
+  full_output = false;
+
+  if (strcmp(local_dims, ""))
+    free(local_dims);
+  local_dims = "";
+  if (strcmp(global_dims, ""))
+    free(global_dims);
+  global_dims = "";
+  free(local_size);
+  local_size = NULL;
+  free(global_size);
+  global_size = NULL;
+  l_dim = 1;
+  g_dim = 1;
+  total_threads = 1;
+  no_groups = 1;
+}
+
+// Runs one test of the batch. line is the path of the test, optionally
+// followed by a tab and the path of its arguments file.
+// Return 0 on success, 1 on error.
+int run_batch_kernel(char *line, const char *default_args_file,
+    int argc, char **argv, cl_context context, cl_command_queue com_queue) {
+  reset_kernel_params();
+  char *tab = strchr(line, '\t');
+  if (tab != NULL)
+    *tab = '\0';
+  file = line;
+  args_file = tab != NULL ? tab + 1 : default_args_file;
+
+  if (!parse_file_args(args_file != NULL ? args_file : file))
+    return 1;
+  if (parse_args(argc, argv) < 0)
+    return 1;
+  if (parse_dims())
+    return 1;
+  if (check_device_limits())
+    return 1;
+  return run_kernel(context, com_queue, device, (cl_uint) l_dim);
+}
+
+// Main loop of a worker: sets up the device once, then runs the tests read from
+// requests until it is closed. Returns the exit status of the worker.
+int batch_worker_main(FILE *requests, FILE *out, int argc, char **argv) {
+  if (open_platform_device())
+    return BATCH_SETUP_FAILED;
+  cl_context context;
+  cl_command_queue com_queue;
+  if (create_context_queue(platform, device, &context, &com_queue))
+    return BATCH_SETUP_FAILED;
+
+  const char *default_args_file = args_file;
+  char line[4096];
+  while (fgets(line, sizeof(line), requests)) {
+    char *new_line;
+    if ((new_line = strchr(line, '\n')))
+      *new_line = '\0';
+    int run_err = run_batch_kernel(
+        line, default_args_file, argc, argv, context, com_queue);
+    fprintf(out, run_err ? "error\t" : "ok\t");
+    if (!run_err)
+      print_results(out, false);
+    fprintf(out, "\n");
+    fflush(out);
+    fflush(stderr);
+    release_kernel_objects();
+    release_source();
+  }
+
+  clReleaseCommandQueue(com_queue);
+  clReleaseContext(context);
+  print_cache_stats();
+  return 0;
+}
+
+// Forks a new worker. Return 0 on success, 1 on error.
+int spawn_worker(batch_worker *worker, int argc, char **argv) {
+  int to_worker[2], from_worker[2];
+  if (pipe(to_worker)) {
+    perror("Error creating pipe");
+    return 1;
+  }
+  if (pipe(from_worker)) {
+    perror("Error creating pipe");
+    close(to_worker[0]);
+    close(to_worker[1]);
+    return 1;
+  }
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("Error forking worker");
+    close(to_worker[0]);
+    close(to_worker[1]);
+    close(from_worker[0]);
+    close(from_worker[1]);
+    return 1;
+  }
+  if (pid == 0) {
+    close(to_worker[1]);
+    close(from_worker[0]);
+    FILE *requests = fdopen(to_worker[0], "r");
+    FILE *out = fdopen(from_worker[1], "w");
+    if (requests == NULL || out == NULL)
+      _exit(1);
+    _exit(batch_worker_main(requests, out, argc, argv));
+  }
+  close(to_worker[0]);
+  close(from_worker[1]);
+  worker->pid = pid;
+  worker->requests = fdopen(to_worker[1], "w");
+  worker->results_fd = from_worker[0];
+  if (worker->requests == NULL) {
+    perror("Error opening pipe to worker");
+    close(to_worker[1]);
+    return 1;
+  }
+  return 0;
+}
+
+// Stops the worker, killing it first if kill_worker is set. Returns its wait
+// status.
+int stop_worker(batch_worker *worker, bool kill_worker) {
+  int status = 0;
+  if (worker->pid < 0)
+    return status;
+  if (kill_worker)
+    kill(worker->pid, SIGKILL);
+  fclose(worker->requests);
+  close(worker->results_fd);
+  while (waitpid(worker->pid, &status, 0) < 0 && errno == EINTR)
+    ;
+  worker->pid = -1;
+  worker->requests = NULL;
+  worker->results_fd = -1;
+  return status;
+}
+
+double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Sends a test to the worker and reads back its result line into *line,
+// without the new line. Waits for at most batch_timeout seconds, if not 0.
+enum batch_status run_on_worker(batch_worker *worker, const char *test,
+    char **line, size_t *line_cap) {
+  if (fprintf(worker->requests, "%s\n", test) < 0 ||
+      fflush(worker->requests) == EOF)
+    return BATCH_CRASH;
+
+  double deadline = now_seconds() + batch_timeout;
+  size_t len = 0;
+  while (true) {
+    int wait_ms = -1;
+    if (batch_timeout > 0) {
+      double left = deadline - now_seconds();
+      if (left <= 0)
+        return BATCH_TIMEOUT;
+      wait_ms = (int) (left * 1000) + 1;
+    }
+    struct pollfd pfd = { worker->results_fd, POLLIN, 0 };
+    int ready = poll(&pfd, 1, wait_ms);
+    if (ready < 0) {
+      if (errno == EINTR)
+        continue;
+      perror("Error waiting for worker");
+      return BATCH_CRASH;
+    }
+    if (ready == 0)
+      continue;
+
+    if (len + 4096 + 1 > *line_cap) {
+      *line_cap = 2 * (len + 4096 + 1);
+      *line = (char*)realloc(*line, *line_cap);
+      assert(*line);
+    }
+    ssize_t got = read(worker->results_fd, *line + len, 4096);
+    if (got < 0 && errno == EINTR)
+      continue;
+    if (got <= 0)
+      return BATCH_CRASH;
+    len += got;
+    (*line)[len] = '\0';
+    // The worker only writes the next line once it is sent another test.
+    char *new_line = strchr(*line + len - got, '\n');
+    if (new_line) {
+      *new_line = '\0';
+      return BATCH_DONE;
+    }
+  }
+}
+
+// Runs each test of batch_list on a worker, printing one line per test:
+// the test, a tab, then "ok", a tab and the results of the threads, or one of
+// "error", "timeout" or "crash".
+// Return 0 on success, 1 if the batch could not be run.
+int run_batch(int argc, char **argv) {
+  FILE *list = stdin;
+  if (strcmp(batch_list, "-")) {
+    list = fopen(batch_list, "r");
+    if (list == NULL) {
+      fprintf(stderr, "Could not open batch list %s.\n", batch_list);
+      return 1;
+    }
+  }
+
+  // A worker dying must not take the batch with it.
+  signal(SIGPIPE, SIG_IGN);
+
+  batch_worker worker = { -1, NULL, -1 };
+  char test[4096];
+  char *line = NULL;
+  size_t line_cap = 0;
+  int batch_err = 0;
+  while (fgets(test, sizeof(test), list)) {
+    char *new_line;
+    if ((new_line = strchr(test, '\n')))
+      *new_line = '\0';
+    if (test[0] == '\0' || test[0] == '#')
+      continue;
+
+    if (worker.pid < 0 && spawn_worker(&worker, argc, argv)) {
+      batch_err = 1;
+      break;
+    }
+
+    enum batch_status res = run_on_worker(&worker, test, &line, &line_cap);
+    // Only print the path of the test, not its arguments file.
+    char *tab = strchr(test, '\t');
+    if (tab != NULL)
+      *tab = '\0';
+    if (res == BATCH_DONE) {
+      printf("%s\t%s\n", test, line);
+    } else {
+      int status = stop_worker(&worker, res == BATCH_TIMEOUT);
+      if (WIFEXITED(status) && WEXITSTATUS(status) == BATCH_SETUP_FAILED) {
+        fprintf(stderr, "Could not set up the device for the batch.\n");
+        batch_err = 1;
+        break;
+      }
+      printf("%s\t%s\n", test, res == BATCH_TIMEOUT ? "timeout" : "crash");
+    }
+    fflush(stdout);
+  }
+
+  stop_worker(&worker, false);
+  free(line);
+  if (list != stdin)
+    fclose(list);
+  return batch_err;
+}
+
+#endif
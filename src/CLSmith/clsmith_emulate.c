@@ -0,0 +1,807 @@
+// Runs a randomly generated program on the host, without an OpenCL device.
+// Usage: clsmith_emulate -f <cl_program> [flags...]
+//
+// The program is built as GNU C by the host compiler (cc, or $CC), against the
+// definitions of the OpenCL built-ins in clsmith_emulate.h, and loaded back in.
+// The work-groups are shared out between threads (-j). The work-items of a
+// work-group all run on one thread, each as a fiber with its own stack, and
+// barrier() and the fences switch to the next work-item. The results are printed in the
+// format of cl_launcher, so the emulator can stand in for it, e.g. as the
+// -cl_launcher of cl_get_and_test.py.
+//
+// Programs that use vectors are not supported.
+
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+typedef uint64_t RES_TYPE;
+
+#define DEF_LOCAL_SIZE 32
+#define DEF_GLOBAL_SIZE 1024
+#define DEF_STACK_KB 256
+#define MAX_DIMS 3
+#define MAX_KERNEL_ARGS 8
+#define MAX_COMPILER_ARGS 32
+
+// User input.
+const char *file = NULL;
+const char *args_file = NULL;
+const char *include_path = ".";
+const char *compiler = NULL;
+bool debug_build = false;
+bool disable_opts = false;
+bool disable_fake = false;
+bool disable_group = false;
+bool disable_atomics = false;
+int jobs = 0;
+int stack_kb = DEF_STACK_KB;
+
+// Kernel parameters.
+bool atomics = false;
+int atomic_counter_no = 0;
+bool atomic_reductions = false;
+bool emi = false;
+bool fake_divergence = false;
+bool inter_thread_comm = false;
+bool digest = false;
+
+// The NDRange.
+char *local_dims = NULL;
+char *global_dims = NULL;
+unsigned int work_dim = 1;
+size_t local_size[MAX_DIMS] = { DEF_LOCAL_SIZE, 1, 1 };
+size_t global_size[MAX_DIMS] = { DEF_GLOBAL_SIZE, 1, 1 };
+size_t num_groups[MAX_DIMS] = { 1, 1, 1 };
+size_t total_threads = 1;
+size_t no_groups = 1;
+size_t group_threads = 1;
+
+// The kernel and its arguments, in the order cl_launcher sets them.
+void *kernel_library = NULL;
+void (*entry)() = NULL;
+void *kernel_args[MAX_KERNEL_ARGS];
+int kernel_arg_count = 0;
+RES_TYPE *results = NULL;
+
+// Set if the work-items of a work-group did not all reach the same barriers.
+bool barrier_divergence = false;
+
+// A work-item, and the work-group running on a thread.
+typedef struct {
+  size_t local_id[MAX_DIMS];
+  ucontext_t context;
+  bool at_barrier;
+  bool finished;
+} work_item;
+
+typedef struct {
+  pthread_t thread;
+  size_t group_id[MAX_DIMS];
+  work_item *items;
+  char *stacks;
+  size_t stack_size;
+  ucontext_t scheduler;
+} group_runner;
+
+static __thread group_runner *current_runner = NULL;
+static __thread work_item *current_item = NULL;
+static size_t next_group = 0;
+
+int parse_arg(char *arg, char *val);
+int parse_file_args(const char *filename);
+int parse_args(int argc, char **argv);
+int parse_dims(void);
+int build_kernel(void);
+int create_buffers(void);
+int run_groups(void);
+void print_results(FILE *);
+void free_buffers(void);
+
+void print_help() {
+  fprintf(stderr, "Usage: ./clsmith_emulate -f <cl_program> [flags...]\n");
+  fprintf(stderr, "\n");
+  fprintf(stderr, "Required flags are:\n");
+  fprintf(stderr, "  -f FILE --filename FILE                   Test file\n");
+  fprintf(stderr, "\n");
+  fprintf(stderr, "Optional flags are:\n");
+  fprintf(stderr, "  -i PATH --include_path PATH               Include path for kernels (. by default), which must hold\n");
+  fprintf(stderr, "                                            clsmith_emulate.h as well as CLSmith.h\n");
+  fprintf(stderr, "  -l N    --locals N                        A string with comma-separated values representing the number of work-units per group per dimension\n");
+  fprintf(stderr, "  -g N    --groups N                        Same as -l, but representing the total number of work-units per dimension\n");
+  fprintf(stderr, "  -a FILE --args FILE                       Look for file-defined arguments in this file, rather than the test file\n");
+  fprintf(stderr, "  -j N    --jobs N                          Threads running work-groups (the number of processors by default)\n");
+  fprintf(stderr, "          --cc COMMAND                      Host compiler ($CC, or cc, by default)\n");
+  fprintf(stderr, "          --stack_kb N                      Stack size of each work-item (%d by default)\n", DEF_STACK_KB);
+  fprintf(stderr, "          --atomics                         Test uses atomic sections\n");
+  fprintf(stderr, "                      ---atomic_reductions  Test uses atomic reductions\n");
+  fprintf(stderr, "                      ---emi                Test uses EMI\n");
+  fprintf(stderr, "                      ---fake_divergence    Test uses fake divergence\n");
+  fprintf(stderr, "                      ---inter_thread_comm  Test uses inter-thread communication\n");
+  fprintf(stderr, "                      ---digest             Test computes digests of the results, which are not printed\n");
+  fprintf(stderr, "                      ---debug              Print debug info, and keep the build directory\n");
+  fprintf(stderr, "                      ---disable_opts       Disable compile optimisations\n");
+  fprintf(stderr, "                      ---disable_group      Disable group divergence feature\n");
+  fprintf(stderr, "                      ---disable_fake       Disable fake divergence feature\n");
+  fprintf(stderr, "                      ---disable_atomics    Disable atomic sections and reductions\n");
+  fprintf(stderr, "\n");
+  fprintf(stderr, "The cl_launcher flags -p, -d, -n and ---full_output are accepted, and ignored.\n");
+}
+
+int main(int argc, char **argv) {
+  int arg_no = 0;
+  while (++arg_no < argc) {
+    if (!strcmp(argv[arg_no], "-h") || !strcmp(argv[arg_no], "--help")) {
+      print_help();
+      return 0;
+    }
+    if (arg_no + 1 < argc &&
+        (!strcmp(argv[arg_no], "-f") || !strcmp(argv[arg_no], "--filename")))
+      file = argv[++arg_no];
+    else if (arg_no + 1 < argc &&
+        (!strcmp(argv[arg_no], "-a") || !strcmp(argv[arg_no], "--args")))
+      args_file = argv[++arg_no];
+  }
+  if (!file) {
+    fprintf(stderr, "Require file (-f) argument!\n");
+    print_help();
+    return 1;
+  }
+
+  if (!parse_file_args(args_file ? args_file : file)) {
+    fprintf(stderr, "Failed parsing file for arguments.\n");
+    return 1;
+  }
+  if (parse_args(argc, argv) < 0)
+    return 1;
+  if (parse_dims())
+    return 1;
+
+  if (build_kernel())
+    return 1;
+  fprintf(stderr, "Compilation terminated successfully...\n");
+
+  int run_err = create_buffers() || run_groups();
+  if (!run_err) {
+    if (barrier_divergence)
+      fprintf(stderr, "Warning: barrier divergence, the results are undefined\n");
+    print_results(stdout);
+  }
+  free_buffers();
+  dlclose(kernel_library);
+  return run_err;
+}
+
+// Parses the thread and group dimension information given by -l and -g, and
+// computes the number of work-units and groups from it.
+// Return 0 on success, 1 on error.
+int parse_dims(void) {
+  unsigned int l_dim = 1, g_dim = 1;
+  char *tok;
+  if (local_dims) {
+    l_dim = 0;
+    for (tok = strtok(local_dims, ","); tok; tok = strtok(NULL, ","))
+      if (l_dim++ < MAX_DIMS)
+        local_size[l_dim - 1] = (size_t)atoi(tok);
+  }
+  if (global_dims) {
+    g_dim = 0;
+    for (tok = strtok(global_dims, ","); tok; tok = strtok(NULL, ","))
+      if (g_dim++ < MAX_DIMS)
+        global_size[g_dim - 1] = (size_t)atoi(tok);
+  }
+
+  if (g_dim != l_dim) {
+    fprintf(stderr, "Local and global sizes must have same number of dimensions!\n");
+    return 1;
+  }
+  if (l_dim > MAX_DIMS) {
+    fprintf(stderr, "Cannot have more than 3 dimensions!\n");
+    return 1;
+  }
+  work_dim = l_dim;
+  unsigned int d;
+  for (d = 0; d < work_dim; d++) {
+    if (local_size[d] == 0 || global_size[d] % local_size[d]) {
+      fprintf(stderr, "Global dimension %u is not a multiple of local dimension!\n", d);
+      return 1;
+    }
+    num_groups[d] = global_size[d] / local_size[d];
+    total_threads *= global_size[d];
+    no_groups *= num_groups[d];
+    group_threads *= local_size[d];
+  }
+
+  if (debug_build)
+    fprintf(stderr, "%u-D global size %zu, %zu work-groups of %zu\n",
+            work_dim, total_threads, no_groups, group_threads);
+  return 0;
+}
+
+// Writes the program to a C file, with the declarations of local variables in
+// the kernel made CLSMITH_LOCAL. Return 0 on success, 1 on error, 2 if the
+// program uses vectors.
+int write_c_source(const char *c_path) {
+  FILE *in = fopen(file, "r");
+  if (in == NULL) {
+    fprintf(stderr, "Could not open %s.\n", file);
+    return 1;
+  }
+  FILE *out = fopen(c_path, "w");
+  if (out == NULL) {
+    fprintf(stderr, "Could not open %s.\n", c_path);
+    fclose(in);
+    return 1;
+  }
+  fprintf(out, "#line 1 \"%s\"\n", file);
+
+  char *line = NULL;
+  size_t line_size = 0;
+  ssize_t len;
+  bool in_kernel = false;
+  int ret = 0;
+  while ((len = getline(&line, &line_size, in)) > 0) {
+    char *text = line + strspn(line, " \t");
+    if (strstr(text, "VECTOR(") && strncmp(text, "#define", 7)) {
+      ret = 2;
+      break;
+    }
+    if (!strncmp(text, "__kernel", 8))
+      in_kernel = true;
+    // Local pointers stay as they are, only arrays become shared.
+    char *end = text + strcspn(text, "\r\n");
+    if (in_kernel && !strncmp(text, "__local ", 8) && !strchr(text, '*') &&
+        end - text >= 2 && !strncmp(end - 2, "];", 2)) {
+      fwrite(line, 1, text - line, out);
+      fprintf(out, "CLSMITH_LOCAL%s", text + strlen("__local"));
+    } else {
+      fwrite(line, 1, len, out);
+    }
+  }
+  free(line);
+  fclose(in);
+  if (fclose(out))
+    ret = 1;
+  return ret;
+}
+
+// Runs the host compiler on the C source, to build the shared library. Its
+// messages are only shown in debug mode. Return 0 on success, 1 on error.
+int run_compiler(const char *c_path, const char *lib_path) {
+  const char *args[MAX_COMPILER_ARGS + 24];
+  int count = 0;
+  char *command = strdup(compiler ? compiler : getenv("CC") ? getenv("CC") : "cc");
+  char *tok;
+  for (tok = strtok(command, " "); tok && count < MAX_COMPILER_ARGS;
+       tok = strtok(NULL, " "))
+    args[count++] = tok;
+  args[count++] = "-std=gnu99";
+  args[count++] = "-w";
+  args[count++] = disable_opts ? "-O0" : "-O1";
+  args[count++] = "-fPIC";
+  args[count++] = "-shared";
+  args[count++] = "-I";
+  args[count++] = include_path;
+  args[count++] = "-include";
+  args[count++] = "clsmith_emulate.h";
+  if (disable_group)
+    args[count++] = "-DNO_GROUP_DIVERGENCE";
+  if (disable_fake)
+    args[count++] = "-DNO_FAKE_DIVERGENCE";
+  if (disable_atomics)
+    args[count++] = "-DNO_ATOMICS";
+  args[count++] = "-o";
+  args[count++] = lib_path;
+  args[count++] = c_path;
+  args[count] = NULL;
+
+  if (debug_build) {
+    int i;
+    for (i = 0; i < count; i++)
+      fprintf(stderr, "%s%s", i ? " " : "", args[i]);
+    fprintf(stderr, "\n");
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid < 0) {
+    fprintf(stderr, "Could not run the compiler: %s\n", strerror(errno));
+    free(command);
+    return 1;
+  }
+  if (pid == 0) {
+    if (!debug_build) {
+      int null_fd = open("/dev/null", O_WRONLY);
+      if (null_fd >= 0) {
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+      }
+    }
+    execvp(args[0], (char **)args);
+    fprintf(stderr, "Could not run %s: %s\n", args[0], strerror(errno));
+    _exit(127);
+  }
+  free(command);
+  int status;
+  while (waitpid(pid, &status, 0) < 0)
+    if (errno != EINTR)
+      return 1;
+  return !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
+
+// Builds the program into a shared library in a temporary directory, and
+// loads its kernel. Return 0 on success, 1 on error.
+int build_kernel(void) {
+  const char *tmp = getenv("TMPDIR");
+  char dir[4096];
+  snprintf(dir, sizeof(dir), "%s/clsmith_emulate.XXXXXX", tmp && *tmp ? tmp : "/tmp");
+  if (mkdtemp(dir) == NULL) {
+    fprintf(stderr, "Could not create a build directory: %s\n", strerror(errno));
+    return 1;
+  }
+  char c_path[4200], lib_path[4200];
+  snprintf(c_path, sizeof(c_path), "%s/kernel.c", dir);
+  snprintf(lib_path, sizeof(lib_path), "%s/kernel.so", dir);
+
+  int err = write_c_source(c_path);
+  if (err == 2)
+    fprintf(stderr, "Error building program: vectors are not supported by the emulator\n");
+  else if (!err && run_compiler(c_path, lib_path)) {
+    fprintf(stderr, "Error building program\n");
+    err = 1;
+  }
+  if (!err) {
+    kernel_library = dlopen(lib_path, RTLD_NOW | RTLD_LOCAL);
+    if (kernel_library == NULL) {
+      fprintf(stderr, "Error loading program: %s\n", dlerror());
+      err = 1;
+    }
+  }
+  if (!err) {
+    *(void **)&entry = dlsym(kernel_library, "entry");
+    if (entry == NULL) {
+      fprintf(stderr, "Error creating kernel: no entry function\n");
+      err = 1;
+    }
+  }
+
+  if (debug_build) {
+    fprintf(stderr, "Build directory kept in %s\n", dir);
+  } else {
+    unlink(c_path);
+    unlink(lib_path);
+    rmdir(dir);
+  }
+  return err != 0;
+}
+
+// Allocates a kernel argument and fills it with copies of value, which has
+// the given size. Returns NULL on error.
+void *add_buffer(size_t count, size_t size, const void *value) {
+  char *buffer = (char *)malloc(count * size);
+  if (buffer == NULL) {
+    fprintf(stderr, "Failed to malloc %zu bytes.\n", count * size);
+    return NULL;
+  }
+  size_t i;
+  for (i = 0; value && i < count; i++)
+    memcpy(buffer + i * size, value, size);
+  kernel_args[kernel_arg_count++] = buffer;
+  return buffer;
+}
+
+// Creates the kernel arguments, with the contents cl_launcher gives them.
+// Return 0 on success, 1 on error.
+int create_buffers(void) {
+  const RES_TYPE zero_result = 0;
+  const uint32_t zero_uint = 0;
+  const int32_t zero_int = 0;
+  const int64_t one_long = 1;
+
+  results = (RES_TYPE *)add_buffer(total_threads, sizeof(RES_TYPE), &zero_result);
+  if (!results)
+    return 1;
+  if (atomics) {
+    size_t total_counters = (size_t)atomic_counter_no * no_groups;
+    if (!add_buffer(total_counters, sizeof(uint32_t), &zero_uint) ||
+        !add_buffer(total_counters, sizeof(uint32_t), &zero_uint))
+      return 1;
+  }
+  if (atomic_reductions && !add_buffer(no_groups, sizeof(int32_t), &zero_int))
+    return 1;
+  if (emi) {
+    int32_t *emi_values = (int32_t *)add_buffer(1024, sizeof(int32_t), NULL);
+    if (!emi_values)
+      return 1;
+    int i;
+    for (i = 0; i < 1024; ++i)
+      emi_values[i] = 1024 - i;
+  }
+  if (fake_divergence) {
+    size_t max_dimen = global_size[0];
+    size_t i;
+    for (i = 1; i < work_dim; ++i)
+      if (global_size[i] > max_dimen)
+        max_dimen = global_size[i];
+    int32_t *sequence_input = (int32_t *)add_buffer(max_dimen, sizeof(int32_t), NULL);
+    if (!sequence_input)
+      return 1;
+    for (i = 0; i < max_dimen; ++i)
+      sequence_input[i] = 10 + i;
+  }
+  if (inter_thread_comm && !add_buffer(total_threads, sizeof(int64_t), &one_long))
+    return 1;
+  if (digest && !add_buffer(4 * (no_groups + 1), sizeof(uint32_t), &zero_uint))
+    return 1;
+  return 0;
+}
+
+void free_buffers(void) {
+  int i;
+  for (i = 0; i < kernel_arg_count; i++)
+    free(kernel_args[i]);
+  kernel_arg_count = 0;
+  results = NULL;
+}
+
+// The work-item functions and barrier, called by the kernel.
+unsigned int get_work_dim(void) {
+  return work_dim;
+}
+
+size_t get_global_size(unsigned int dim) {
+  return dim < work_dim ? global_size[dim] : 1;
+}
+
+size_t get_global_id(unsigned int dim) {
+  return dim < work_dim ?
+      current_runner->group_id[dim] * local_size[dim] + current_item->local_id[dim] : 0;
+}
+
+size_t get_local_size(unsigned int dim) {
+  return dim < work_dim ? local_size[dim] : 1;
+}
+
+size_t get_local_id(unsigned int dim) {
+  return dim < work_dim ? current_item->local_id[dim] : 0;
+}
+
+size_t get_num_groups(unsigned int dim) {
+  return dim < work_dim ? num_groups[dim] : 1;
+}
+
+size_t get_group_id(unsigned int dim) {
+  return dim < work_dim ? current_runner->group_id[dim] : 0;
+}
+
+// Waits for the rest of the work-group, by going back to the scheduler, which
+// runs every other work-item up to this barrier before resuming this one.
+void barrier(unsigned int flags) {
+  (void)flags;
+  current_item->at_barrier = true;
+  swapcontext(&current_item->context, &current_runner->scheduler);
+}
+
+// Goes back to the scheduler, which runs the other work-items for a while
+// before resuming this one.
+void clsmith_yield(void) {
+  swapcontext(&current_item->context, &current_runner->scheduler);
+}
+
+static void call_entry(void) {
+  void **a = kernel_args;
+  switch (kernel_arg_count) {
+    case 1: ((void (*)(void *))entry)(a[0]); break;
+    case 2: ((void (*)(void *, void *))entry)(a[0], a[1]); break;
+    case 3: ((void (*)(void *, void *, void *))entry)(a[0], a[1], a[2]); break;
+    case 4:
+      ((void (*)(void *, void *, void *, void *))entry)(a[0], a[1], a[2], a[3]);
+      break;
+    case 5:
+      ((void (*)(void *, void *, void *, void *, void *))entry)(
+          a[0], a[1], a[2], a[3], a[4]);
+      break;
+    case 6:
+      ((void (*)(void *, void *, void *, void *, void *, void *))entry)(
+          a[0], a[1], a[2], a[3], a[4], a[5]);
+      break;
+    case 7:
+      ((void (*)(void *, void *, void *, void *, void *, void *, void *))entry)(
+          a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+      break;
+    case 8:
+      ((void (*)(void *, void *, void *, void *, void *, void *, void *, void *))entry)(
+          a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+      break;
+  }
+}
+
+// Where each work-item starts. When it returns, its context goes back to the
+// scheduler.
+static void work_item_main(void) {
+  call_entry();
+  current_item->finished = true;
+}
+
+// Runs one work-group to completion on the runner. The work-items are run in
+// turn, each up to its next barrier, fence or end. Once all the work-items
+// left are at a barrier, they are let through it.
+static void run_group(group_runner *runner, size_t group) {
+  runner->group_id[0] = group % num_groups[0];
+  runner->group_id[1] = group / num_groups[0] % num_groups[1];
+  runner->group_id[2] = group / (num_groups[0] * num_groups[1]);
+
+  size_t i;
+  for (i = 0; i < group_threads; i++) {
+    work_item *item = &runner->items[i];
+    item->local_id[0] = i % local_size[0];
+    item->local_id[1] = i / local_size[0] % local_size[1];
+    item->local_id[2] = i / (local_size[0] * local_size[1]);
+    item->at_barrier = false;
+    item->finished = false;
+    getcontext(&item->context);
+    item->context.uc_stack.ss_sp = runner->stacks + i * runner->stack_size;
+    item->context.uc_stack.ss_size = runner->stack_size;
+    item->context.uc_link = &runner->scheduler;
+    makecontext(&item->context, work_item_main, 0);
+  }
+
+  size_t live = group_threads, waiting = 0;
+  bool ended = false;
+  while (live) {
+    for (i = 0; i < group_threads; i++) {
+      work_item *item = &runner->items[i];
+      if (item->finished || item->at_barrier)
+        continue;
+      current_item = item;
+      swapcontext(&runner->scheduler, &item->context);
+      if (item->finished) {
+        --live;
+        ended = true;
+      } else if (item->at_barrier) {
+        ++waiting;
+      }
+    }
+    if (live && waiting == live) {
+      // Some work-items ended instead of reaching the barrier.
+      if (ended)
+        barrier_divergence = true;
+      for (i = 0; i < group_threads; i++)
+        runner->items[i].at_barrier = false;
+      waiting = 0;
+      ended = false;
+    }
+  }
+}
+
+static void *runner_main(void *arg) {
+  group_runner *runner = (group_runner *)arg;
+  current_runner = runner;
+  size_t group;
+  while ((group = __atomic_fetch_add(&next_group, 1, __ATOMIC_RELAXED)) < no_groups)
+    run_group(runner, group);
+  return NULL;
+}
+
+// Runs all the work-groups. Return 0 on success, 1 on error.
+int run_groups(void) {
+  if (jobs <= 0)
+    jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (jobs <= 0)
+    jobs = 1;
+  if ((size_t)jobs > no_groups)
+    jobs = (int)no_groups;
+
+  // Each stack has a guard page below it, so that an overflow crashes rather
+  // than running into the next one.
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t stack_size = ((size_t)stack_kb * 1024 + page - 1) / page * page + page;
+
+  group_runner *runners = (group_runner *)calloc(jobs, sizeof(group_runner));
+  if (runners == NULL) {
+    fprintf(stderr, "Failed to calloc %d runners.\n", jobs);
+    return 1;
+  }
+  int err = 0, started = 0, j;
+  for (j = 0; j < jobs && !err; j++) {
+    group_runner *runner = &runners[j];
+    runner->stack_size = stack_size;
+    runner->items = (work_item *)calloc(group_threads, sizeof(work_item));
+    runner->stacks = (char *)mmap(NULL, group_threads * stack_size,
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (runner->items == NULL || runner->stacks == MAP_FAILED) {
+      fprintf(stderr, "Failed to allocate the stacks of %zu work-items.\n", group_threads);
+      runner->stacks = NULL;
+      err = 1;
+      break;
+    }
+    size_t i;
+    for (i = 0; i < group_threads; i++)
+      mprotect(runner->stacks + i * stack_size, page, PROT_NONE);
+  }
+  // The first runner uses this thread.
+  for (j = 1; j < jobs && !err; j++, started++) {
+    if (pthread_create(&runners[j].thread, NULL, runner_main, &runners[j])) {
+      fprintf(stderr, "Could not start a thread.\n");
+      err = 1;
+      break;
+    }
+  }
+  if (!err)
+    runner_main(&runners[0]);
+  for (j = 1; j <= started; j++)
+    pthread_join(runners[j].thread, NULL);
+
+  for (j = 0; j < jobs; j++) {
+    if (runners[j].stacks)
+      munmap(runners[j].stacks, group_threads * stack_size);
+    free(runners[j].items);
+  }
+  free(runners);
+  return err;
+}
+
+// Prints the values computed by the threads, as cl_launcher does.
+void print_results(FILE *out) {
+  size_t i;
+  for (i = 0; i < total_threads; ++i)
+    fprintf(out, "%#" PRIx64 ",", results[i]);
+}
+
+int parse_file_args(const char *filename) {
+  FILE *source = fopen(filename, "r");
+  if (source == NULL) {
+    fprintf(stderr, "Could not open file %s for argument parsing.\n", filename);
+    return 0;
+  }
+
+  char arg_buf[256];
+  if (fgets(arg_buf, sizeof(arg_buf), source) == NULL)
+    arg_buf[0] = '\0';
+  arg_buf[strcspn(arg_buf, "\r\n")] = '\0';
+
+  int ok = 1;
+  if (!strncmp(arg_buf, "//", 2)) {
+    char *tok = strtok(arg_buf, " ");
+    while (tok && ok) {
+      if (!strncmp(tok, "---", 3))
+        ok = parse_arg(tok, NULL);
+      else if (!strncmp(tok, "-", 1))
+        ok = parse_arg(tok, strtok(NULL, " "));
+      tok = strtok(NULL, " ");
+    }
+  }
+
+  fclose(source);
+  return ok;
+}
+
+// Parses the command line arguments with parse_arg(), on top of the ones
+// already found in the test file. Returns 0, or -1 on error.
+int parse_args(int argc, char **argv) {
+  int arg_no = 0;
+  while (++arg_no < argc) {
+    char *curr_arg = argv[arg_no];
+    char *next_arg = NULL;
+    if (strncmp(curr_arg, "---", 3)) {
+      if (++arg_no >= argc) {
+        fprintf(stderr, "Found option %s with no value.\n", curr_arg);
+        return -1;
+      }
+      next_arg = argv[arg_no];
+    }
+    if (!parse_arg(curr_arg, next_arg))
+      return -1;
+  }
+  return 0;
+}
+
+// Parses one argument. Returns 1 on success, 0 on error.
+int parse_arg(char *arg, char *val) {
+  if (!strcmp(arg, "-f") || !strcmp(arg, "--filename") ||
+      !strcmp(arg, "-a") || !strcmp(arg, "--args")) {
+    return 1;
+  }
+  // There is no platform or device to choose.
+  if (!strcmp(arg, "-p") || !strcmp(arg, "--platform_idx") ||
+      !strcmp(arg, "-d") || !strcmp(arg, "--device_idx") ||
+      !strcmp(arg, "-n") || !strcmp(arg, "--name") ||
+      !strcmp(arg, "---set_device_from_name")) {
+    return 1;
+  }
+  // The results are always printed in full.
+  if (!strcmp(arg, "---full_output"))
+    return 1;
+  if (val == NULL && strncmp(arg, "---", 3)) {
+    fprintf(stderr, "Found option %s with no value.\n", arg);
+    return 0;
+  }
+  if (!strcmp(arg, "-l") || !strcmp(arg, "--locals")) {
+    free(local_dims);
+    local_dims = strdup(val);
+    return 1;
+  }
+  if (!strcmp(arg, "-g") || !strcmp(arg, "--groups")) {
+    free(global_dims);
+    global_dims = strdup(val);
+    return 1;
+  }
+  if (!strcmp(arg, "-i") || !strcmp(arg, "--include_path")) {
+    include_path = val;
+    return 1;
+  }
+  if (!strcmp(arg, "-j") || !strcmp(arg, "--jobs")) {
+    jobs = atoi(val);
+    return 1;
+  }
+  if (!strcmp(arg, "--cc")) {
+    compiler = val;
+    return 1;
+  }
+  if (!strcmp(arg, "--stack_kb")) {
+    stack_kb = atoi(val);
+    return stack_kb > 0;
+  }
+  if (!strcmp(arg, "--atomics")) {
+    atomics = true;
+    atomic_counter_no = atoi(val);
+    return 1;
+  }
+  if (!strcmp(arg, "---atomic_reductions")) {
+    atomic_reductions = true;
+    return 1;
+  }
+  if (!strcmp(arg, "---emi")) {
+    emi = true;
+    return 1;
+  }
+  if (!strcmp(arg, "---fake_divergence")) {
+    fake_divergence = true;
+    return 1;
+  }
+  if (!strcmp(arg, "---inter_thread_comm")) {
+    inter_thread_comm = true;
+    return 1;
+  }
+  if (!strcmp(arg, "---digest")) {
+    digest = true;
+    return 1;
+  }
+  if (!strcmp(arg, "---debug")) {
+    debug_build = true;
+    return 1;
+  }
+  if (!strcmp(arg, "---disable_opts")) {
+    disable_opts = true;
+    return 1;
+  }
+  if (!strcmp(arg, "---disable_fake")) {
+    disable_fake = true;
+    return 1;
+  }
+  if (!strcmp(arg, "---disable_group")) {
+    disable_group = true;
+    return 1;
+  }
+  if (!strcmp(arg, "---disable_atomics")) {
+    disable_atomics = true;
+    return 1;
+  }
+  fprintf(stderr, "Failed parsing arg %s.", arg);
+  return 0;
+}
@@ -38,16 +38,17 @@
 
 using namespace std;
 
-DFSOutputMgr *DFSOutputMgr::instance_ = NULL;
+thread_local DFSOutputMgr *DFSOutputMgr::instance_ = NULL;
 
 DFSOutputMgr::DFSOutputMgr()
+	: main_out_(&std::cout)
 {
 
 }
 
 DFSOutputMgr::~DFSOutputMgr()
 {
-
+	instance_ = NULL;
 }
 
 DFSOutputMgr *
@@ -104,7 +105,7 @@ DFSOutputMgr::Output()
 std::ostream &
 DFSOutputMgr::get_main_out()
 {
-	return std::cout;
+	return *main_out_;
 }
 
 void
@@ -52,14 +52,19 @@ public:
 	
 	virtual void output_tab(ostream &out, int indent);
 
+	// The programs go to the standard output unless set otherwise.
+	void set_main_out(std::ostream *out) { main_out_ = out; }
+
 private:
 	DFSOutputMgr();
 
 	virtual std::ostream &get_main_out();
 
-	static DFSOutputMgr *instance_;
+	static thread_local DFSOutputMgr *instance_;
 
 	std::string struct_output_;
+
+	std::ostream *main_out_;
 };
 
 #endif // DFS_OUTPUT_MGR_H
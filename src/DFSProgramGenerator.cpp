@@ -29,12 +29,17 @@
 
 #include "DFSProgramGenerator.h"
 #include <cassert>
+#include <fstream>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <vector>
 #include "RandomNumber.h"
 #include "AbsRndNumGenerator.h"
+#include "CGOptions.h"
 #include "DFSRndNumGenerator.h"
 #include "DFSOutputMgr.h"
+#include "DFSWorkQueue.h"
 #include "Finalization.h"
 #include "Error.h"
 #include "Function.h"
@@ -81,9 +86,22 @@ DFSProgramGenerator::goGenerator()
 {
 	DFSRndNumGenerator *impl = 
 		dynamic_cast<DFSRndNumGenerator*>(RandomNumber::GetRndNumGenerator());
-	//unsigned long long count = 0;
 	GenerateAllTypes();
 	output_mgr_->OutputStructUnions(cout);
+	if (CGOptions::dfs_jobs() > 1)
+		generate_in_parallel();
+	else
+		generate_programs(impl, cout);
+}
+
+/*
+ * Generates all the programs of the search, or of the subtree the search
+ * has been restricted to.
+ */
+void
+DFSProgramGenerator::generate_programs(DFSRndNumGenerator *impl, ostream &out)
+{
+	//unsigned long long count = 0;
 	while(!impl->get_all_done()) {
 		Error::set_error(SUCCESS);
 		GenerateFunctions();
@@ -93,7 +111,7 @@ DFSProgramGenerator::goGenerator()
 				//cout << "here" << std::endl;
 			output_mgr_->OutputHeader(argc_, argv_, seed_);
 			output_mgr_->Output();
-			OutputMgr::really_outputln(cout);
+			OutputMgr::really_outputln(out);
 			good_count_++;
 		}
 		impl->reset_state();
@@ -105,3 +123,73 @@ DFSProgramGenerator::goGenerator()
 	}
 }
 
+/*
+ * Shares the search between --dfs-jobs threads, each writing the programs
+ * it finds to its own file. Together they are the programs of the serial
+ * search, though not in the same order.
+ */
+void
+DFSProgramGenerator::generate_in_parallel(void)
+{
+	const int jobs = CGOptions::dfs_jobs();
+	vector<ofstream*> outs;
+	for (int job = 0; job < jobs; ++job) {
+		ostringstream name;
+		name << CGOptions::dfs_output() << "." << job;
+		outs.push_back(new ofstream(name.str().c_str()));
+		if (!*outs.back()) {
+			cerr << "cannot open " << name.str() << endl;
+			for (size_t i = 0; i < outs.size(); ++i)
+				delete outs[i];
+			return;
+		}
+	}
+
+	DFSWorkQueue queue;
+	queue.push(vector<int>());
+
+	// These are toggled during generation and are kept per thread, so each
+	// thread must start with the values set here.
+	const bool access_once = CGOptions::access_once();
+	const bool match_exact_qualifiers = CGOptions::match_exact_qualifiers();
+	auto worker = [&](int job) {
+		CGOptions::access_once(access_once);
+		CGOptions::match_exact_qualifiers(match_exact_qualifiers);
+		PartialExpander::restore_init_values();
+		// Each thread has its own generator, and its own copy of the state
+		// of the program being generated.
+		DFSProgramGenerator *generator = dynamic_cast<DFSProgramGenerator*>(
+			AbsProgramGenerator::CreateInstance(argc_, argv_, seed_));
+		assert(generator);
+		generator->explore_subtrees(queue, *outs[job]);
+		delete generator;
+	};
+
+	vector<thread> threads;
+	for (int job = 0; job < jobs; ++job)
+		threads.push_back(thread(worker, job));
+	for (size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+
+	for (size_t i = 0; i < outs.size(); ++i)
+		delete outs[i];
+}
+
+/*
+ * Runs on a thread sharing the search: explores the subtrees taken from the
+ * queue until none is left.
+ */
+void
+DFSProgramGenerator::explore_subtrees(DFSWorkQueue &queue, ostream &out)
+{
+	DFSRndNumGenerator *impl = 
+		dynamic_cast<DFSRndNumGenerator*>(RandomNumber::GetRndNumGenerator());
+	dynamic_cast<DFSOutputMgr*>(output_mgr_)->set_main_out(&out);
+	GenerateAllTypes();
+	vector<int> prefix;
+	while (queue.pop(prefix)) {
+		impl->explore_subtree(prefix, CGOptions::dfs_split_depth(), &queue);
+		generate_programs(impl, out);
+		queue.done();
+	}
+}
@@ -30,10 +30,13 @@
 #ifndef DFS_PROGRAM_GENERATOR_H
 #define DFS_PROGRAM_GENERATOR_H
 
+#include <iosfwd>
 #include "AbsProgramGenerator.h"
 #include "Common.h"
 
 class OutputMgr;
+class DFSRndNumGenerator;
+class DFSWorkQueue;
 
 class DFSProgramGenerator : public AbsProgramGenerator {
 public:
@@ -50,6 +53,12 @@ public:
 	virtual std::string get_count_prefix(const std::string &name);
 
 private:
+	void generate_programs(DFSRndNumGenerator *impl, std::ostream &out);
+
+	void generate_in_parallel(void);
+
+	void explore_subtrees(DFSWorkQueue &queue, std::ostream &out);
+
 	int argc_;
 
 	char **argv_;
@@ -34,6 +34,7 @@
 #include <sstream>
 
 #include "CGOptions.h"
+#include "DFSWorkQueue.h"
 #include "Filter.h"
 #include "SequenceFactory.h"
 #include "Sequence.h"
@@ -128,15 +129,18 @@ void DFSRndNumGenerator::SearchState::dump(const string &)
 #endif
 // ----------------------------------------------------------------------------------------------
 
-DFSRndNumGenerator *DFSRndNumGenerator::impl_ = 0;
+thread_local DFSRndNumGenerator *DFSRndNumGenerator::impl_ = 0;
 
-DFSRndNumGenerator::DFSRndNumGenerator(Sequence *concrete_seq)
-	: trace_string_(""),
+DFSRndNumGenerator::DFSRndNumGenerator(const unsigned long seed, Sequence *concrete_seq)
+	: AbsRndNumGenerator(seed),
+	  trace_string_(""),
 	  decision_depth_(-1),
 	  current_pos_(-1),
 	  all_done_(false),
 	  seq_(concrete_seq),
-	  use_debug_sequence_(false)
+	  use_debug_sequence_(false),
+	  split_depth_(0),
+	  queue_(NULL)
 {
 	init_states(CGOptions::max_exhaustive_depth());
 }
@@ -149,20 +153,21 @@ DFSRndNumGenerator::~DFSRndNumGenerator()
 	}
 	states_.clear();
 	SequenceFactory::destroy_sequences();
+	impl_ = 0;
 }
 
 /*
  * Singleton
  */
 DFSRndNumGenerator*
-DFSRndNumGenerator::make_rndnum_generator()
+DFSRndNumGenerator::make_rndnum_generator(const unsigned long seed)
 {
 	if (impl_)
 		return impl_;
 
 	Sequence *seq = SequenceFactory::make_sequence();
 
-	impl_ = new DFSRndNumGenerator(seq);
+	impl_ = new DFSRndNumGenerator(seed, seq);
 
 	assert(impl_);
 	
@@ -222,6 +227,13 @@ DFSRndNumGenerator::eager_backtracking(int depth_needed)
 	if (remain_depth >= depth_needed)
 		return false;
 
+	// Backtracking into the prefix leaves the subtree being explored.
+	if (current_pos_ < root_depth()) {
+		all_done_ = true;
+		Error::set_error(BACKTRACKING_ERROR);
+		return true;
+	}
+
 	if (current_pos_ > decision_depth_) {
 		Error::set_error(BACKTRACKING_ERROR);
 		return true;
@@ -302,6 +314,9 @@ DFSRndNumGenerator::random_choice (int bound, const Filter *filter, const string
 		return -1;
 	}
 
+	if (current_pos_ < root_depth())
+		return prefix_choice(bound, filter, invalid_nums);
+
 	DFSRndNumGenerator::SearchState *state = states_[current_pos_];
 
 	state->set_bound(bound);
@@ -316,13 +331,19 @@ DFSRndNumGenerator::random_choice (int bound, const Filter *filter, const string
 	if (state->init()) {
 		int v = state->value();
 		int local_decision_depth = decision_depth_;
-		do { // Filter out invalid value
-			++v;
-			state->set_value(v);
-			current_pos_ = local_current_pos;
-			decision_depth_ = local_decision_depth;
-			ERROR_GUARD(-1);
-		} while (v < bound && ((filter && filter->filter(v)) || filter_invalid_nums(invalid_nums, v)));
+		if (is_split_node(local_current_pos)) {
+			// The other branches are in the work queue.
+			v = bound;
+		}
+		else {
+			do { // Filter out invalid value
+				++v;
+				state->set_value(v);
+				current_pos_ = local_current_pos;
+				decision_depth_ = local_decision_depth;
+				ERROR_GUARD(-1);
+			} while (v < bound && ((filter && filter->filter(v)) || filter_invalid_nums(invalid_nums, v)));
+		}
 
 		state->set_value(v);
 		
@@ -332,7 +353,7 @@ DFSRndNumGenerator::random_choice (int bound, const Filter *filter, const string
 				states_[i]->set_init(false);
 			}
 			--decision_depth_;
-			if (decision_depth_ < 0)
+			if (decision_depth_ < root_depth())
 				all_done_ = true;
 			Error::set_error(BACKTRACKING_ERROR);
 			return -1;
@@ -368,7 +389,7 @@ DFSRndNumGenerator::random_choice (int bound, const Filter *filter, const string
 				states_[i]->set_init(false);
 			}
 			--decision_depth_;
-			if (decision_depth_ < 0)
+			if (decision_depth_ < root_depth())
 				all_done_ = true;
 			Error::set_error(BACKTRACKING_ERROR);
 			return -1;
@@ -378,11 +399,66 @@ DFSRndNumGenerator::random_choice (int bound, const Filter *filter, const string
 
 		ERROR_GUARD(-1);
 
+		if (is_split_node(local_current_pos))
+			split_node(local_current_pos, v, bound);
+
 		seq_->add_number(v, bound, local_current_pos);
 		return v;
 	}
 }
 
+/*
+ * The choices of the prefix are fixed. If one of them is not valid here,
+ * the subtree is empty, as it is in the whole search.
+ */
+int
+DFSRndNumGenerator::prefix_choice(int bound, const Filter *filter, vector<int> *invalid_nums)
+{
+	int local_current_pos = current_pos_;
+	int v = prefix_[current_pos_];
+
+	if (v >= bound || (filter && filter->filter(v)) || filter_invalid_nums(invalid_nums, v)) {
+		ERROR_GUARD(-1);
+		all_done_ = true;
+		Error::set_error(BACKTRACKING_ERROR);
+		return -1;
+	}
+	ERROR_GUARD(-1);
+
+	seq_->add_number(v, bound, local_current_pos);
+	return v;
+}
+
+/*
+ * Hands the branches of a node after the one just taken to the work queue,
+ * as the subtrees below the choices leading to them.
+ */
+void
+DFSRndNumGenerator::split_node(int pos, int value, int bound)
+{
+	vector<int> prefix(prefix_);
+	for (int i = root_depth(); i < pos; ++i)
+		prefix.push_back(states_[i]->value());
+	prefix.push_back(value);
+	for (int v = value + 1; v < bound; ++v) {
+		prefix[pos] = v;
+		queue_->push(prefix);
+	}
+}
+
+void
+DFSRndNumGenerator::explore_subtree(const vector<int> &prefix, int split_depth, DFSWorkQueue *queue)
+{
+	for (int i = 0; i < CGOptions::max_exhaustive_depth(); ++i)
+		states_[i]->set_init(false);
+	prefix_ = prefix;
+	split_depth_ = split_depth;
+	queue_ = queue;
+	reset_state();
+	decision_depth_ = root_depth() - 1;
+	all_done_ = false;
+}
+
 void
 DFSRndNumGenerator::log_depth(int d, const string *where, const char *log)
 {
@@ -414,6 +490,10 @@ DFSRndNumGenerator::reset_state(void)
 	current_pos_ = -1;
 	trace_string_ = "";
 	seq_->clear();
+	// No choice was left to make below the prefix: it leads to a single
+	// program, or none.
+	if (decision_depth_ < root_depth())
+		all_done_ = true;
 }
 
 /*
@@ -39,13 +39,14 @@
 
 class Sequence;
 class Filter;
+class DFSWorkQueue;
 
 class DFSRndNumGenerator : public AbsRndNumGenerator
 {
 public:
 	virtual ~DFSRndNumGenerator();
 
-	static DFSRndNumGenerator *make_rndnum_generator();
+	static DFSRndNumGenerator *make_rndnum_generator(const unsigned long seed);
 
 	virtual std::string get_prefixed_name(const std::string &name);
 
@@ -75,12 +76,25 @@ public:
 
 	bool get_all_done(void) { return all_done_; }
 
+	// Restarts the search on the subtree below the given choices only. The
+	// other branches of the nodes above split_depth are added to the queue
+	// instead of being explored.
+	void explore_subtree(const std::vector<int> &prefix, int split_depth, DFSWorkQueue *queue);
+
 private:
 	// Forward declaration of nested class SearchState;
 	class SearchState;
 
 	// ------------------------------------------------------------------------------------------
-	DFSRndNumGenerator(Sequence *concrete_seq);
+	DFSRndNumGenerator(const unsigned long seed, Sequence *concrete_seq);
+
+	int prefix_choice(int bound, const Filter *f, std::vector<int> *invalid_nums);
+
+	void split_node(int pos, int value, int bound);
+
+	bool is_split_node(int pos) { return queue_ && pos < split_depth_; }
+
+	int root_depth(void) { return static_cast<int>(prefix_.size()); }
 
 	int revisit_node(SearchState *state, int local_current_pos,
 						int bound, const Filter *f, const string *where);
@@ -100,7 +114,7 @@ private:
 	void log_depth(int d, const std::string *where = NULL, const char *log = NULL);
 
 	// ----------------------------------------------------------------------------------------
-	static DFSRndNumGenerator *impl_;
+	static thread_local DFSRndNumGenerator *impl_;
 
 	//static std::string name_prefix;
 
@@ -122,6 +136,15 @@ private:
 	// Holds the vector representation of all DFS nodes. 
 	std::vector<SearchState*> states_;
 
+	// The choices leading to the subtree being explored, empty for the whole
+	// tree. The search is over when it backtracks into them.
+	std::vector<int> prefix_;
+
+	// The nodes above this depth are split, when sharing the search.
+	int split_depth_;
+
+	DFSWorkQueue *queue_;
+
 	// disallow copy and assignment constructors
 	DISALLOW_COPY_AND_ASSIGN(DFSRndNumGenerator);
 };
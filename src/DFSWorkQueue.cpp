@@ -0,0 +1,52 @@
+// -*- mode: C++ -*-
+//
+// Implementation of the work queue declared in DFSWorkQueue.h.
+
+#include "DFSWorkQueue.h"
+#include <cassert>
+
+using namespace std;
+
+DFSWorkQueue::DFSWorkQueue(void)
+	: busy_(0)
+{
+
+}
+
+DFSWorkQueue::~DFSWorkQueue(void)
+{
+	assert(busy_ == 0);
+}
+
+void
+DFSWorkQueue::push(const vector<int> &prefix)
+{
+	lock_guard<mutex> lock(mutex_);
+	prefixes_.push_back(prefix);
+	changed_.notify_one();
+}
+
+bool
+DFSWorkQueue::pop(vector<int> &prefix)
+{
+	unique_lock<mutex> lock(mutex_);
+	while (prefixes_.empty() && busy_ > 0)
+		changed_.wait(lock);
+	if (prefixes_.empty())
+		return false;
+	prefix = prefixes_.front();
+	prefixes_.pop_front();
+	++busy_;
+	return true;
+}
+
+void
+DFSWorkQueue::done(void)
+{
+	lock_guard<mutex> lock(mutex_);
+	assert(busy_ > 0);
+	--busy_;
+	// The threads waiting for work stop if this was the last one.
+	if (busy_ == 0 && prefixes_.empty())
+		changed_.notify_all();
+}
@@ -0,0 +1,53 @@
+// -*- mode: C++ -*-
+//
+// The subtrees of the exhaustive search still to be explored when several
+// threads share it (--dfs-jobs).
+//
+// A subtree is named by the choices leading to it, its prefix. The search
+// starts with the empty prefix, the whole tree. The thread exploring a subtree
+// adds the other branches of the nodes it meets above --dfs-split-depth as new
+// subtrees, and goes on with the first one, so idle threads pick up the rest.
+// The search is over once no subtree is left and no thread is busy, as only a
+// busy thread can add more.
+
+#ifndef DFS_WORK_QUEUE_H
+#define DFS_WORK_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "CommonMacros.h"
+
+class DFSWorkQueue
+{
+public:
+	DFSWorkQueue(void);
+
+	~DFSWorkQueue(void);
+
+	void push(const std::vector<int> &prefix);
+
+	// Takes the next subtree, waiting for the busy threads if there is none.
+	// Returns false once the search is over. The subtree must be marked done
+	// after it has been explored.
+	bool pop(std::vector<int> &prefix);
+
+	void done(void);
+
+private:
+	std::mutex mutex_;
+
+	std::condition_variable changed_;
+
+	// Taken in the order they were added, which puts the larger subtrees,
+	// split off nearer the root, first.
+	std::deque<std::vector<int> > prefixes_;
+
+	// Number of threads exploring a subtree.
+	int busy_;
+
+	DISALLOW_COPY_AND_ASSIGN(DFSWorkQueue);
+};
+
+#endif // DFS_WORK_QUEUE_H
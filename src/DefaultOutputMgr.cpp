@@ -56,7 +56,7 @@ static std::string dir_sep = "\\";
 
 using namespace std;
 
-DefaultOutputMgr *DefaultOutputMgr::instance_ = NULL;
+thread_local DefaultOutputMgr *DefaultOutputMgr::instance_ = NULL;
 
 DefaultOutputMgr *
 DefaultOutputMgr::CreateInstance()
@@ -156,9 +156,9 @@ DefaultOutputMgr::OutputAllHeaders()
 void
 DefaultOutputMgr::RandomOutputVarDefs()
 {
-	vector<Variable*> *globals = VariableSelector::GetGlobalVariables();
+	const VariableList *globals = VariableSelector::GetGlobalVariables();
 	size_t size = outs.size();
-	vector<Variable*>::iterator i;
+	VariableList::const_iterator i;
 	for (i = globals->begin(); i != globals->end(); ++i) {
 		int index = pure_rnd_upto(size);
 		ostream *out = outs[index];
@@ -283,5 +283,6 @@ DefaultOutputMgr::~DefaultOutputMgr()
 	if (ofile_)
 		ofile_->close();
 	delete ofile_;
+	instance_ = NULL;
 }
 
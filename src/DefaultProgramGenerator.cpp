@@ -29,6 +29,7 @@
 
 #include "DefaultProgramGenerator.h"
 #include <cassert>
+#include <iostream>
 #include <sstream>
 #include "RandomNumber.h"
 #include "AbsRndNumGenerator.h"
@@ -66,6 +67,9 @@ DefaultProgramGenerator::initialize()
 	else {
 		RandomNumber::CreateInstance(rDefaultRndNumGenerator, seed_);
 	}
+	if (CGOptions::reduce_server()) {
+		CGOptions::init_reducer("");
+	}
 	if (CGOptions::get_reducer()) {
 		output_mgr_ = new ReducerOutputMgr();
 	} else {
@@ -86,6 +90,16 @@ DefaultProgramGenerator::get_count_prefix(const std::string &)
 void
 DefaultProgramGenerator::goGenerator()
 {
+	// see ReducerOutputMgr::serve
+	if (CGOptions::reduce_server()) {
+		GenerateAllTypes();
+		GenerateFunctions();
+		ReducerOutputMgr *mgr = dynamic_cast<ReducerOutputMgr*>(output_mgr_);
+		assert(mgr);
+		mgr->serve(argc_, argv_, std::cin, std::cout);
+		return;
+	}
+
 	output_mgr_->OutputHeader(argc_, argv_, seed_);
 
 	GenerateAllTypes();
@@ -35,28 +35,24 @@
 #include <sstream>
 #include <fstream>
 
+#include "Bookkeeper.h"
 #include "Filter.h"
 #include "SequenceFactory.h"
 #include "Sequence.h"
 #include "CGOptions.h"
 #include "DeltaMonitor.h"
 
-#ifdef WIN32
-extern "C" {
-	extern void srand48(long seed);
-	extern long lrand48(void);
-}
-#endif
-
-DefaultRndNumGenerator *DefaultRndNumGenerator::impl_ = 0;
+thread_local DefaultRndNumGenerator *DefaultRndNumGenerator::impl_ = 0;
 
 /*
  *
  */
-DefaultRndNumGenerator::DefaultRndNumGenerator(const unsigned long, Sequence *concrete_seq)
-	: rand_depth_(0),
+DefaultRndNumGenerator::DefaultRndNumGenerator(const unsigned long seed, Sequence *concrete_seq)
+	: AbsRndNumGenerator(seed),
+	  rand_depth_(0),
 	  trace_string_(""),
-	  seq_(concrete_seq)
+	  seq_(concrete_seq),
+	  record_numbers_(DeltaMonitor::is_running())
 {
 	//Nothing to do
 }
@@ -67,6 +63,7 @@ DefaultRndNumGenerator::DefaultRndNumGenerator(const unsigned long, Sequence *co
 DefaultRndNumGenerator::~DefaultRndNumGenerator()
 {
 	SequenceFactory::destroy_sequences();
+	impl_ = 0;
 }
 
 /*
@@ -82,8 +79,7 @@ DefaultRndNumGenerator::make_rndnum_generator(const unsigned long seed)
 
 	impl_ = new DefaultRndNumGenerator(seed, seq);
 	assert(impl_);
-	//impl_->seedrand(seed);
-	
+
 	return impl_;
 }
 
@@ -107,37 +103,60 @@ DefaultRndNumGenerator::get_prefixed_name(const std::string &name)
 void
 DefaultRndNumGenerator::add_number(int v, int bound, int k)
 {
-	if (DeltaMonitor::is_running())
+	if (record_numbers_)
 		seq_->add_number(v, bound, k);
 }
 
+/*
+ * Return a random number in the range 0..(n-1) that passes the filter.
+ */
+unsigned int
+DefaultRndNumGenerator::filtered_rnd_upto(const unsigned int n, const Filter *f, unsigned INT64 local_depth)
+{
+	// Draw from the accepted numbers directly when we can, unless the
+	// stream must match lrand48, which draws until a number passes.
+	if (!exact_stream()) {
+		accepted_.clear();
+		if (f->accepted_ranges(n, accepted_)) {
+			unsigned int total = 0;
+			FilterRanges::const_iterator i;
+			for (i = accepted_.begin(); i != accepted_.end(); ++i)
+				total += i->second - i->first;
+			assert(total > 0);
+			unsigned int r = genrand_upto(total);
+			for (i = accepted_.begin(); r >= i->second - i->first; ++i)
+				r -= i->second - i->first;
+			return i->first + r;
+		}
+	}
+
+	unsigned int v = genrand_upto(n);
+	while (f->filter(v)) {
+		// We could add numbers into sequence inside the previous filter.
+		// If the previous filter failed, we need to roll back the rand_depth_ here.
+		// This will also overwrite the value added in the map.
+		rand_depth_ = local_depth+1;
+		Bookkeeper::filter_reject_cnt++;
+		v = genrand_upto(n);
+	}
+	return v;
+}
+
 /*
  * Return a random number in the range 0..(n-1).
  */
 unsigned int
 DefaultRndNumGenerator::rnd_upto(const unsigned int n, const Filter *f, const std::string *where)
 {
-	static int g = 0;
-	int h = g;
-	if (h == 440)
-		BREAK_NOP;   // for debugging
-	unsigned int v = genrand() % n;
+	// Nothing to filter, trace or record, which is most of the time.
+	if (!f && !where && !record_numbers_) {
+		rand_depth_++;
+		return genrand_upto(n);
+	}
+
 	unsigned INT64 local_depth = rand_depth_;
 	rand_depth_++;
-	//ofstream out("rnd.log", ios_base::app);
-	//out << g++ << ": " << v << "(" << n << ")" << endl;
-
-	if (f) {
-		while (f->filter(v)) {
-			// We could add numbers into sequence inside the previous filter.
-			// If the previous filter failed, we need to roll back the rand_depth_ here.
-			// This will also overwrite the value added in the map.
-			rand_depth_ = local_depth+1;
-			v = genrand() % n;
-			/*out << g++ << ": " << v << "(" << n << ")" << endl;*/
-		}
-	}
-	//out.close();
+	unsigned int v = f ? filtered_rnd_upto(n, f, local_depth) : genrand_upto(n);
 	if (where) {
 	std::ostringstream ss;
 		ss << *where << "->";
@@ -154,6 +173,11 @@ bool
 DefaultRndNumGenerator::rnd_flipcoin(const unsigned int p, const Filter *f, const std::string *)
 {
 	assert(p <= 100);
+	if (!f && !record_numbers_) {
+		rand_depth_++;
+		return genrand_upto(100) < p;
+	}
+
 	unsigned INT64 local_depth = rand_depth_;
 	rand_depth_++;
 	if (f) {
@@ -167,7 +191,7 @@ DefaultRndNumGenerator::rnd_flipcoin(const unsigned int p, const Filter *f, cons
 		}
 	}
 
-	bool rv = (genrand() % 100) < p;
+	bool rv = genrand_upto(100) < p;
 	if (rv) {
 		add_number(1, 2, local_depth);
 	}
@@ -177,14 +201,6 @@ DefaultRndNumGenerator::rnd_flipcoin(const unsigned int p, const Filter *f, cons
 	return rv;
 }
 
-#if 0
-void 
-DefaultRndNumGenerator::seedrand( unsigned long seed )
-{
-	srand48 (seed);
-}
-#endif
-
 std::string &
 DefaultRndNumGenerator::trace_depth()
 {
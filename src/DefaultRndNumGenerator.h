@@ -35,9 +35,9 @@
 #include "Common.h"
 #include "CommonMacros.h"
 #include "AbsRndNumGenerator.h"
+#include "Filter.h"
 
 class Sequence;
-class Filter;
 
 // Singleton class for the implementation of default based random generator
 class DefaultRndNumGenerator : public AbsRndNumGenerator
@@ -70,7 +70,9 @@ private:
 
 	void add_number(int v, int bound, int k);
 
-	static DefaultRndNumGenerator *impl_;
+	unsigned int filtered_rnd_upto(const unsigned int n, const Filter *f, unsigned INT64 local_depth);
+
+	static thread_local DefaultRndNumGenerator *impl_;
 
 	unsigned INT64 rand_depth_;
 
@@ -78,9 +80,14 @@ private:
 
 	Sequence *seq_;
 
-	virtual unsigned long genrand(void);
+	// Whether the delta monitor records the numbers drawn. Fixed for the
+	// whole run, so it is checked once.
+	const bool record_numbers_;
 
-	//void seedrand(unsigned long seed);
+	// Kept between draws to save allocating it each time.
+	FilterRanges accepted_;
+
+	virtual unsigned long genrand(void);
 
 	//Don't implement them
 	DISALLOW_COPY_AND_ASSIGN(DefaultRndNumGenerator);
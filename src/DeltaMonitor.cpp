@@ -32,6 +32,7 @@
 
 #include "DeltaMonitor.h"
 #include <fstream>
+#include <sstream>
 #include <cassert>
 #include "SequenceFactory.h"
 #include "SimpleDeltaSequence.h"
@@ -41,19 +42,21 @@
 
 using namespace std;
 
-DELTA_TYPE DeltaMonitor::delta_type_ = MAX_DELTA_TYPE;
+thread_local DELTA_TYPE DeltaMonitor::delta_type_ = MAX_DELTA_TYPE;
 
 std::string DeltaMonitor::output_file_ = "";
 
 std::string DeltaMonitor::input_file_ = "";
 
-bool DeltaMonitor::is_running_ = false;
+thread_local bool DeltaMonitor::is_running_ = false;
 
-bool DeltaMonitor::is_delta_ = false;
+thread_local bool DeltaMonitor::is_delta_ = false;
 
-bool DeltaMonitor::no_delta_reduction_ = false;
+thread_local bool DeltaMonitor::no_delta_reduction_ = false;
 
-Sequence *DeltaMonitor::seq_ = NULL;
+thread_local Sequence *DeltaMonitor::seq_ = NULL;
+
+thread_local const DeltaMonitor::Choices *DeltaMonitor::replay_choices_ = NULL;
 
 DeltaMonitor::DeltaMonitor()
 {
@@ -91,7 +94,7 @@ DeltaMonitor::GetSepChar()
 void
 DeltaMonitor::CreateRndNumInstance(const unsigned long seed)
 {
-	assert(!DeltaMonitor::input_file_.empty());
+	assert(!DeltaMonitor::input_file_.empty() || DeltaMonitor::replay_choices_);
 	switch (DeltaMonitor::delta_type_) {
 	case dSimpleDelta:
 		RandomNumber::CreateInstance(rSimpleDeltaRndNumGenerator, seed);
@@ -204,3 +207,48 @@ DeltaMonitor::get_output()
 	return DeltaMonitor::output_file_;
 }
 
+void
+DeltaMonitor::record_on_thread()
+{
+	DeltaMonitor::delta_type_ = dSimpleDelta;
+	DeltaMonitor::is_running_ = true;
+	DeltaMonitor::is_delta_ = false;
+	DeltaMonitor::replay_choices_ = NULL;
+}
+
+void
+DeltaMonitor::replay_on_thread(const Choices *choices)
+{
+	assert(choices);
+	DeltaMonitor::delta_type_ = dSimpleDelta;
+	DeltaMonitor::is_running_ = true;
+	DeltaMonitor::is_delta_ = true;
+	// The choices are not reduced at a random point.
+	DeltaMonitor::no_delta_reduction_ = true;
+	DeltaMonitor::replay_choices_ = choices;
+}
+
+void
+DeltaMonitor::stop_on_thread()
+{
+	DeltaMonitor::delta_type_ = MAX_DELTA_TYPE;
+	DeltaMonitor::is_running_ = false;
+	DeltaMonitor::is_delta_ = false;
+	DeltaMonitor::no_delta_reduction_ = false;
+	DeltaMonitor::replay_choices_ = NULL;
+}
+
+void
+DeltaMonitor::get_choices(Choices &choices)
+{
+	assert(DeltaMonitor::is_running_);
+	std::string s;
+	get_sequence(s);
+
+	choices.clear();
+	std::istringstream in(s);
+	int value, bound;
+	char sep;
+	while (in >> value >> sep >> bound)
+		choices.push_back(std::make_pair(value, bound));
+}
@@ -32,6 +32,8 @@
 
 #include <string>
 #include <ostream>
+#include <utility>
+#include <vector>
 
 class SequenceFactory;
 class Sequence;
@@ -44,6 +46,9 @@ enum DELTA_TYPE {
 
 class DeltaMonitor {
 public:
+	// A sequence of random choices, as <value, bound> pairs.
+	typedef std::vector<std::pair<int, int> > Choices;
+
 	static Sequence *GetSequence();
 
 	static char GetSepChar();
@@ -69,6 +74,29 @@ public:
 
 	static const std::string &get_output();
 
+	// The monitor state is per thread, so that several programs can be
+	// generated at the same time, each recording or replaying its own
+	// choices.
+
+	// Records the random choices of the programs generated on this thread.
+	static void record_on_thread();
+
+	// Replays the given choices for the programs generated on this thread,
+	// instead of those of --delta-input. As they may have been edited, a
+	// value out of its bound is brought into it, one rejected by a filter is
+	// replaced by the next one that passes, and the choices made after they
+	// run out are random.
+	static void replay_on_thread(const Choices *choices);
+
+	// Stops recording or replaying choices on this thread.
+	static void stop_on_thread();
+
+	static const Choices *get_replay_choices() { return replay_choices_; }
+
+	// The choices recorded or replayed by the program being generated on
+	// this thread.
+	static void get_choices(Choices &choices);
+
 private:
 	DeltaMonitor();
 
@@ -76,19 +104,21 @@ private:
 
 	static void OutputStatistics(std::ostream &out);
 
-	static DELTA_TYPE delta_type_;
+	static thread_local DELTA_TYPE delta_type_;
 
 	static std::string output_file_;
 
 	static std::string input_file_;
 
-	static bool is_running_;
+	static thread_local bool is_running_;
+
+	static thread_local bool is_delta_;
 
-	static bool is_delta_;
+	static thread_local bool no_delta_reduction_;
 
-	static bool no_delta_reduction_;
+	static thread_local Sequence *seq_;
 
-	static Sequence *seq_;
+	static thread_local const Choices *replay_choices_;
 };
 
 #endif
@@ -63,10 +63,10 @@ namespace CLSmith {
 Expression *make_random(CGContext &cg_context, const Type *type, const CVQualifiers* qfer); // Hook
 }  // namespace CLSmith
 
-int eid = 0;
+thread_local int eid = 0;
 
-DistributionTable Expression::exprTable_;
-DistributionTable Expression::paramTable_;
+thread_local DistributionTable Expression::exprTable_;
+thread_local DistributionTable Expression::paramTable_;
 
 void
 Expression::InitExprProbabilityTable()
@@ -105,6 +105,14 @@ Expression::InitProbabilityTables()
 	Expression::InitParamProbabilityTable();
 }
 
+void
+Expression::doFinalization(void)
+{
+	exprTable_.clear();
+	paramTable_.clear();
+	eid = 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /*
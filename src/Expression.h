@@ -47,6 +47,7 @@
 #include "ProbabilityTable.h"
 #include <vector>
 #include <string>
+#include "Arena.h"
 using namespace std;
 
 class CGContext;
@@ -94,6 +95,8 @@ class ProbabilityTable;
 class Expression
 {
 public:
+	ARENA_ALLOCATED
+
 	// Factory method.
 	static Expression *make_random(CGContext &cg_context, const Type* type, const CVQualifiers* qfer=0, bool no_func = false, bool no_const = false, enum eTermType tt=MAX_TERM_TYPES);
 
@@ -101,6 +104,8 @@ public:
 
 	static void InitProbabilityTables();
 
+	static void doFinalization(void);
+
 	Expression(eTermType e);
 
 	Expression(const Expression &expr);
@@ -163,8 +168,8 @@ private:
 	static void InitExprProbabilityTable();
 	static void InitParamProbabilityTable();
 
-	static DistributionTable exprTable_;
-	static DistributionTable paramTable_;
+	static thread_local DistributionTable exprTable_;
+	static thread_local DistributionTable paramTable_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
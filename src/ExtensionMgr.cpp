@@ -42,7 +42,7 @@
 
 using namespace std;
 
-AbsExtension *ExtensionMgr::extension_ = NULL;
+thread_local AbsExtension *ExtensionMgr::extension_ = NULL;
 
 void
 ExtensionMgr::CreateExtension()
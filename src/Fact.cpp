@@ -28,6 +28,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
  
 #include <assert.h>
+#include <unordered_map>
 #include "Fact.h"
 #include "Variable.h"
 #include "Lhs.h"
@@ -37,7 +38,67 @@
 #include "StatementReturn.h"
 
 using namespace std; 
-std::vector<Fact*> Fact::facts_;
+thread_local std::vector<Fact*> Fact::facts_;
+
+struct FactKeyHash
+{
+	size_t operator()(const pair<int, const Variable*>& k) const {
+		return hash<const Variable*>()(k.second) * 31 + k.first;
+	}
+};
+
+// the keys given to (category, variable) pairs so far
+static thread_local unordered_map<pair<int, const Variable*>, int, FactKeyHash> fact_keys;
+
+/*
+ * The positions of the facts of an env, by fact key. Used to find the
+ * related facts of another env without comparing all pairs of facts.
+ */
+class FactPositions
+{
+public:
+	FactPositions(void) : stamp_(0) {}
+
+	// forget the positions of the previous env
+	void reset(void) {
+		if (++stamp_ == 0) {
+			stamps_.assign(stamps_.size(), 0);
+			stamp_ = 1;
+		}
+	}
+
+	// the position of the first fact with the key, -1 if there is none
+	int find(int key) const {
+		return ((size_t)key < stamps_.size() && stamps_[key] == stamp_) ? pos_[key] : -1;
+	}
+
+	// returns false if there is already a fact with the key
+	bool add(int key, int pos) {
+		if ((size_t)key >= stamps_.size()) {
+			stamps_.resize(key + 1, 0);
+			pos_.resize(key + 1, -1);
+		}
+		if (stamps_[key] == stamp_) {
+			return false;
+		}
+		stamps_[key] = stamp_;
+		pos_[key] = pos;
+		return true;
+	}
+
+	void add_facts(const FactVec& facts) {
+		for (size_t i=0; i<facts.size(); i++) {
+			add(facts[i]->get_key(), i);
+		}
+	}
+
+private:
+	vector<int> pos_;
+	vector<unsigned int> stamps_;
+	unsigned int stamp_;
+};
+
+static thread_local FactPositions fact_positions;
  
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -45,10 +106,23 @@ std::vector<Fact*> Fact::facts_;
  * 
  */
 Fact::Fact(eFactCategory e) :
-    eCat(e)
+    eCat(e),
+    key_(-1)
 {
 	// Nothing else to do.
 }
+
+int
+Fact::make_key(void) const
+{
+	pair<int, const Variable*> k(eCat, get_var());
+	unordered_map<pair<int, const Variable*>, int, FactKeyHash>::const_iterator iter = fact_keys.find(k);
+	if (iter == fact_keys.end()) {
+		iter = fact_keys.insert(make_pair(k, (int)fact_keys.size())).first;
+	}
+	key_ = iter->second;
+	return key_;
+}
  
 /*
  * 
@@ -111,6 +185,7 @@ Fact::doFinalization()
 		delete (*i);
 	}
 	facts_.clear();
+	fact_keys.clear();
 }
 
 // fact manipulating functions
@@ -130,8 +205,9 @@ const Fact*
 find_related_fact(const FactVec& facts, const Fact* new_fact)
 {
     size_t i; 
+    int key = new_fact->get_key();
     for (i=0; i<facts.size(); i++) {
-        if (new_fact->is_related(*facts[i])) {
+        if (facts[i]->get_key() == key) {
             return facts[i];
         }
     }
@@ -142,8 +218,9 @@ const Fact*
 find_related_fact(const vector<Fact*>& facts, const Fact* new_fact)
 {
     size_t i; 
+    int key = new_fact->get_key();
     for (i=0; i<facts.size(); i++) {
-        if (new_fact->is_related(*facts[i])) {
+        if (facts[i]->get_key() == key) {
             return facts[i];
         }
     }
@@ -157,9 +234,10 @@ merge_fact(FactVec& facts, const Fact* new_fact)
 { 
     bool changed = false; 
     size_t i; 
+    int key = new_fact->get_key();
     for (i=0; i<facts.size(); i++) {
         const Fact* f = facts[i]; 
-        if (f->is_related(*new_fact)) {
+        if (f->get_key() == key) {
             if (!f->imply(*new_fact)) {
 				Fact* copy_fact = new_fact->clone();
                 copy_fact->join(*f);    
@@ -184,8 +262,9 @@ bool
 renew_fact(FactVec& facts, const Fact* new_fact)
 { 
     size_t i; 
+    int key = new_fact->get_key();
     for (i=0; i<facts.size(); i++) {
-        if (new_fact->is_related(*facts[i])) { 
+        if (facts[i]->get_key() == key) { 
             if (new_fact->equal(*facts[i])) {
                 return false;
             }
@@ -200,27 +279,58 @@ renew_fact(FactVec& facts, const Fact* new_fact)
     return true;
 }
    
+/*
+ * same as calling merge_fact for each new fact, with the related facts
+ * looked up by key
+ */
 bool
 merge_facts(FactVec& facts, const FactVec& new_facts)
 { 
     size_t i;
     bool changed = false;
+    fact_positions.reset();
+    fact_positions.add_facts(facts);
     for (i=0; i<new_facts.size(); i++) {
-		//new_facts[i]->Output(cout);
-        if (merge_fact(facts, new_facts[i])) {
+        const Fact* new_fact = new_facts[i];
+        int key = new_fact->get_key();
+        int pos = fact_positions.find(key);
+        if (pos == -1) {
+            fact_positions.add(key, facts.size());
+            facts.push_back(new_fact);
+            changed = true;
+        }
+        else if (!facts[pos]->imply(*new_fact)) {
+            Fact* copy_fact = new_fact->clone();
+            copy_fact->join(*facts[pos]);
+            facts[pos] = copy_fact;
             changed = true;
         }
     } 
     return changed;
 }
 
+/*
+ * same as calling renew_fact for each new fact, with the related facts
+ * looked up by key
+ */
 bool
 renew_facts(FactVec& facts, const FactVec& new_facts)
 { 
     size_t i;
     bool changed = false;
+    fact_positions.reset();
+    fact_positions.add_facts(facts);
     for (i=0; i<new_facts.size(); i++) {
-        if (renew_fact(facts, new_facts[i])) {
+        const Fact* new_fact = new_facts[i];
+        int key = new_fact->get_key();
+        int pos = fact_positions.find(key);
+        if (pos == -1) {
+            fact_positions.add(key, facts.size());
+            facts.push_back(new_fact);
+            changed = true;
+        }
+        else if (!new_fact->equal(*facts[pos])) {
+            facts[pos] = new_fact;
             changed = true;
         }
     } 
@@ -245,26 +355,46 @@ copy_facts(const FactVec& facts_in)
 void 
 combine_facts(vector<Fact*>& facts1, const FactVec& facts2)
 {
-    size_t i, j;  
+    size_t i;  
+    fact_positions.reset();
+    for (i=0; i<facts1.size(); i++) {
+		fact_positions.add(facts1[i]->get_key(), i);
+    }
     for (i=0; i<facts2.size(); i++) {
 		const Fact* new_fact = facts2[i];
-		for (j=0; j<facts1.size(); j++) {
-			Fact* old_fact = facts1[j];
-			if (old_fact->is_related(*new_fact)) {
-				old_fact->join_visits(*new_fact);
-				break;
-			}
+		int pos = fact_positions.find(new_fact->get_key());
+		if (pos != -1) {
+			facts1[pos]->join_visits(*new_fact);
 		}
 	}
 }
 
+/*
+ * equal facts are related, so each fact only needs to be compared with the
+ * facts of the other env that have the same key
+ */
 bool 
 same_facts(const FactVec& facts1, const FactVec& facts2)
 {
 	if (facts1.size() == facts2.size()) {
 		size_t i;
+		bool unique = true;
+		fact_positions.reset();
+		for (i=0; i<facts2.size(); i++) {
+			if (!fact_positions.add(facts2[i]->get_key(), i)) {
+				unique = false;
+			}
+		}
 		for (i=0; i<facts1.size(); i++) {
-			if (find_fact(facts2, facts1[i]) == -1) {
+			const Fact* f = facts1[i];
+			int pos = fact_positions.find(f->get_key());
+			if (pos == -1) {
+				return false;
+			}
+			if (f->equal(*facts2[pos])) {
+				continue;
+			}
+			if (unique || find_fact(facts2, f) == -1) {
 				return false;
 			}
 		}
@@ -34,6 +34,7 @@
 
 #include <ostream>
 #include <vector>
+#include "Arena.h"
 using namespace std;
 
 enum eFactCategory { 
@@ -60,6 +61,8 @@ class ExpressionVariable;
 class Fact
 {
 public:
+	ARENA_ALLOCATED
+
 	Fact(eFactCategory e); 
 
 	virtual ~Fact(void); 
@@ -82,6 +85,10 @@ public:
 
 	virtual bool is_related(const Fact& fact) const { return eCat == fact.eCat && get_var() == fact.get_var();}
 
+	// a small number for the category and variable of the fact. facts
+	// are related if and only if they have the same key
+	int get_key(void) const { return (key_ >= 0) ? key_ : make_key(); }
+
 	virtual bool equal(const Fact& fact) const { return this == &fact; };
 
 	virtual void Output(std::ostream &out) const = 0;
@@ -101,8 +108,16 @@ public:
 	enum eFactCategory eCat;
 
 protected: 
+	// to be called when the variable of the fact is changed
+	void reset_key(void) { key_ = -1; }
+
 	// keep track all created facts. used for releasing memory in doFinalization
-	static std::vector<Fact*> facts_;
+	static thread_local std::vector<Fact*> facts_;
+
+private:
+	int make_key(void) const;
+
+	mutable int key_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -58,10 +58,11 @@
 #include "ExpressionVariable.h"
 #include "Lhs.h"
 #include "CFGEdge.h"
+#include "Bookkeeper.h"
 
 using namespace std; 
  
-std::vector<Fact*> FactMgr::meta_facts;
+thread_local std::vector<Fact*> FactMgr::meta_facts;
 
 void
 FactMgr::add_new_var_fact_and_update_inout_maps(const Block* blk, const Variable* var)
@@ -81,11 +82,11 @@ FactMgr::add_new_var_fact_and_update_inout_maps(const Block* blk, const Variable
 				global_facts.push_back(f);
 			} 
 
-			map<const Statement*, FactVec>::iterator iter;
+			StmFactMap::const_iterator iter;
 			for(iter = map_facts_in.begin(); iter != map_facts_in.end(); ++iter) {  
 				const Statement* stm = iter->first;
 				if (stm && (stm->in_block(blk) || blk == NULL)) {
-					iter->second.push_back(f);
+					map_facts_in[stm].push_back(f);
 				}
 			}
 			for(iter = map_facts_out.begin(); iter != map_facts_out.end(); ++iter) {  
@@ -94,7 +95,7 @@ FactMgr::add_new_var_fact_and_update_inout_maps(const Block* blk, const Variable
 				if (blk) {
 					add_fact_out(stm, f);
 				} else {
-					iter->second.push_back(f);
+					map_facts_out[stm].push_back(f);
 				}
 			} 
 		}
@@ -213,7 +214,7 @@ FactMgr::setup_in_out_maps(bool first_time)
 {
 	if (first_time) {
 		// first time revisit, create map_facts_in_final and map_facts_out_final with cloned facts 
-		map<const Statement*, vector<const Fact*> >::const_iterator iter;
+		StmFactMap::const_iterator iter;
 		for(iter = map_facts_in.begin(); iter != map_facts_in.end(); ++iter) {
 			const Statement* stm = iter->first;
 			const vector<const Fact*>& facts1 = iter->second;
@@ -530,14 +531,14 @@ FactMgr::makeup_new_var_facts(vector<const Fact*>& old_facts, const vector<const
 void 
 FactMgr::clear_map_visited(void)
 {
-	map<const Statement*, bool>::iterator iter;
+	unordered_map<const Statement*, bool>::iterator iter;
 	for(iter = map_visited.begin(); iter != map_visited.end(); ++iter) {  
 		iter->second = false;
 	}
 }
 
 void
-FactMgr::backup_stm_fact_maps(const Statement* stm, map<const Statement*, FactVec>& facts_in, map<const Statement*, FactVec>& facts_out)
+FactMgr::backup_stm_fact_maps(const Statement* stm, StmFactMap& facts_in, StmFactMap& facts_out)
 {
 	vector<const Block*> blks;
 	stm->get_blocks(blks);
@@ -554,7 +555,7 @@ FactMgr::backup_stm_fact_maps(const Statement* stm, map<const Statement*, FactVe
 }
 
 void
-FactMgr::restore_stm_fact_maps(const Statement* stm, map<const Statement*, FactVec>& facts_in, map<const Statement*, FactVec>& facts_out)
+FactMgr::restore_stm_fact_maps(const Statement* stm, StmFactMap& facts_in, StmFactMap& facts_out)
 {
 	vector<const Block*> blks;
 	stm->get_blocks(blks);
@@ -732,10 +733,38 @@ FactMgr::find_dangling_global_ptrs(Function* f)
 	}
 }
 
+void
+FactMgr::checkpoint_stm_maps(void)
+{
+	map_facts_in.checkpoint();
+	map_facts_out.checkpoint();
+	map_stm_effect.checkpoint();
+	map_accum_effect.checkpoint();
+}
+
+void
+FactMgr::rollback_stm_maps(void)
+{
+	map_facts_in.rollback();
+	map_facts_out.rollback();
+	map_stm_effect.rollback();
+	map_accum_effect.rollback();
+	Bookkeeper::fact_rollback_cnt++;
+}
+
+void
+FactMgr::release_stm_maps(void)
+{
+	map_facts_in.release();
+	map_facts_out.release();
+	map_stm_effect.release();
+	map_accum_effect.release();
+}
+
 void
 FactMgr::sanity_check_map() const
 {
-	map<const Statement*, vector<const Fact*> >::const_iterator iter; 
+	StmFactMap::const_iterator iter; 
 	for(iter = map_facts_in.begin(); iter != map_facts_in.end(); ++iter) {
 		const Statement* stm = iter->first;
 		const vector<const Fact*>& facts = iter->second;
@@ -775,6 +804,8 @@ FactMgr::doFinalization()
 {
 	Fact::doFinalization();
 	meta_facts.clear();
+	FactPointTo::all_ptrs.clear();
+	FactPointTo::all_aliases.clear();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
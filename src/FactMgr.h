@@ -53,13 +53,109 @@ class CFGEdge;
 
 ///////////////////////////////////////////////////////////////////////////////
 
+#include <cassert>
 #include <ostream>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include "Effect.h"
 #include "Fact.h"
 using namespace std; 
 
+/*
+ * Facts or effects of statements. These are looked up much more often than
+ * they are iterated, and nothing depends on the order of iteration.
+ *
+ * The map can be rolled back to a checkpoint. Only the entries looked up
+ * after the checkpoint are saved, instead of copying the whole map.
+ */
+template <class T>
+class StmMap
+{
+public:
+	typedef typename std::unordered_map<const Statement*, T>::const_iterator const_iterator;
+
+	T& operator[](const Statement* s) {
+		if (!logs_.empty()) {
+			save(s);
+		}
+		return map_[s];
+	}
+
+	const_iterator begin(void) const { return map_.begin(); }
+	const_iterator end(void) const { return map_.end(); }
+
+	// checkpoints can be nested, each one ends with a rollback or a release
+	void checkpoint(void) { logs_.push_back(Log()); }
+	void rollback(void);
+	void release(void);
+
+private:
+	struct Entry {
+		bool existed;
+		T value;
+	};
+	typedef std::unordered_map<const Statement*, Entry> Log;
+
+	void save(const Statement* s);
+
+	std::unordered_map<const Statement*, T> map_;
+	std::vector<Log> logs_;
+};
+
+template <class T>
+void
+StmMap<T>::save(const Statement* s)
+{
+	Log& log = logs_.back();
+	if (log.find(s) != log.end()) {
+		return;
+	}
+	typename std::unordered_map<const Statement*, T>::const_iterator iter = map_.find(s);
+	Entry& e = log[s];
+	e.existed = (iter != map_.end());
+	if (e.existed) {
+		e.value = iter->second;
+	}
+}
+
+template <class T>
+void
+StmMap<T>::rollback(void)
+{
+	assert(!logs_.empty());
+	typename Log::iterator iter;
+	for (iter = logs_.back().begin(); iter != logs_.back().end(); ++iter) {
+		if (iter->second.existed) {
+			map_[iter->first] = iter->second.value;
+		} else {
+			map_.erase(iter->first);
+		}
+	}
+	logs_.pop_back();
+}
+
+template <class T>
+void
+StmMap<T>::release(void)
+{
+	assert(!logs_.empty());
+	if (logs_.size() > 1) {
+		// the outer checkpoint needs the entries saved before it was taken
+		Log& outer = logs_[logs_.size() - 2];
+		typename Log::iterator iter;
+		for (iter = logs_.back().begin(); iter != logs_.back().end(); ++iter) {
+			if (outer.find(iter->first) == outer.end()) {
+				outer[iter->first] = iter->second;
+			}
+		}
+	}
+	logs_.pop_back();
+}
+
+typedef StmMap<FactVec> StmFactMap;
+typedef StmMap<Effect> StmEffectMap;
+
 ///////////////////////////////////////////////////////////////////////////////
 
 class FactMgr
@@ -96,8 +192,8 @@ public:
 	void create_cfg_edge(const Statement* src, const Statement* dest, bool post_stm_edge, bool back_link);
 
 	void clear_map_visited(void);
-	void backup_stm_fact_maps(const Statement* stm, map<const Statement*, FactVec>& facts_in, map<const Statement*, FactVec>& facts_out);
-	void restore_stm_fact_maps(const Statement* stm, map<const Statement*, FactVec>& facts_in, map<const Statement*, FactVec>& facts_out);
+	void backup_stm_fact_maps(const Statement* stm, StmFactMap& facts_in, StmFactMap& facts_out);
+	void restore_stm_fact_maps(const Statement* stm, StmFactMap& facts_in, StmFactMap& facts_out);
 	void reset_stm_fact_maps(const Statement* stm);
 
 	void output_assertions(std::ostream &out, const Statement* stm, int indent, bool post_condition);
@@ -137,17 +233,22 @@ public:
 	
 	void sanity_check_map() const;
 
-	static std::vector<Fact*> meta_facts; 
+	/* checkpoints of the facts and effects of statements */
+	void checkpoint_stm_maps(void);
+	void rollback_stm_maps(void);
+	void release_stm_maps(void);
+
+	static thread_local std::vector<Fact*> meta_facts; 
 
 	// maps to track facts and effects at historical generation points.
 	// they are used for bypassing analyzing statements if possible 
-	std::map<const Statement*, FactVec> map_facts_in;
-	std::map<const Statement*, FactVec> map_facts_out;
+	StmFactMap map_facts_in;
+	StmFactMap map_facts_out;
 	std::map<const Statement*, std::vector<Fact*> > map_facts_in_final;
 	std::map<const Statement*, std::vector<Fact*> > map_facts_out_final;
-	std::map<const Statement*, Effect> map_stm_effect;
-	std::map<const Statement*, Effect> map_accum_effect;
-	std::map<const Statement*, bool> map_visited;
+	StmEffectMap map_stm_effect;
+	StmEffectMap map_accum_effect;
+	std::unordered_map<const Statement*, bool> map_visited;
 
 	std::vector<const CFGEdge*> cfg_edges;
 	FactVec global_facts; 
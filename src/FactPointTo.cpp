@@ -59,8 +59,8 @@ using namespace std;
 const Variable* FactPointTo::null_ptr = VariableSelector::make_dummy_static_variable("null");
 const Variable* FactPointTo::garbage_ptr = VariableSelector::make_dummy_static_variable("garbage");
 const Variable* FactPointTo::tbd_ptr = VariableSelector::make_dummy_static_variable("tbd");
-vector<const Variable*> FactPointTo::all_ptrs;
-vector<vector<const Variable*> > FactPointTo::all_aliases;
+thread_local vector<const Variable*> FactPointTo::all_ptrs;
+thread_local vector<vector<const Variable*> > FactPointTo::all_aliases;
 
 bool
 FactPointTo::is_null() const 
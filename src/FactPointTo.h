@@ -110,8 +110,8 @@ public:
 	static const Variable* garbage_ptr;
 	static const Variable* tbd_ptr;
 	
-	static vector<const Variable*> all_ptrs;
-	static vector<vector<const Variable*> > all_aliases;
+	static thread_local vector<const Variable*> all_ptrs;
+	static thread_local vector<vector<const Variable*> > all_aliases;
 private:  
 	FactPointTo(const Variable* v, const vector<const Variable*>& set);
 	FactPointTo(const Variable* v, const Variable* point_to);
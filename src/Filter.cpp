@@ -63,6 +63,23 @@ void Filter::disable(FilterKind kind)
 	kinds_[kind] = false;
 }
 
+bool
+Filter::accepted_ranges(unsigned int, FilterRanges &) const
+{
+	return false;
+}
+
+void
+Filter::add_range(FilterRanges &ranges, unsigned int first, unsigned int last)
+{
+	if (first >= last)
+		return;
+	if (!ranges.empty() && ranges.back().second == first)
+		ranges.back().second = last;
+	else
+		ranges.push_back(make_pair(first, last));
+}
+
 /*
  *
  */
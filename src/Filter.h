@@ -31,6 +31,8 @@
 #define FILTER_H
 
 #include <bitset>
+#include <utility>
+#include <vector>
 
 enum FilterKind {
 	fDefault,
@@ -38,6 +40,9 @@ enum FilterKind {
 	MAX_FILTER_KIND_SIZE,
 };
 
+// Half-open ranges [first, second) of values that pass a filter.
+typedef std::vector<std::pair<unsigned int, unsigned int> > FilterRanges;
+
 // Filter base class
 class Filter
 {
@@ -47,6 +52,12 @@ public:
 
 	virtual bool filter(int v) const = 0;
 
+	// Appends the values in [0, n) that are not filtered out to `ranges',
+	// in increasing order, so that a value can be drawn from them directly.
+	// Returns false if the filter can't list them, and the value must be
+	// drawn and tested instead.
+	virtual bool accepted_ranges(unsigned int n, FilterRanges &ranges) const;
+
 	void enable(FilterKind kind);
 
 	void disable(FilterKind kind);
@@ -54,6 +65,9 @@ public:
 protected:
 	bool valid_filter() const;
 
+	// Appends [first, last) to `ranges', merging it with the last range.
+	static void add_range(FilterRanges &ranges, unsigned int first, unsigned int last);
+
 	// What kind of mode this filter can apply to
 	// By default, it can work for all modes. 
 	std::bitset<MAX_FILTER_KIND_SIZE> kinds_;
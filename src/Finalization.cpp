@@ -38,6 +38,12 @@
 #include "Probabilities.h"
 #include "StatementGoto.h"
 #include "ExtensionMgr.h"
+#include "Statement.h"
+#include "StatementAssign.h"
+#include "Expression.h"
+#include "SafeOpFlags.h"
+#include "Error.h"
+#include "util.h"
 
 void
 Finalization::doFinalization()
@@ -51,5 +57,12 @@ Finalization::doFinalization()
 	Probabilities::DestroyInstance();
 	StatementGoto::doFinalization();
 	ExtensionMgr::DestroyExtension();
+	Statement::doFinalization();
+	StatementAssign::doFinalization();
+	Expression::doFinalization();
+	SafeOpFlags::doFinalization();
+	Bookkeeper::doFinalization();
+	Error::set_error(SUCCESS);
+	reset_gensym();
 }
 
@@ -67,11 +67,11 @@ using namespace std;
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static vector<Function*> FuncList;		// List of all functions in the program
-static vector<FactMgr*>  FMList;        // list of fact managers for each function
-static long cur_func_idx;				// Index into FuncList that we are currently working on
-static bool param_first=true;			// Flag to track output of commas 
-static int builtin_functions_cnt;
+static thread_local vector<Function*> FuncList;		// List of all functions in the program
+static thread_local vector<FactMgr*>  FMList;        // list of fact managers for each function
+static thread_local long cur_func_idx;				// Index into FuncList that we are currently working on
+static thread_local bool param_first=true;			// Flag to track output of commas 
+static thread_local int builtin_functions_cnt;
 
 /*
  * find FactMgr for a function
@@ -889,6 +889,9 @@ Function::doFinalization(void)
 	}
 	FMList.clear();
 	FactMgr::doFinalization();
+	cur_func_idx = 0;
+	param_first = true;
+	builtin_functions_cnt = 0;
 }
 
 Function::~Function()
@@ -47,6 +47,7 @@ using namespace std;
 
 #include "Effect.h"
 #include "Type.h"
+#include "VariableIndex.h"
 
 class Block;
 class Variable;
@@ -101,7 +102,9 @@ public:
 	bool is_pointer_referenced(void) { return !referenced_ptrs.empty();} const
 
 	std::string name;
-	std::vector<Variable*> param;
+	VariableList param;
+	// param as seen by VariableSelector
+	mutable VariableIndex param_index;
 //	vector<Expression*> param_value;
 	const Type* return_type;
 //	bool isBackLink;
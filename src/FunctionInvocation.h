@@ -45,6 +45,7 @@
 #include <vector>
 #include "util.h"
 #include "CVQualifiers.h"
+#include "Arena.h"
 using namespace std;
 
 class CGContext;
@@ -109,6 +110,8 @@ enum eInvocationType
 class FunctionInvocation
 {
 public:
+	ARENA_ALLOCATED
+
 	FunctionInvocation(eInvocationType e, const SafeOpFlags *flags);
 
 	virtual ~FunctionInvocation(void);
@@ -64,11 +64,11 @@
 
 using namespace std;
 
-static vector<bool> needcomma;  // Flag to track output of commas
+static thread_local vector<bool> needcomma;  // Flag to track output of commas
 
-static vector<const FunctionInvocationUser*> invocations;   // list of function calls
-static vector<const Fact*> return_facts;              // list of return facts
-vector<FunctionInvocationUser*> FunctionInvocationUser::AllFunctionInvocations;    // All function invocations
+static thread_local vector<const FunctionInvocationUser*> invocations;   // list of function calls
+static thread_local vector<const Fact*> return_facts;              // list of return facts
+thread_local vector<FunctionInvocationUser*> FunctionInvocationUser::AllFunctionInvocations;    // All function invocations
 
 const Fact*
 get_return_fact_for_invocation(const FunctionInvocationUser* fiu, const Variable* var, enum eFactCategory cat) 
@@ -340,20 +340,15 @@ FunctionInvocationUser::revisit(std::vector<const Fact*>& inputs, CGContext& cg_
 	// add facts related to pass parameters
 	fm->caller_to_callee_handover(this, inputs);  
 
-	map<const Statement*, FactVec> facts_in_copy = fm->map_facts_in;
-	map<const Statement*, FactVec> facts_out_copy = fm->map_facts_out;
-	map<const Statement*, Effect>  stm_effect_copy = fm->map_stm_effect;
-	map<const Statement*, Effect>  accum_effect_copy = fm->map_accum_effect;
+	fm->checkpoint_stm_maps();
 	// TODO: revisit only if "contingent variable" has been changed? 
 	if (!func->body->visit_facts(inputs, cg_context)) {
 		// restore facts and effect 
-		fm->map_facts_in = facts_in_copy;
-		fm->map_facts_out = facts_out_copy;
-		fm->map_stm_effect = stm_effect_copy;
-		fm->map_accum_effect = accum_effect_copy;
+		fm->rollback_stm_maps();
 		inputs = inputs_copy; 
 		return false;
 	}  
+	fm->release_stm_maps();
 	cg_context.add_effect(fm->map_stm_effect[func->body]);
 	FactVec ret_facts;
 	func->body->add_back_return_facts(fm, ret_facts);
@@ -395,6 +390,8 @@ FunctionInvocationUser::doFinalization(void)
 {
 	invocations.clear();
 	return_facts.clear();
+	needcomma.clear();
+	AllFunctionInvocations.clear();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
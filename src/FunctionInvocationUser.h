@@ -101,7 +101,7 @@ private:
 	bool build_invocation(Function *target, CGContext &cg_context);
 
 	// All function calls
-	static vector<FunctionInvocationUser*> AllFunctionInvocations;
+	static thread_local vector<FunctionInvocationUser*> AllFunctionInvocations;
 };
 
 const Fact* get_return_fact_for_invocation(const FunctionInvocationUser* fiu, const Variable* var, enum eFactCategory cat);
@@ -68,7 +68,7 @@ using namespace std;
 
 vector<string> OutputMgr::monitored_funcs_;
 
-std::string OutputMgr::curr_func_ = "";
+thread_local std::string OutputMgr::curr_func_ = "";
 
 void
 OutputMgr::set_curr_func(const std::string &fname)
@@ -115,7 +115,7 @@ OutputMgr::OutputMain(std::ostream &out)
 
 	if (CGOptions::blind_check_global()) {
 		ExtensionMgr::OutputFirstFunInvocation(out, invoke);
-		std::vector<Variable *>& vars = *VariableSelector::GetGlobalVariables();
+		const VariableList& vars = *VariableSelector::GetGlobalVariables();
 		for (size_t i=0; i<vars.size(); i++) {
 			vars[i]->output_value_dump(out, "checksum ", 1);
 		}
@@ -94,7 +94,7 @@ private:
 
 	static bool is_monitored_func(void);
 
-	static std::string curr_func_;
+	static thread_local std::string curr_func_;
 
 };
 
@@ -89,6 +89,31 @@ ProbabilityFilter::filter(int v) const
 	return rv;
 }
 
+bool
+ProbabilityFilter::accepted_ranges(unsigned int n, FilterRanges &ranges) const
+{
+	Probabilities *prob = Probabilities::GetInstance();
+	assert(prob);
+	GroupProbElem *elem = dynamic_cast<GroupProbElem*>(prob->probabilities_[pname_]);
+	assert(elem);
+	assert(elem->is_equal());
+
+	// Look the group up once, rather than once for each value. As in
+	// filter(), the first element of a value decides.
+	vector<int> value_prob(n, -1);
+	map<ProbName, SingleProbElem *>::iterator i;
+	for (i = elem->probs_.begin(); i != elem->probs_.end(); ++i) {
+		unsigned val = Probabilities::pname_to_type((*i).first);
+		if (val < n && value_prob[val] == -1)
+			value_prob[val] = (*i).second->get_prob_direct();
+	}
+	for (unsigned int v = 0; v < n; ++v) {
+		if (value_prob[v] != 0 && !prob->check_extra_filter(pname_, v))
+			add_range(ranges, v, v + 1);
+	}
+	return true;
+}
+
 /////////////////////////////////////////////////////////////////
 ProbElem::~ProbElem()
 {
@@ -360,7 +385,7 @@ GroupProbElem::dump_val(std::ostream &out)
 
 /////////////////////////////////////////////////////////////////
 
-Probabilities* Probabilities::instance_ = NULL;
+thread_local Probabilities* Probabilities::instance_ = NULL;
 
 Probabilities *
 Probabilities::GetInstance()
@@ -1116,6 +1141,15 @@ void DistributionTable::add_entry(int key, int prob)
 	keys_.push_back(key); 
 	probs_.push_back(prob);  
 	max_prob_ += prob; 
+	ends_.push_back(max_prob_);
+}
+
+void DistributionTable::clear(void)
+{
+	keys_.clear();
+	probs_.clear();
+	ends_.clear();
+	max_prob_ = 0;
 }
 
 int DistributionTable::key_to_prob(int key) const 
@@ -1130,16 +1164,17 @@ int DistributionTable::key_to_prob(int key) const
 }
 
 int DistributionTable::rnd_num_to_key(int rnd) const
+{
+	return keys_[rnd_num_to_index(rnd)];
+}
+
+size_t DistributionTable::rnd_num_to_index(int rnd) const
 {
 	assert(rnd < max_prob_ && rnd >= 0);
-	assert(keys_.size() == probs_.size());
-	for (size_t i=0; i<probs_.size(); i++) {
-		if (rnd < probs_[i]) {
-			return keys_[i];
-		}
-		rnd -= probs_[i];
-	}
-	assert(0);
-	return -1;
+	assert(keys_.size() == ends_.size());
+	// The first entry ending after rnd, which skips those with no numbers.
+	vector<int>::const_iterator i = upper_bound(ends_.begin(), ends_.end(), rnd);
+	assert(i != ends_.end());
+	return i - ends_.begin();
 }
 
@@ -46,15 +46,18 @@ class TableEntry {
 public:
 	TableEntry(Key k, Value v);
 
-	Key get_key() { return key_; }
+	Key get_key() const { return key_; }
 
-	Value get_value() { return value_; }
+	Value get_value() const { return value_; }
 
 private:
 	Key key_;
 	Value value_;
 };
 
+// Maps the numbers below the largest key to values. The keys are numbers
+// drawn by rnd_upto, so the values of all the numbers fit in an array, which
+// get_value indexes directly.
 template <class Key, class Value>
 class ProbabilityTable {
 	typedef TableEntry<Key, Value> Entry;
@@ -68,13 +71,27 @@ public:
 
 	void add_elem(Key k, Value v);
 
-	void sorted_insert(Entry *t);
+	void sorted_insert(const Entry &t);
 
-	Value get_value(Key k);
+	Value get_value(Key k) const;
+
+	// The entries are sorted by key, and entry i covers the keys from
+	// key_at(i-1) (or 0) up to, but not including, key_at(i).
+	size_t size(void) const { return table_.size(); }
+
+	Key key_at(size_t i) const { return table_[i].get_key(); }
+
+	Value value_at(size_t i) const { return table_[i].get_value(); }
 
 private:
+	void build_values(void) const;
+
 	Key curr_max_key_;
-	std::vector<Entry *> table_; 
+	std::vector<Entry> table_; 
+
+	// The value of each number below curr_max_key_, built on the first lookup
+	// after an entry is added.
+	mutable std::vector<Value> values_;
 };
 
 template <class Key, class Value>
@@ -94,9 +111,6 @@ ProbabilityTable<Key, Value>::ProbabilityTable()
 template <class Key, class Value>
 ProbabilityTable<Key, Value>::~ProbabilityTable()
 {
-	typename vector<Entry *>::iterator i;
-	for (i = table_.begin(); i != table_.end(); ++i) 
-		delete (*i);
 	table_.clear();
 }
 
@@ -108,69 +122,56 @@ void ProbabilityTable<Key, Value>::initialize(ProbName pname)
 }
 
 template <class Key, class Value>
-bool my_less(TableEntry<Key, Value> *t, Key k2)
+bool key_below(Key k1, const TableEntry<Key, Value> &t)
 {
-	Key k1 = t->get_key();
-	return (k1 < k2);
+	return (k1 < t.get_key());
 }
 
 template <class Key, class Value>
-bool my_greater(TableEntry<Key, Value> *t, Key k2)
+void
+ProbabilityTable<Key, Value>::sorted_insert(const Entry &t)
 {
-	Key k1 = t->get_key();
-	return (k1 > k2);
+	Key k = t.get_key();
+	values_.clear();
+
+	// Entries with the same key keep the order they were added in.
+	typename vector<Entry>::iterator i =
+		upper_bound(table_.begin(), table_.end(), k, key_below<Key, Value>);
+	if (i == table_.end())
+		curr_max_key_ = k;
+	table_.insert(i, t);
 }
 
 template <class Key, class Value>
 void
-ProbabilityTable<Key, Value>::sorted_insert(Entry *t)
+ProbabilityTable<Key, Value>::add_elem(Key k, Value v)
 {
-	assert(t);
-	
-	Key k = t->get_key();
-
-	if (table_.empty()) {
-		table_.push_back(t);
-		curr_max_key_ = k;
-		return;
-	}
-	
-	typename vector<Entry *>::iterator i;
-	for (i=table_.begin(); i!=table_.end(); i++) {
-		if (my_greater<Key, Value>(*i, k)) {
-			break;
-		}
-	}
-	//i = find_if(table_.begin(), table_.end(), std::bind2nd(std::ptr_fun(my_greater<Key, Value>), k));
-
-	if (i != table_.end()) {
-		table_.insert(i, t);	
-	}
-	else {
-		table_.push_back(t);
-		curr_max_key_ = k;
-	}
+	sorted_insert(Entry(k, v));
 }
 
 template <class Key, class Value>
 void
-ProbabilityTable<Key, Value>::add_elem(Key k, Value v)
+ProbabilityTable<Key, Value>::build_values(void) const
 {
-	Entry *t = new Entry(k, v);
-	sorted_insert(t);
+	values_.clear();
+	values_.reserve(curr_max_key_);
+	Key k = 0;
+	typename vector<Entry>::const_iterator i;
+	for (i = table_.begin(); i != table_.end(); ++i) {
+		for (; k < i->get_key(); ++k)
+			values_.push_back(i->get_value());
+	}
 }
 
 template <class Key, class Value>
 Value
-ProbabilityTable<Key, Value>::get_value(Key k)
+ProbabilityTable<Key, Value>::get_value(Key k) const
 {
 	assert(k < curr_max_key_);
 
-	typename vector<Entry *>::iterator i;
-	i = find_if(table_.begin(), table_.end(), std::bind2nd(std::ptr_fun(my_greater<Key, Value>), k));
-
-	assert(i != table_.end());
-	return (*i)->get_value();
+	if (values_.empty())
+		build_values();
+	return values_[k];
 }
 
 class DistributionTable {  
@@ -179,13 +180,24 @@ public:
 	~DistributionTable() {}; 
 
 	void add_entry(int key, int prob); 
+	void clear(void);
 	int get_max(void) const { return max_prob_;}
 	int key_to_prob(int key) const;
 	int rnd_num_to_key(int rnd) const;
+	// The entry covering rnd.
+	size_t rnd_num_to_index(int rnd) const;
+	// Entry i covers prob_at(i) numbers, following those of entry i-1.
+	size_t size(void) const { return keys_.size(); }
+	int key_at(size_t i) const { return keys_[i]; }
+	unsigned int prob_at(size_t i) const { return probs_[i]; }
+	// The number after the last one covered by entry i.
+	int end_at(size_t i) const { return ends_[i]; }
 private:
 	int max_prob_;
 	vector<int> keys_;
 	vector<int> probs_; 
+	// Running totals of probs_, searched by rnd_num_to_key.
+	vector<int> ends_;
 };
 
 #endif
@@ -0,0 +1,168 @@
+// -*- mode: C++ -*-
+//
+// Implementations of the engines declared in RandomEngine.h.
+
+#include "RandomEngine.h"
+
+#include <cassert>
+
+#include "Common.h"
+
+using namespace std;
+
+typedef unsigned INT64 UINT64;
+
+static const char *engine_names[MAX_RNDNUM_ENGINE] = {
+	"rand48",
+	"xoshiro256ss",
+	"pcg64",
+};
+
+/*
+ * Used to spread a (small) seed over the state of the larger engines.
+ */
+static UINT64
+splitmix64(UINT64 &x)
+{
+	UINT64 z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Rand48Engine::Rand48Engine(const unsigned long seed)
+	: RandomEngine(eRand48Engine),
+	  // Same as srand48(seed), only the low 32 bits of the seed are used.
+	  state_(((UINT64)(seed & 0xFFFFFFFFUL) << 16) | 0x330E)
+{
+}
+
+void
+Rand48Engine::jump(void)
+{
+	// Squares the step 32 times to get the step for 2^32 draws.
+	UINT64 m = mult;
+	UINT64 a = add;
+	for (int i = 0; i < 32; ++i) {
+		a = ((m + 1) * a) & mask;
+		m = (m * m) & mask;
+	}
+	state_ = (m * state_ + a) & mask;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Xoshiro256Engine::Xoshiro256Engine(const unsigned long seed)
+	: RandomEngine(eXoshiro256Engine)
+{
+	UINT64 x = seed;
+	for (int i = 0; i < 4; ++i)
+		s_[i] = splitmix64(x);
+}
+
+void
+Xoshiro256Engine::jump(void)
+{
+	static const UINT64 jump_poly[] = {
+		0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+		0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL };
+	UINT64 t[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < 4; ++i) {
+		for (int b = 0; b < 64; ++b) {
+			if (jump_poly[i] & (1ULL << b)) {
+				for (int j = 0; j < 4; ++j)
+					t[j] ^= s_[j];
+			}
+			step();
+		}
+	}
+	for (int j = 0; j < 4; ++j)
+		s_[j] = t[j];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const PCG64Engine::U128 PCG64Engine::pcg_mult =
+	{ 0x2360ED051FC65DA4ULL, 0x4385DF649FCCF645ULL };
+
+PCG64Engine::PCG64Engine(const unsigned long seed)
+	: RandomEngine(ePCG64Engine)
+{
+	UINT64 x = seed;
+	U128 init = { splitmix64(x), splitmix64(x) };
+	U128 seq = { splitmix64(x), splitmix64(x) };
+	// Same as pcg64_srandom_r(init, seq).
+	inc_.hi = (seq.hi << 1) | (seq.lo >> 63);
+	inc_.lo = (seq.lo << 1) | 1;
+	state_.hi = state_.lo = 0;
+	advance();
+	state_ = add(state_, init);
+	advance();
+}
+
+void
+PCG64Engine::jump(void)
+{
+	// Advances by 2^64 steps, by squaring the step 64 times.
+	U128 mult = pcg_mult;
+	U128 plus = inc_;
+	for (int i = 0; i < 64; ++i) {
+		U128 one = { 0, 1 };
+		plus = mul(add(mult, one), plus);
+		mult = mul(mult, mult);
+	}
+	state_ = add(mul(mult, state_), plus);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+RandomEngine::RandomEngine(RNDNUM_ENGINE kind)
+	: kind_(kind)
+{
+	// Nothing to do
+}
+
+RandomEngine::~RandomEngine(void)
+{
+	// Nothing to do
+}
+
+/*
+ * Factory method to create engines.
+ */
+RandomEngine *
+RandomEngine::make_engine(RNDNUM_ENGINE kind, const unsigned long seed)
+{
+	switch (kind) {
+	case eRand48Engine:
+		return new Rand48Engine(seed);
+	case eXoshiro256Engine:
+		return new Xoshiro256Engine(seed);
+	case ePCG64Engine:
+		return new PCG64Engine(seed);
+	default:
+		assert(!"unknown random engine");
+		return NULL;
+	}
+}
+
+const char *
+RandomEngine::get_name(RNDNUM_ENGINE kind)
+{
+	assert(kind >= 0 && kind < MAX_RNDNUM_ENGINE);
+	return engine_names[kind];
+}
+
+bool
+RandomEngine::find_engine(const string &name, RNDNUM_ENGINE &kind)
+{
+	for (int i = 0; i < MAX_RNDNUM_ENGINE; ++i) {
+		if (name == engine_names[i]) {
+			kind = static_cast<RNDNUM_ENGINE>(i);
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,222 @@
+// -*- mode: C++ -*-
+//
+// The engines behind AbsRndNumGenerator::genrand(). Each random number
+// generator owns an engine, seeded from the program seed.
+//
+// rand48 is the default, and gives the same numbers as srand48/lrand48, so
+// existing seeds still produce the same programs. xoshiro256** and pcg64 are
+// faster and can jump ahead to start an independent stream from the same
+// seed. Every engine keeps its state in the instance.
+
+#ifndef RANDOM_ENGINE_H
+#define RANDOM_ENGINE_H
+
+#include <string>
+#include "CommonMacros.h"
+
+enum RNDNUM_ENGINE {
+	eRand48Engine = 0,
+	eXoshiro256Engine,
+	ePCG64Engine,
+};
+
+#define MAX_RNDNUM_ENGINE (ePCG64Engine+1)
+
+class RandomEngine
+{
+public:
+	static RandomEngine *make_engine(RNDNUM_ENGINE kind, const unsigned long seed);
+
+	// Name used on the command line, e.g. "xoshiro256ss".
+	static const char *get_name(RNDNUM_ENGINE kind);
+
+	// Returns false if no engine has the given name.
+	static bool find_engine(const std::string &name, RNDNUM_ENGINE &kind);
+
+	// The next number of the stream, at least 31 bits wide.
+	virtual unsigned long next(void) = 0;
+
+	// A number in [0, n). rand48 returns next() % n, as csmith always did;
+	// the other engines draw without the modulo bias.
+	virtual unsigned int next_upto(const unsigned int n) = 0;
+
+	// Advances the stream as if next() had been called a very large number
+	// of times (2^32 for rand48, 2^128 for xoshiro256**, 2^64 for pcg64).
+	virtual void jump(void) = 0;
+
+	// Not virtual, so callers can switch on it and call the final engine
+	// classes below directly, which lets the compiler inline each draw.
+	RNDNUM_ENGINE kind(void) const { return kind_; }
+
+	virtual ~RandomEngine(void);
+
+protected:
+	typedef unsigned long long UINT64;
+
+	explicit RandomEngine(RNDNUM_ENGINE kind);
+
+	// Lemire's multiply and shift, which only draws again for the few
+	// numbers that would make the result biased. Uses the top 32 bits of
+	// each 64-bit output of the engine.
+	template <class Engine>
+	static unsigned int unbiased_upto(Engine &engine, const unsigned int n) {
+		UINT64 m = (engine.step() >> 32) * n;
+		unsigned int low = (unsigned int)m;
+		if (low < n) {
+			const unsigned int threshold = (0U - n) % n;
+			while (low < threshold) {
+				m = (engine.step() >> 32) * n;
+				low = (unsigned int)m;
+			}
+		}
+		return (unsigned int)(m >> 32);
+	}
+
+private:
+	const RNDNUM_ENGINE kind_;
+
+	DISALLOW_COPY_AND_ASSIGN(RandomEngine);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// The same generator as srand48/lrand48, with its state in the engine rather
+// than shared by the process.
+class Rand48Engine final : public RandomEngine
+{
+public:
+	explicit Rand48Engine(const unsigned long seed);
+
+	virtual unsigned long next(void) {
+		// Same as lrand48().
+		state_ = (mult * state_ + add) & mask;
+		return (unsigned long)(state_ >> 17);
+	}
+
+	virtual unsigned int next_upto(const unsigned int n) {
+		return next() % n;
+	}
+
+	virtual void jump(void);
+
+private:
+	static const UINT64 mult = 0x5DEECE66DULL;
+	static const UINT64 add = 0xB;
+	static const UINT64 mask = 0xFFFFFFFFFFFFULL;
+
+	UINT64 state_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class Xoshiro256Engine final : public RandomEngine
+{
+public:
+	explicit Xoshiro256Engine(const unsigned long seed);
+
+	virtual unsigned long next(void) {
+		return (unsigned long)(step() >> 32);
+	}
+
+	virtual unsigned int next_upto(const unsigned int n) {
+		return unbiased_upto(*this, n);
+	}
+
+	virtual void jump(void);
+
+private:
+	friend class RandomEngine;
+
+	static UINT64 rotl(UINT64 x, int k) {
+		return (x << k) | (x >> (64 - k));
+	}
+
+	UINT64 step(void) {
+		const UINT64 result = rotl(s_[1] * 5, 7) * 9;
+		const UINT64 t = s_[1] << 17;
+		s_[2] ^= s_[0];
+		s_[3] ^= s_[1];
+		s_[1] ^= s_[2];
+		s_[0] ^= s_[3];
+		s_[2] ^= t;
+		s_[3] = rotl(s_[3], 45);
+		return result;
+	}
+
+	UINT64 s_[4];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// PCG XSL RR 128/64. The 128-bit multiply is done by hand when the compiler
+// has no 128-bit integer type.
+class PCG64Engine final : public RandomEngine
+{
+public:
+	explicit PCG64Engine(const unsigned long seed);
+
+	virtual unsigned long next(void) {
+		return (unsigned long)(step() >> 32);
+	}
+
+	virtual unsigned int next_upto(const unsigned int n) {
+		return unbiased_upto(*this, n);
+	}
+
+	virtual void jump(void);
+
+private:
+	friend class RandomEngine;
+
+	struct U128 {
+		UINT64 hi;
+		UINT64 lo;
+	};
+
+	static const U128 pcg_mult;
+
+	static U128 add(const U128 &a, const U128 &b) {
+		U128 r;
+		r.lo = a.lo + b.lo;
+		r.hi = a.hi + b.hi + (r.lo < a.lo ? 1 : 0);
+		return r;
+	}
+
+	// Low 128 bits of a * b.
+	static U128 mul(const U128 &a, const U128 &b) {
+#ifdef __SIZEOF_INT128__
+		const unsigned __int128 p =
+			(((unsigned __int128)a.hi << 64) | a.lo) *
+			(((unsigned __int128)b.hi << 64) | b.lo);
+		U128 r = { (UINT64)(p >> 64), (UINT64)p };
+		return r;
+#else
+		const UINT64 a0 = a.lo & 0xFFFFFFFFULL, a1 = a.lo >> 32;
+		const UINT64 b0 = b.lo & 0xFFFFFFFFULL, b1 = b.lo >> 32;
+		const UINT64 p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+		const UINT64 mid = (p00 >> 32) + (p01 & 0xFFFFFFFFULL) + (p10 & 0xFFFFFFFFULL);
+		U128 r;
+		r.lo = (mid << 32) | (p00 & 0xFFFFFFFFULL);
+		r.hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+		r.hi += a.hi * b.lo + a.lo * b.hi;
+		return r;
+#endif
+	}
+
+	void advance(void) {
+		state_ = add(mul(state_, pcg_mult), inc_);
+	}
+
+	// Advances the state and returns the 64-bit output.
+	UINT64 step(void) {
+		advance();
+		const UINT64 xored = state_.hi ^ state_.lo;
+		const int rot = (int)(state_.hi >> 58);
+		return (xored >> rot) | (xored << ((64 - rot) & 63));
+	}
+
+	U128 state_;
+	U128 inc_;
+};
+
+#endif // RANDOM_ENGINE_H
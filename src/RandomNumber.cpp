@@ -34,7 +34,7 @@
 #include "AbsRndNumGenerator.h"
 #include "Filter.h"
 
-RandomNumber *RandomNumber::instance_ = NULL;
+thread_local RandomNumber *RandomNumber::instance_ = NULL;
 
 RandomNumber::RandomNumber(const unsigned long seed)
 	: seed_(seed)
@@ -175,5 +175,6 @@ RandomNumber::doFinalization()
 		}
 	}
 	delete instance_;
+	instance_ = NULL;
 }
 
@@ -236,6 +236,15 @@ static void print_advanced_help()
 	cout << "  --compatible-check: disallow trivial code such as i = i in random programs. ";
 	cout << "Only works in the exhaustive mode." << endl << endl;
 
+	cout << "  --dfs-jobs <num>: enumerate the programs on <num> threads, each exploring its own subtrees of the search (default 1). ";
+	cout << "Only works in the exhaustive mode." << endl << endl;
+
+	cout << "  --dfs-split-depth <num>: hand out the subtrees below the first <num> choices to idle threads (default 8). ";
+	cout << "Only works in the exhaustive mode with --dfs-jobs." << endl << endl;
+
+	cout << "  --dfs-output <prefix>: write the programs found by thread <n> to <prefix>.<n>. ";
+	cout << "Only works in the exhaustive mode with --dfs-jobs." << endl << endl;
+
 	// target platforms
 	cout << "  --msp: enable certain msp related features " << endl << endl; 
 	cout << "  --ccomp: generate compcert-compatible code" << endl << endl;
@@ -270,6 +279,9 @@ static void print_advanced_help()
 	cout << "  --no-delta-reduction: output the same program as <delta-input>. ";
 	cout << "Only works with --go-delta option." << endl << endl;
 
+	cout << "  --rng-engine <rand48|xoshiro256ss|pcg64>: choose the engine of the random number generator (default rand48, ";
+	cout << "the only one that reproduces programs generated by earlier versions)." << endl << endl;
+
 	// probability options
 	cout << "  --dump-default-probabilities <file>: dump the default probability settings into <file>" << endl << endl;
 	cout << "  --dump-random-probabilities <file>: dump the randomized probabilities into <file>" << endl << endl;
@@ -310,6 +322,9 @@ static void print_advanced_help()
 	
 	cout << "  --reduce <file>: reduce random program under the direction of the configuration file." << endl << endl;
 
+	cout << "  --reduce-server: generate the program once, then output it reduced under the direction of each configuration read from stdin, ";
+	cout << "ended by a line \"end\". Each reduced program replaces the output file, and \"done\" is printed once it is written." << endl << endl;
+
 	cout << "  --return-dead-pointer | --no-return-dead-pointer: allow | disallow functions from returning dangling pointers (disallowed by default)." << endl << endl;
 
 	cout <<	"  --identify-wrappers: assign ids to used safe math wrappers." << endl << endl;
@@ -661,6 +676,36 @@ main(int argc, char **argv)
 			continue;
 		}
 
+		if (strcmp (argv[i], "--dfs-jobs") ==0 ) {
+			unsigned long ret;
+			i++;
+			arg_check(argc, i);
+			if (!parse_int_arg(argv[i], &ret))
+				exit(-1);
+			CGOptions::dfs_jobs(ret);
+			continue;
+		}
+
+		if (strcmp (argv[i], "--dfs-split-depth") ==0 ) {
+			unsigned long ret;
+			i++;
+			arg_check(argc, i);
+			if (!parse_int_arg(argv[i], &ret))
+				exit(-1);
+			CGOptions::dfs_split_depth(ret);
+			continue;
+		}
+
+		if (strcmp (argv[i], "--dfs-output") == 0) {
+			string s;
+			i++;
+			arg_check(argc, i);
+			if (!parse_string_arg(argv[i], s))
+				exit(-1);
+			CGOptions::dfs_output(s);
+			continue;
+		}
+
 		if (strcmp (argv[i], "--max-pointer-depth") ==0 ) {
 			unsigned long ret;
 			i++;
@@ -723,6 +768,19 @@ main(int argc, char **argv)
 			continue;
 		}
 
+		if (strcmp (argv[i], "--rng-engine") == 0) {
+			string name;
+			RNDNUM_ENGINE engine;
+			i++;
+			arg_check(argc, i);
+			if (!parse_string_arg(argv[i], name) || !RandomEngine::find_engine(name, engine)) {
+				cout<< "please specify one of rand48, xoshiro256ss or pcg64!" << std::endl;
+				exit(-1);
+			}
+			CGOptions::rng_engine(engine);
+			continue;
+		}
+
 		if (strcmp (argv[i], "--math-notmp") == 0) {
 			CGOptions::math_notmp(true);
 			continue;
@@ -1397,6 +1455,11 @@ main(int argc, char **argv)
 			CGOptions::init_reducer(filename);
 			continue;
 		}
+
+		if (strcmp (argv[i], "--reduce-server") == 0) {
+			CGOptions::reduce_server(true);
+			continue;
+		}
 		// OMIT help
 
 		// OMIT compute-hash
@@ -76,7 +76,8 @@ Reducer::Reducer(string fname)
   monitored_call_id(""),
   dump_stms_in_blocks(NULL),
   configured(false),
-  fname_(fname)	
+  fname_(fname),
+  artificial_globals_cnt_(0)
 {
 	// nothing else to do
 }
@@ -89,11 +90,17 @@ void
 Reducer::configure(void) 
 { 
 	ifstream conf(fname_.c_str());
+	configure(conf);
+	conf.close();
+}
+
+void
+Reducer::configure(std::istream &conf)
+{
 	std::string line;
 	// default: use the first function as mian
 	main = GetFirstFunction();
-	while(!conf.eof()) {
-		getline(conf, line);
+	while (getline(conf, line)) {
 		if (StringUtils::empty_line(line))
 			continue;
 		if (dump_dropped_params) {
@@ -192,10 +199,75 @@ Reducer::configure(void)
 			config_var_init_reduction(line);
 		}
 	}
-	conf.close();
 	configured = true;
 }
 
+/*
+ * Undo the reductions of the previous configuration, so that the next one
+ * applies to the whole program. The program itself is never changed.
+ */
+void
+Reducer::reset(void)
+{
+	dump_block_entry = false;
+	dump_all_block_info = false;
+	dump_monitored_var = false;
+	dump_dropped_params = false;
+	drop_params = false;
+	rewrite_calls_inside = NULL;
+	reduce_binaries = false;
+	output_if_ids = false;
+	monitored_var = NULL;
+	monitored_func = NULL;
+	monitored_call_id = "";
+	crc_lines = "";
+
+	map_active_blks.clear();
+	all_blks.clear();
+	dropped_params.clear();
+
+	replaced_stms.clear();
+	dump_value_before.clear();
+	dump_value_after.clear();
+	map_str_effects.clear();
+	dump_stms_in_blocks = NULL;
+
+	map_reduced_vars.clear();
+	map_reduced_invocations.clear();
+	map_pre_stm_assigns.clear();
+	map_reduced_var_inits.clear();
+	must_use_var_invocations.clear();
+	must_use_var_stms.clear();
+
+	used_funcs.clear();
+	used_vars.clear();
+	used_labels.clear();
+	artificial_globals.clear();
+	artificial_globals_cnt_ = 0;
+	main = NULL;
+	main_str = "";
+	configured = false;
+}
+
+const Block*
+Reducer::find_blk_by_id(int blk_id)
+{
+	if (blks_by_id_.empty()) {
+		const vector<Function*>& funcs = get_all_functions();
+		size_t i, j;
+		for (i=0; i<funcs.size(); i++) {
+			const Function* f = funcs[i];
+			if (f->is_builtin)
+				continue;
+			for (j=0; j<f->blocks.size(); j++) {
+				blks_by_id_[f->blocks[j]->stm_id] = f->blocks[j];
+			}
+		}
+	}
+	map<int, const Block*>::const_iterator iter = blks_by_id_.find(blk_id);
+	return (iter == blks_by_id_.end()) ? NULL : iter->second;
+}
+
 const Statement* 
 Reducer::find_stm_by_id(int stm_id)
 {
@@ -933,7 +1005,7 @@ Reducer::configure_diff_active_blks(string line, int first_bid)
 	StringUtils::split_int_string(line, ids, ",()");  
 	size_t i;
 	assert(!ids.empty()); 
-	const Block* one_branch = find_block_by_id(first_bid); 
+	const Block* one_branch = find_blk_by_id(first_bid); 
 	assert(one_branch);
 	const Statement* stm = one_branch->find_container_stm();
 	if (stm && stm->eType == eIfElse) { 
@@ -941,7 +1013,7 @@ Reducer::configure_diff_active_blks(string line, int first_bid)
 			int id = ids[i];
 			if (1) { //id <= first_bid) {
 				int cnt = ids[i+1];
-				const Block* blk = find_block_by_id(id);
+				const Block* blk = find_blk_by_id(id);
 				assert(blk);
 				map_active_blks[blk] = cnt;
 			}
@@ -988,7 +1060,7 @@ Reducer::config_active_blks(string cmd)
 		if (!take_diff_branch) {
 			StringUtils::split_string(cmd, tmp_strs, ",()");
 			for (i=0; i<tmp_strs.size(); i+=2) {
-				const Block* blk = find_block_by_id(StringUtils::str2int(tmp_strs[i]));
+				const Block* blk = find_blk_by_id(StringUtils::str2int(tmp_strs[i]));
 				assert(i+1 < tmp_strs.size());
 				int cnt = StringUtils::str2int(tmp_strs[i+1]);
 				assert(blk);
@@ -1192,11 +1264,10 @@ Reducer::config_var_init_reduction(string cmd)
 string
 Reducer::add_artificial_globals(const Type* t, string name)
 {
-	static int cnt = 0; 
 	ostringstream oss;
 	t->Output(oss);
 	if (name == "") {
-		name = "tmp_" + StringUtils::int2str(cnt++);
+		name = "tmp_" + StringUtils::int2str(artificial_globals_cnt_++);
 	}
 	artificial_globals.push_back(oss.str() + " " + name);
 	return name;
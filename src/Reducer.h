@@ -59,6 +59,8 @@ public:
 	Reducer(string fname);
 	virtual ~Reducer(void);
 	void configure(void);
+	void configure(std::istream &conf);
+	void reset(void);
 
 	bool is_blk_deleted(const Block* b) const;
 	bool is_stm_deleted(const Statement* stm) const;
@@ -156,6 +158,11 @@ public:
 
 private:
 	string fname_;
+	// names the artificial globals of the current configuration
+	int artificial_globals_cnt_;
+	// all the blocks of the program, by id, built on first use
+	std::map<int, const Block*> blks_by_id_;
+	const Block* find_blk_by_id(int blk_id);
 	const Statement* find_stm_by_id(int stm_id);
 	int find_local_vars_to_lift(vector<const Variable*>& vars);
 };
@@ -88,10 +88,17 @@ ReducerOutputMgr::ReducerOutputMgr()
 }
 
 ReducerOutputMgr::~ReducerOutputMgr()
+{
+	close_main_out();
+}
+
+void
+ReducerOutputMgr::close_main_out(void)
 {
 	if (ofile_) {
 		ofile_->close();
 		delete ofile_;
+		ofile_ = NULL;
 	}
 }
 
@@ -989,7 +996,41 @@ ReducerOutputMgr::Output()
 {
 	// configure reducer
 	reducer->configure();
+	output_reduced_program();
+}
 
+/*
+ * Session mode (--reduce-server): the program is generated once, then output
+ * for each reduction configuration read from `in', in the format of the
+ * --reduce file and ended by a line "end". Each variant replaces the output
+ * file, and "done" is written to `out' once it is complete. The reductions
+ * of one configuration are undone before the next is applied.
+ */
+void
+ReducerOutputMgr::serve(int argc, char *argv[], std::istream &in, std::ostream &out)
+{
+	string line;
+	ostringstream conf;
+	while (getline(in, line)) {
+		if (line != "end") {
+			conf << line << endl;
+			continue;
+		}
+		istringstream config(conf.str());
+		conf.str("");
+		reducer->reset();
+		ResetStructUnionsPrinted();
+		reducer->configure(config);
+		OutputHeader(argc, argv, 0);
+		output_reduced_program();
+		close_main_out();
+		out << "done" << endl;
+	}
+}
+
+void
+ReducerOutputMgr::output_reduced_program(void)
+{
 	// find all the functions and variables that are used after reductions
 	const Function* main = reducer->main;
 	reducer->get_used_vars_and_funcs_and_labels(main->body, reducer->used_vars, reducer->used_funcs, reducer->used_labels);
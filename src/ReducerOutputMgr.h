@@ -58,6 +58,8 @@ public:
 	
 	virtual std::ostream &get_main_out(); 
 
+	void serve(int argc, char *argv[], std::istream &in, std::ostream &out);
+
 	void rewrite_func_call(const Statement* stm, const FunctionInvocation* invoke, string id, std::ostream& out, int indent);
 	int rewrite_func_calls(const Statement* stm, std::ostream &out, int indent);
 	void output_alt_exprs(const Statement* stm, std::ostream &out, int indent);
@@ -90,6 +92,8 @@ public:
 
 private:
 	void OutputGlobals(); 
+	void output_reduced_program(void);
+	void close_main_out(void);
 	void limit_binarys(vector<const FunctionInvocationBinary*>& binarys, vector<int>& ids);
 	std::ofstream *ofile_;
 	Reducer* reducer;
@@ -41,7 +41,7 @@
 
 using namespace std;
 
-vector<string> SafeOpFlags::wrapper_names;
+thread_local vector<string> SafeOpFlags::wrapper_names;
 
 SafeOpFlags::SafeOpFlags()
 {
@@ -262,3 +262,9 @@ SafeOpFlags::to_id(std::string fname)
 	wrapper_names.push_back(fname);
 	return wrapper_names.size();
 }
+
+void
+SafeOpFlags::doFinalization(void)
+{
+	wrapper_names.clear();
+}
@@ -44,10 +44,11 @@
 #include "DefaultRndNumGenerator.h"
 #include "DeltaMonitor.h"
 
-SimpleDeltaRndNumGenerator *SimpleDeltaRndNumGenerator::impl_ = 0;
+thread_local SimpleDeltaRndNumGenerator *SimpleDeltaRndNumGenerator::impl_ = 0;
 
-SimpleDeltaRndNumGenerator::SimpleDeltaRndNumGenerator(Sequence *concrete_seq)
-	: rand_depth_(0),
+SimpleDeltaRndNumGenerator::SimpleDeltaRndNumGenerator(const unsigned long seed, Sequence *concrete_seq)
+	: AbsRndNumGenerator(seed),
+	  rand_depth_(0),
 	  random_point_(0),
 	  filter_depth_(0),
 	  trace_string_(""),
@@ -59,13 +60,14 @@ SimpleDeltaRndNumGenerator::SimpleDeltaRndNumGenerator(Sequence *concrete_seq)
 SimpleDeltaRndNumGenerator::~SimpleDeltaRndNumGenerator()
 {
 	SequenceFactory::destroy_sequences();
+	impl_ = 0;
 }
 
 /*
  * Singleton
  */
 SimpleDeltaRndNumGenerator*
-SimpleDeltaRndNumGenerator::make_rndnum_generator(const unsigned long /*seed*/)
+SimpleDeltaRndNumGenerator::make_rndnum_generator(const unsigned long seed)
 {
 	if (impl_)
 		return impl_;
@@ -74,23 +76,37 @@ SimpleDeltaRndNumGenerator::make_rndnum_generator(const unsigned long /*seed*/)
 
 	seq->init_sequence();
 
-	impl_ = new SimpleDeltaRndNumGenerator(seq);
+	impl_ = new SimpleDeltaRndNumGenerator(seed, seq);
 
-	//srand48(seed);
-
-	impl_->random_point_ = SimpleDeltaRndNumGenerator::pure_rnd_upto(seq->sequence_length());
+	if (seq->sequence_length() > 0)
+		impl_->random_point_ = SimpleDeltaRndNumGenerator::pure_rnd_upto(seq->sequence_length());
 
 	assert(impl_);
 	
 	return impl_;
 }
 
+/*
+ * `percent' is that of rnd_flipcoin(), for the choices made once edited
+ * choices have run out.
+ */
 int
-SimpleDeltaRndNumGenerator::random_choice (int bound, const Filter *f, const string *)
+SimpleDeltaRndNumGenerator::random_choice (int bound, const Filter *f, const string *, int percent)
 {
 	assert(seq_);
 
-        int rv = seq_->get_number(bound);
+	unsigned INT64 local_depth = rand_depth_;
+        int rv;
+	if (replay_ran_out()) {
+		if (percent < 0)
+			rv = genrand_upto(bound);
+		else
+			rv = genrand_upto(100) < static_cast<unsigned int>(percent);
+		seq_->add_number(rv, bound, local_depth);
+	}
+	else {
+		rv = seq_->get_number(bound);
+	}
 	++rand_depth_;
 
         if (rv == -1) {
@@ -101,8 +117,16 @@ SimpleDeltaRndNumGenerator::random_choice (int bound, const Filter *f, const str
         if (f) {
 		++filter_depth_;
                 if (f->filter(rv)) {
-                        Error::set_error(FILTER_ERROR);
-                        return -1;
+			if (!DeltaMonitor::get_replay_choices()) {
+				Error::set_error(FILTER_ERROR);
+				return -1;
+			}
+			rv = next_accepted(bound, f, rv);
+			if (rv == -1) {
+				Error::set_error(FILTER_ERROR);
+				return -1;
+			}
+			seq_->add_number(rv, bound, local_depth);
                 }
 		--filter_depth_;
         }
@@ -110,6 +134,30 @@ SimpleDeltaRndNumGenerator::random_choice (int bound, const Filter *f, const str
         return rv;
 }
 
+/*
+ * Whether the edited choices being replayed have all been used.
+ */
+bool
+SimpleDeltaRndNumGenerator::replay_ran_out()
+{
+	return DeltaMonitor::get_replay_choices() && rand_depth_ >= seq_->sequence_length();
+}
+
+/*
+ * The first value after v, wrapping around, that passes the filter, or -1
+ * if none does.
+ */
+int
+SimpleDeltaRndNumGenerator::next_accepted(int bound, const Filter *f, int v)
+{
+	for (int i = 1; i < bound; ++i) {
+		int next = (v + i) % bound;
+		if (!f->filter(next))
+			return next;
+	}
+	return -1;
+}
+
 /*
  *
  */
@@ -145,9 +193,9 @@ SimpleDeltaRndNumGenerator::rnd_upto(const unsigned int n, const Filter *f, cons
 }
 
 bool
-SimpleDeltaRndNumGenerator::rnd_flipcoin(const unsigned int, const Filter *f, const std::string *where)
+SimpleDeltaRndNumGenerator::rnd_flipcoin(const unsigned int p, const Filter *f, const std::string *where)
 {
-	int y = random_choice(2, f, where);
+	int y = random_choice(2, f, where, p);
 	assert(y == -1 || (y >= 0 && y < 2));
 	return y;
 }
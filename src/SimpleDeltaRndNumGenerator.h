@@ -67,11 +67,15 @@ public:
 
 private:
 	// ------------------------------------------------------------------------------------------
-	SimpleDeltaRndNumGenerator(Sequence *concrete_seq);
+	SimpleDeltaRndNumGenerator(const unsigned long seed, Sequence *concrete_seq);
 
 	virtual unsigned long genrand(void);
 
-	int random_choice(int bound, const Filter *f = NULL, const std::string *where = NULL);
+	int random_choice(int bound, const Filter *f = NULL, const std::string *where = NULL, int percent = -1);
+
+	bool replay_ran_out();
+
+	int next_accepted(int bound, const Filter *f, int v);
 
 	static unsigned int pure_rnd_upto(const unsigned int bound);
 
@@ -80,7 +84,7 @@ private:
 	void switch_to_default_generator();
 
 	// ----------------------------------------------------------------------------------------
-	static SimpleDeltaRndNumGenerator *impl_;
+	static thread_local SimpleDeltaRndNumGenerator *impl_;
 
 	unsigned INT64 rand_depth_;
 
@@ -81,7 +81,7 @@ SimpleDeltaSequence::ValuePair::~ValuePair( )
 ///////////////////////////////////////////////////////////////////
 const char SimpleDeltaSequence::default_sep_char = ',';
 
-SimpleDeltaSequence *SimpleDeltaSequence::impl_ = NULL;
+thread_local SimpleDeltaSequence *SimpleDeltaSequence::impl_ = NULL;
 
 SimpleDeltaSequence::SimpleDeltaSequence(const char sep_char)
 	: sep_char_(sep_char),
@@ -92,7 +92,11 @@ SimpleDeltaSequence::SimpleDeltaSequence(const char sep_char)
 
 SimpleDeltaSequence::~SimpleDeltaSequence()
 {
-	// Nothing to do
+	clear();
+	std::map<int, SimpleDeltaSequence::ValuePair*>::iterator i;
+	for (i = sequence_.begin(); i != sequence_.end(); ++i)
+		delete (*i).second;
+	impl_ = NULL;
 }
 
 /*
@@ -125,6 +129,13 @@ SimpleDeltaSequence::empty_line(const std::string &line)
 void
 SimpleDeltaSequence::init_sequence()
 {
+	const DeltaMonitor::Choices *choices = DeltaMonitor::get_replay_choices();
+	if (choices) {
+		for (size_t i = 0; i < choices->size(); ++i)
+			sequence_[i] = new SimpleDeltaSequence::ValuePair((*choices)[i].first, (*choices)[i].second);
+		return;
+	}
+
 	const std::string &fname = DeltaMonitor::get_input();
 	assert(!fname.empty());
 
@@ -152,7 +163,14 @@ void
 SimpleDeltaSequence::add_number(int v, int bound, int k)
 {
 	SimpleDeltaSequence::ValuePair *p = new SimpleDeltaSequence::ValuePair(v, bound);
-	seq_map_[k] = p;
+	std::map<int, SimpleDeltaSequence::ValuePair*>::iterator i = seq_map_.find(k);
+	if (i != seq_map_.end()) {
+		delete (*i).second;
+		(*i).second = p;
+	}
+	else {
+		seq_map_[k] = p;
+	}
 }
 
 int
@@ -165,14 +183,28 @@ SimpleDeltaSequence::get_number_by_pos(int /*pos*/)
 int
 SimpleDeltaSequence::get_number(int bound)
 {
-	
-	SimpleDeltaSequence::ValuePair *p = sequence_[current_pos_];
-	assert("SimpleDeltaSequence: get_number p is NULL!" && p);
-	int b = p->get_bound();
-	assert("SimpleDeltaSequence: bound doesn't match!" && bound == b);
-	seq_map_[current_pos_] = p;
+	std::map<int, SimpleDeltaSequence::ValuePair*>::iterator i = sequence_.find(current_pos_);
+	int v;
+	if (DeltaMonitor::get_replay_choices()) {
+		// Edited choices: past their end, there is no number; a value out of
+		// its bound is replaced by the largest one in it.
+		if (i == sequence_.end())
+			return -1;
+		v = (*i).second->get_value();
+		if (v >= bound)
+			v = bound - 1;
+		if (v < 0)
+			v = 0;
+	}
+	else {
+		assert("SimpleDeltaSequence: get_number p is NULL!" && i != sequence_.end());
+		int b = (*i).second->get_bound();
+		assert("SimpleDeltaSequence: bound doesn't match!" && bound == b);
+		v = (*i).second->get_value();
+	}
+	add_number(v, bound, current_pos_);
 	++current_pos_;
-	return p->get_value();
+	return v;
 }
 
 void 
@@ -74,7 +74,7 @@ private:
 
 	std::map<int, ValuePair*> sequence_;
 
-	static SimpleDeltaSequence *impl_;
+	static thread_local SimpleDeltaSequence *impl_;
 
 	const char sep_char_;
 
@@ -81,13 +81,14 @@
 #include "util.h"
 #include "StringUtils.h"
 #include "VariableSelector.h"
+#include "Bookkeeper.h"
 
 namespace CLSmith {
 Statement *make_random_st(CGContext& cg_context);
 }  // namespace CLSmith
 
 using namespace std;
-const Statement* Statement::failed_stm;
+thread_local const Statement* Statement::failed_stm;
 
 ///////////////////////////////////////////////////////////////////////////////
 class StatementFilter : public Filter
@@ -115,7 +116,7 @@ StatementFilter::~StatementFilter(void)
 
 // use a table to define probabilities of different kinds of statements
 // Must initialize it before use
-ProbabilityTable<unsigned int, ProbName> *Statement::stmtTable_ = NULL;
+thread_local ProbabilityTable<unsigned int, ProbName> *Statement::stmtTable_ = NULL;
 
 void
 Statement::InitProbabilityTable()
@@ -127,6 +128,19 @@ Statement::InitProbabilityTable()
 	Statement::stmtTable_->initialize(pStatementProb);
 }
 
+/*
+ * The statement table is built from the probabilities of the current run, so
+ * it is released along with them.
+ */
+void
+Statement::doFinalization(void)
+{
+	delete Statement::stmtTable_;
+	Statement::stmtTable_ = NULL;
+	Statement::failed_stm = NULL;
+	Statement::sid = 0;
+}
+
 eStatementType
 Statement::number_to_type(unsigned int value)
 {
@@ -235,7 +249,7 @@ StatementProbability(const StatementFilter *filter)
 	return Statement::number_to_type(value);
 }
 
-int Statement::sid = 0;
+thread_local int Statement::sid = 0;
 /*
  *
  */
@@ -385,7 +399,8 @@ Statement::is_ptr_used(void) const
 Statement::Statement(eStatementType st, Block* b)
 	: eType(st),
 	func(b ? b->func : 0),
-	parent(b)
+	parent(b),
+	analysis_cnt(0)
 {
 	stm_id = Statement::sid;
 	Statement::sid++;
@@ -597,6 +612,7 @@ Statement::shortcut_analysis(vector<const Fact*>& inputs, CGContext& cg_context)
 		inputs = fm->map_facts_out[this];
 		cg_context.add_effect(fm->map_stm_effect[this]);
 		fm->map_accum_effect[this] = *(cg_context.get_effect_accum());
+		Bookkeeper::stm_shortcut_cnt++;
 		return 0;
 	}
 	return 2;
@@ -649,6 +665,8 @@ Statement::stm_visit_facts(vector<const Fact*>& inputs, CGContext& cg_context) c
 	cg_context.get_effect_stm().clear();
 	cg_context.curr_blk = parent;
 	FactMgr* fm = get_fact_mgr(&cg_context);
+	Bookkeeper::stm_visit_cnt++;
+	analysis_cnt++;
 	//static int g = 0;
 	//int h = g++;
 	bool ok = visit_facts(inputs, cg_context);
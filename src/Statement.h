@@ -43,6 +43,7 @@
 #include <ostream>
 #include <string>
 #include "Probabilities.h"
+#include "Arena.h"
 using namespace std;
 
 #ifndef STATEMENT_H
@@ -91,6 +92,8 @@ enum eStatementType
 class Statement
 {
 public:
+	ARENA_ALLOCATED
+
 	// Factory methods.
 	static Statement *make_random(CGContext &cg_context, eStatementType t = MAX_STATEMENT_TYPE);
 	static Statement *make_noop(CGContext &cg_context);
@@ -178,20 +181,24 @@ public:
 
 	static int get_current_sid(void) { return sid; }
 
+	static void doFinalization(void);
+
 	int get_blk_depth(void) const;
 
 	// unique id for each statement
 	int stm_id;
 	Function* func;
 	Block* parent;
-	static const Statement* failed_stm;
+	// times the dataflow analysis visited the statement, for the statistics
+	mutable int analysis_cnt;
+	static thread_local const Statement* failed_stm;
 
-	static ProbabilityTable<unsigned int, ProbName> *stmtTable_;
+	static thread_local ProbabilityTable<unsigned int, ProbName> *stmtTable_;
 protected:
 	Statement(eStatementType st, Block* parent);
 
 private:
-	static int sid;
+	static thread_local int sid;
 
 	Statement &operator=(const Statement &s); // unimplementable
 
@@ -62,7 +62,7 @@ using namespace std;
 //
 // use a table to define probabilities of different kinds of statements
 // Must initialize it before use
-DistributionTable StatementAssign::assignOpsTable_;
+thread_local DistributionTable StatementAssign::assignOpsTable_;
 
 void
 StatementAssign::InitProbabilityTable()
@@ -82,6 +82,12 @@ StatementAssign::InitProbabilityTable()
 	}
 }
 
+void
+StatementAssign::doFinalization(void)
+{
+	assignOpsTable_.clear();
+}
+
 eAssignOps
 StatementAssign::AssignOpsProbability(const Type* type)
 {
@@ -66,7 +66,7 @@ StatementIf::make_random(CGContext &cg_context)
         // generated to be a atomic expression; however, do not generate
         // another atomic expression within an atomic block
         bool build_atomic = CLSmith::CLOptions::atomics() && !cg_context.get_atomic_context() && rnd_flipcoin(30);
-        static int thru = 0;
+        static thread_local int thru = 0;
         thru++;
         if (build_atomic) {
 //           std::cout << "Start atomic block" << std::endl;
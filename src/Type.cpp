@@ -60,14 +60,16 @@ using namespace std;
 /*
  *
  */
-const Type *Type::simple_types[MAX_SIMPLE_TYPES];
+thread_local const Type *Type::simple_types[MAX_SIMPLE_TYPES];
 
-Type *Type::void_type = NULL;
+thread_local Type *Type::void_type = NULL;
 
 // ---------------------------------------------------------------------
 // List of all types used in the program
-static vector<Type *> AllTypes;
-static vector<Type *> derived_types;
+static thread_local vector<Type *> AllTypes;
+static thread_local vector<Type *> derived_types;
+// Sequence number of the next struct or union type
+static thread_local unsigned int struct_union_sequence = 0;
 
 //////////////////////////////////////////////////////////////////////
 class NonVoidTypeFilter : public Filter
@@ -293,12 +295,11 @@ Type::Type(vector<const Type*>& struct_fields, bool isStruct, bool packed,
     qfers_(qfers),
     bitfields_length_(fields_length)
 {
-    static unsigned int sequence = 0;
 	if (isStruct) 
         eType = eStruct;
     else
         eType = eUnion;
-    sid =  sequence++;
+    sid =  struct_union_sequence++;
 }
 
 // --------------------------------------------------------------
@@ -342,7 +343,7 @@ Type::operator=(const Type& t)
 const Type &
 Type::get_simple_type(eSimpleType st)
 {
-	static bool inited = false;
+	static thread_local bool inited = false;
 
 	if (!inited) {
 		for (int i = 0; i < MAX_SIMPLE_TYPES; ++i) {
@@ -1760,6 +1761,18 @@ void OutputStructUnion(Type* type, std::ostream &out)
     }
 }
 
+// ---------------------------------------------------------------------
+/* forget which struct definitions have been printed, so that the
+ * program can be printed again
+ *************************************************************/
+void
+ResetStructUnionsPrinted(void)
+{
+    for (size_t i=0; i<AllTypes.size(); i++) {
+        AllTypes[i]->printed = false;
+    }
+}
+
 // ---------------------------------------------------------------------
 /* print all struct definitions (fields etc)
  *************************************************************/
@@ -1824,6 +1837,13 @@ Type::doFinalization(void)
 	for(j = derived_types.begin(); j != derived_types.end(); ++j)
 		delete (*j);
 	derived_types.clear();
+
+	delete Type::void_type;
+	Type::void_type = NULL;
+	for (int i = 0; i < MAX_SIMPLE_TYPES; ++i) {
+		Type::simple_types[i] = 0;
+	}
+	struct_union_sequence = 0;
 }
 
 
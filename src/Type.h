@@ -276,11 +276,11 @@ public:
 
 	int vector_length_;                 // For vectors. Embed the length.
 
-	static Type *void_type;
+	static thread_local Type *void_type;
 private:	
 	DISALLOW_COPY_AND_ASSIGN(Type);
 
-	static const Type *simple_types[MAX_SIMPLE_TYPES];
+	static thread_local const Type *simple_types[MAX_SIMPLE_TYPES];
 
 	// Package init.
 	friend void GenerateAllTypes(void);
@@ -290,6 +290,7 @@ void GenerateAllTypes(void);
 const Type * get_int_type(void);
 void OutputStructUnionDeclarations(std::ostream &);
 void OutputStructUnion(Type* type, std::ostream &out);
+void ResetStructUnionsPrinted(void);
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -69,8 +69,8 @@
 
 using namespace std;
 // Yang: I changed the definition of ctrl_vars, and ReducerMgr might be affected
-std::vector< std::vector<const Variable*>* > Variable::ctrl_vars_vectors;
-unsigned long Variable::ctrl_vars_count;
+thread_local std::vector< std::vector<const Variable*>* > Variable::ctrl_vars_vectors;
+thread_local unsigned long Variable::ctrl_vars_count;
 
 const char Variable::sink_var_name[] = "csmith_sink_";
 
@@ -944,6 +944,7 @@ Variable::doFinalization(void)
 		delete v;
 	}
 	ctrl_vars_vectors.clear();
+	ctrl_vars_count = 0;
 }
 
 // --------------------------------------------------------------
@@ -51,6 +51,7 @@ using namespace std;
 #include "Type.h"
 #include "CVQualifiers.h"
 #include "StringUtils.h"
+#include "Arena.h"
 
 class CGContext;
 class Expression;
@@ -64,6 +65,8 @@ class Variable
 	friend class VariableSelector;
 	friend class ArrayVariable;
 public:
+	ARENA_ALLOCATED
+
 	static Variable *CreateVariable(const std::string &name, const Type *type, const Expression* init, const CVQualifiers* qfer);
 	static Variable *CreateVariable(const std::string &name, const Type *type,
 			 bool isConst, bool isVolatile,
@@ -169,8 +172,8 @@ protected:
 			 bool isAuto, bool isStatic, bool isRegister, bool isBitfield, const Variable* isFieldVarOf);
 
 	static std::vector<const Variable*>& new_ctrl_vars(void);
-	static std::vector< std::vector<const Variable*>* > ctrl_vars_vectors;
-	static unsigned long ctrl_vars_count;
+	static thread_local std::vector< std::vector<const Variable*>* > ctrl_vars_vectors;
+	static thread_local unsigned long ctrl_vars_count;
 
 	void create_field_vars(const Type* type);
 };
@@ -0,0 +1,163 @@
+// -*- mode: C++ -*-
+//
+// Implementation of the index declared in VariableIndex.h.
+
+#include "VariableIndex.h"
+
+#include <cassert>
+
+#include "Type.h"
+#include "Variable.h"
+
+using namespace std;
+
+VariableIndex::VariableIndex(void)
+	: indexed_count_(0),
+	  version_(0),
+	  rewrite_version_(0)
+{
+	// Nothing else to do
+}
+
+VariableIndex::~VariableIndex(void)
+{
+	// Nothing to do
+}
+
+void
+VariableIndex::clear(void)
+{
+	depths_.clear();
+	indexed_count_ = 0;
+	version_ = 0;
+	rewrite_version_ = 0;
+}
+
+void
+VariableIndex::sync(const VariableList &vars)
+{
+	if (indexed_count_ > 0 && vars.version() == version_)
+		return;
+	if (vars.rewrite_version() != rewrite_version_ || indexed_count_ > vars.size())
+		clear();
+	for (; indexed_count_ < vars.size(); ++indexed_count_) {
+		add_var(vars[indexed_count_], vars[indexed_count_], 0);
+	}
+	version_ = vars.version();
+	rewrite_version_ = vars.rewrite_version();
+}
+
+/*
+ * Same rule as VariableSelector::expand_struct_union_vars(), for a type
+ * that is not a struct or union: only virtual variables are left whole.
+ */
+void
+VariableIndex::add_var(Variable *var, Variable *scope_var, size_t depth)
+{
+	if (var->is_virtual() || !var->is_aggregate()) {
+		if (depths_.size() <= depth)
+			depths_.resize(depth + 1);
+		DepthViews &views = depths_[depth];
+		Entry entry = { var, scope_var };
+		views.vars.push_back(entry);
+		size_t level = var->type ? var->type->get_indirect_level() : 0;
+		if (views.level_vars.size() <= level)
+			views.level_vars.resize(level + 1);
+		views.level_vars[level].push_back(entry);
+		views.type_vars[var->type].push_back(entry);
+		if (var->type && var->type->eType == ePointer)
+			views.pointer_vars.push_back(entry);
+		if (var->is_volatile())
+			views.volatile_vars.push_back(entry);
+		return;
+	}
+	for (size_t i = 0; i < var->field_vars.size(); ++i) {
+		add_var(var->field_vars[i], scope_var, depth + 1);
+	}
+}
+
+/*
+ * "view" gives the entries of one depth of a scope to list, or null.
+ */
+template <class View>
+void
+VariableIndex::collect_view(const vector<const VariableIndex *> &scopes,
+			    View view, vector<Variable *> &vars, VariableFilter keep)
+{
+	size_t max_depth = 0;
+	for (size_t s = 0; s < scopes.size(); ++s) {
+		if (scopes[s]->depths_.size() > max_depth)
+			max_depth = scopes[s]->depths_.size();
+	}
+	for (size_t d = 0; d < max_depth; ++d) {
+		for (size_t s = 0; s < scopes.size(); ++s) {
+			if (d >= scopes[s]->depths_.size())
+				continue;
+			const vector<Entry> *entries = view(scopes[s]->depths_[d]);
+			if (entries == 0)
+				continue;
+			for (size_t i = 0; i < entries->size(); ++i) {
+				const Entry &entry = (*entries)[i];
+				if (keep == 0 || keep(entry.scope_var))
+					vars.push_back(entry.var);
+			}
+		}
+	}
+}
+
+void
+VariableIndex::collect(const vector<const VariableIndex *> &scopes,
+		       vector<Variable *> &vars, VariableFilter keep)
+{
+	collect_view(scopes,
+		     [](const DepthViews &views) { return &views.vars; },
+		     vars, keep);
+}
+
+void
+VariableIndex::collect(const vector<const VariableIndex *> &scopes,
+		       int indirect_level, vector<Variable *> &vars, VariableFilter keep)
+{
+	assert(indirect_level >= 0);
+	size_t level = indirect_level;
+	collect_view(scopes,
+		     [level](const DepthViews &views) -> const vector<Entry> * {
+			     if (level >= views.level_vars.size())
+				     return 0;
+			     return &views.level_vars[level];
+		     },
+		     vars, keep);
+}
+
+void
+VariableIndex::collect(const vector<const VariableIndex *> &scopes,
+		       const Type *type, vector<Variable *> &vars, VariableFilter keep)
+{
+	collect_view(scopes,
+		     [type](const DepthViews &views) -> const vector<Entry> * {
+			     unordered_map<const Type *, vector<Entry> >::const_iterator i =
+				     views.type_vars.find(type);
+			     if (i == views.type_vars.end())
+				     return 0;
+			     return &i->second;
+		     },
+		     vars, keep);
+}
+
+void
+VariableIndex::collect_pointers(const vector<const VariableIndex *> &scopes,
+				vector<Variable *> &vars, VariableFilter keep)
+{
+	collect_view(scopes,
+		     [](const DepthViews &views) { return &views.pointer_vars; },
+		     vars, keep);
+}
+
+void
+VariableIndex::collect_volatiles(const vector<const VariableIndex *> &scopes,
+				 vector<Variable *> &vars, VariableFilter keep)
+{
+	collect_view(scopes,
+		     [](const DepthViews &views) { return &views.volatile_vars; },
+		     vars, keep);
+}
@@ -0,0 +1,165 @@
+// -*- mode: C++ -*-
+//
+// An index over one scope of variables (the globals, the parameters of a
+// function or the locals of a block), used by VariableSelector instead of
+// expanding the struct and union variables of the scope on every call.
+//
+// The variables are kept in the order expand_struct_union_vars() would give
+// them: the fields are grouped by their depth in the outermost variable, and
+// the depths follow each other. The same random number picks the same
+// variable either way.
+//
+// The scope is a VariableList, which only hands out const access to its
+// variables and counts its changes, so the index can tell when it is stale.
+
+#ifndef VARIABLE_INDEX_H
+#define VARIABLE_INDEX_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+class Type;
+class Variable;
+
+// The variables of one scope. Reads behave like a const std::vector, and the
+// list converts to one. Every change goes through the members below, which
+// bump the version, so nothing can replace a variable behind the index.
+class VariableList
+{
+public:
+	typedef std::vector<Variable *>::const_iterator const_iterator;
+
+	VariableList(void) : version_(0), rewrite_version_(0) {}
+
+	operator const std::vector<Variable *> &(void) const { return vars_; }
+	const std::vector<Variable *> &get_vars(void) const { return vars_; }
+
+	size_t size(void) const { return vars_.size(); }
+	bool empty(void) const { return vars_.empty(); }
+	Variable *operator[](size_t i) const { return vars_[i]; }
+	Variable *back(void) const { return vars_.back(); }
+	const_iterator begin(void) const { return vars_.begin(); }
+	const_iterator end(void) const { return vars_.end(); }
+
+	void push_back(Variable *var) { vars_.push_back(var); ++version_; }
+
+	template <class InputIterator>
+	void append(InputIterator first, InputIterator last) {
+		vars_.insert(vars_.end(), first, last);
+		++version_;
+	}
+
+	void set(size_t i, Variable *var) { vars_[i] = var; rewrite(); }
+
+	template <class Predicate>
+	void remove_if(Predicate pred) {
+		std::vector<Variable *>::iterator i = vars_.begin();
+		for (; i != vars_.end() && !pred(*i); ++i)
+			;
+		if (i == vars_.end())
+			return;
+		for (std::vector<Variable *>::iterator j = i + 1; j != vars_.end(); ++j) {
+			if (!pred(*j))
+				*i++ = *j;
+		}
+		vars_.erase(i, vars_.end());
+		rewrite();
+	}
+
+	void clear(void) { vars_.clear(); rewrite(); }
+
+	// Bumped by every change.
+	unsigned long version(void) const { return version_; }
+
+	// Bumped by every change other than appending variables.
+	unsigned long rewrite_version(void) const { return rewrite_version_; }
+
+private:
+	void rewrite(void) { ++version_; ++rewrite_version_; }
+
+	std::vector<Variable *> vars_;
+
+	unsigned long version_;
+
+	unsigned long rewrite_version_;
+};
+
+class VariableIndex
+{
+public:
+	// Decides if a variable of the scope, and all its fields, are listed.
+	typedef bool (*VariableFilter)(const Variable *var);
+
+	VariableIndex(void);
+	~VariableIndex(void);
+
+	// Brings the index up to date with the variables of the scope. Nothing
+	// is done if the list has not changed since the last call, variables
+	// appended since then are added, and any other change rebuilds the index.
+	void sync(const VariableList &vars);
+
+	void clear(void);
+
+	// The following append expanded variables of several scopes to "vars",
+	// in the order they would have if the scopes were appended to each other
+	// and then expanded. "keep" is applied to the variables of the scopes.
+
+	// All of them.
+	static void collect(const std::vector<const VariableIndex *> &scopes,
+			    std::vector<Variable *> &vars, VariableFilter keep = 0);
+
+	// Those with the given level of indirection.
+	static void collect(const std::vector<const VariableIndex *> &scopes,
+			    int indirect_level, std::vector<Variable *> &vars,
+			    VariableFilter keep = 0);
+
+	// Those of exactly the given type.
+	static void collect(const std::vector<const VariableIndex *> &scopes,
+			    const Type *type, std::vector<Variable *> &vars,
+			    VariableFilter keep = 0);
+
+	// The pointers.
+	static void collect_pointers(const std::vector<const VariableIndex *> &scopes,
+				     std::vector<Variable *> &vars, VariableFilter keep = 0);
+
+	// The volatiles.
+	static void collect_volatiles(const std::vector<const VariableIndex *> &scopes,
+				      std::vector<Variable *> &vars, VariableFilter keep = 0);
+
+private:
+	struct Entry
+	{
+		Variable *var;
+		// The variable of the scope it belongs to.
+		Variable *scope_var;
+	};
+
+	// The variables at one depth in the variables of the scope, which are
+	// not broken up further, and the same grouped in a few ways. Appending
+	// to the scope only appends to these.
+	struct DepthViews
+	{
+		std::vector<Entry> vars;
+		std::vector<std::vector<Entry> > level_vars;
+		std::unordered_map<const Type *, std::vector<Entry> > type_vars;
+		std::vector<Entry> pointer_vars;
+		std::vector<Entry> volatile_vars;
+	};
+
+	template <class View>
+	static void collect_view(const std::vector<const VariableIndex *> &scopes,
+				 View view, std::vector<Variable *> &vars, VariableFilter keep);
+
+	void add_var(Variable *var, Variable *scope_var, size_t depth);
+
+	std::vector<DepthViews> depths_;
+
+	size_t indexed_count_;
+
+	// The versions of the list when it was last synced.
+	unsigned long version_;
+	unsigned long rewrite_version_;
+};
+
+#endif // VARIABLE_INDEX_H
@@ -78,10 +78,14 @@ using namespace std;
 
 // --------------------------------------------------------------
 // static variables 
-vector<Variable*> VariableSelector::AllVars; 
-vector<Variable*> VariableSelector::GlobalList; 
-vector<Variable*> VariableSelector::GlobalNonvolatilesList; 
-bool VariableSelector::var_created = false;
+thread_local vector<Variable*> VariableSelector::AllVars; 
+thread_local VariableList VariableSelector::GlobalList;
+thread_local VariableList VariableSelector::GlobalNonvolatilesList;
+thread_local VariableIndex VariableSelector::GlobalIndex;
+thread_local VariableIndex VariableSelector::GlobalNonvolatilesIndex;
+thread_local unordered_map<string, const Variable*> VariableSelector::VarsByName;
+thread_local size_t VariableSelector::VarsByNameCount = 0;
+thread_local bool VariableSelector::var_created = false;
 
 class VariableSelectFilter : public Filter
 {
@@ -92,6 +96,8 @@ public:
 
 	virtual bool filter(int v) const;
 
+	virtual bool accepted_ranges(unsigned int n, FilterRanges &ranges) const;
+
 private:
 	const CGContext &cg_context_;
 
@@ -119,7 +125,22 @@ VariableSelectFilter::filter(int v) const
 	return false;
 }
 
-ProbabilityTable<unsigned int, eVariableScope> *VariableSelector::scopeTable_ = NULL;
+bool
+VariableSelectFilter::accepted_ranges(unsigned int n, FilterRanges &ranges) const
+{
+	const ProbabilityTable<unsigned int, eVariableScope> *table = VariableSelector::scopeTable_;
+	bool no_params = cg_context_.get_current_func()->param.empty();
+	unsigned int first = 0;
+	for (size_t i = 0; i < table->size() && first < n; ++i) {
+		unsigned int last = std::min(table->key_at(i), n);
+		if (!(no_params && table->value_at(i) == eParentParam))
+			add_range(ranges, first, last);
+		first = last;
+	}
+	return true;
+}
+
+thread_local ProbabilityTable<unsigned int, eVariableScope> *VariableSelector::scopeTable_ = NULL;
 
 void
 VariableSelector::InitScopeTable()
@@ -416,7 +437,7 @@ VariableSelector::choose_visible_read_var(const Block* b, vector<const Variable*
  * see CVQualifier::match
  */
 Variable *
-VariableSelector::choose_var(vector<Variable *> vars,
+VariableSelector::choose_var(const vector<Variable *> &vars,
 		   Effect::Access access,
 		   const CGContext &cg_context,
 		   const Type* type,
@@ -426,20 +447,81 @@ VariableSelector::choose_var(vector<Variable *> vars,
 		   bool no_bitfield,
 		   bool no_expand_struct_union)
 {
-	vector<Variable *> ok_vars;
-	vector<Variable *>::iterator i;
+	if (!no_expand_struct_union && type && (type->eType == eSimple || type->is_aggregate())) {
+		vector<Variable *> expanded_vars = vars;
+		expand_struct_union_vars(expanded_vars, type); 
+		return choose_expanded_var(expanded_vars, expanded_vars, expanded_vars, access, cg_context, type, qfer, mt, invalid_vars, no_bitfield);
+	}
+	return choose_expanded_var(vars, vars, vars, access, cg_context, type, qfer, mt, invalid_vars, no_bitfield);
+}
+
+/*
+ * Same as choose_var, for the variables of a scope that keeps an index of
+ * them. Expanding the structs and unions of a scope is done once, instead
+ * of on every call.
+ */
+Variable *
+VariableSelector::choose_indexed_var(VariableIndex &index,
+		   const VariableList &vars,
+		   Effect::Access access,
+		   const CGContext &cg_context,
+		   const Type* type,
+		   const CVQualifiers* qfer,
+		   eMatchType mt,
+		   const vector<const Variable*>& invalid_vars,
+		   bool no_bitfield,
+		   bool no_expand_struct_union)
+{
+	// the index only breaks up all the structs and unions, which is what
+	// expand_struct_union_vars does for simple types
+	if (no_expand_struct_union || !type || type->eType != eSimple) {
+		return choose_var(vars, access, cg_context, type, qfer, mt, invalid_vars, no_bitfield, no_expand_struct_union);
+	}
+	index.sync(vars);
+	vector<const VariableIndex *> scopes(1, &index);
+	vector<Variable *> pointer_vars, volatile_vars, candidates;
+	VariableIndex::collect_pointers(scopes, pointer_vars);
+	VariableIndex::collect_volatiles(scopes, volatile_vars);
+	// an exact match has the type itself, a converted match has its
+	// indirection level
+	if (mt == eExact)
+		VariableIndex::collect(scopes, type, candidates);
+	else if (mt == eConvert)
+		VariableIndex::collect(scopes, type->get_indirect_level(), candidates);
+	else
+		VariableIndex::collect(scopes, candidates);
+	return choose_expanded_var(pointer_vars, volatile_vars, candidates, access, cg_context, type, qfer, mt, invalid_vars, no_bitfield);
+}
 
-	if (!no_expand_struct_union && type && (type->eType == eSimple || type->is_aggregate()))
-		expand_struct_union_vars(vars, type); 
+/*
+ * Chooses among "candidates", which are the variables in scope that may
+ * match the type. "pointer_vars" and "volatile_vars" are only used for the
+ * statistics, and hold at least the pointers and the volatiles in scope,
+ * which are the only variables the statistics can count.
+ */
+Variable *
+VariableSelector::choose_expanded_var(const vector<Variable *> &pointer_vars,
+		   const vector<Variable *> &volatile_vars,
+		   const vector<Variable *> &candidates,
+		   Effect::Access access,
+		   const CGContext &cg_context,
+		   const Type* type,
+		   const CVQualifiers* qfer,
+		   eMatchType mt,
+		   const vector<const Variable*>& invalid_vars,
+		   bool no_bitfield)
+{
+	vector<Variable *> ok_vars;
+	vector<Variable *>::const_iterator i;
 
-	bool found = has_dereferenceable_var(vars, type, cg_context);
+	bool found = has_dereferenceable_var(pointer_vars, type, cg_context);
 	if (found) {
 		Bookkeeper::pointer_avail_for_dereference++;
 	}
 	// check availability of volatiles
-	has_eligible_volatile_var(vars, type, qfer, access, cg_context);
+	has_eligible_volatile_var(volatile_vars, type, qfer, access, cg_context);
 
-	for (i = vars.begin(); i != vars.end(); ++i) {
+	for (i = candidates.begin(); i != candidates.end(); ++i) {
         // skip any type mismatched var
         if (no_bitfield && (*i)->isBitfield_)
 			continue;
@@ -538,7 +620,7 @@ VariableSelector::create_and_initialize(Effect::Access access, const CGContext &
 	return var;
 }
 
-static int tmp_count = 0;
+static thread_local int tmp_count = 0;
 // --------------------------------------------------------------
  /* Parameter "type"
  * 0 --- To generate any type
@@ -629,7 +711,7 @@ VariableSelector::eager_create_global_struct(Effect::Access access, const CGCont
 		return NULL;
 
 	ERROR_GUARD(NULL);
-	return choose_var(GlobalList, access, cg_context, type, qfer, mt, invalid_vars);
+	return choose_indexed_var(GlobalIndex, GlobalList, access, cg_context, type, qfer, mt, invalid_vars);
 }
 
 Variable*
@@ -663,7 +745,7 @@ VariableSelector::eager_create_local_struct(Block &block, Effect::Access access,
 		return NULL;
 
 	ERROR_GUARD(NULL);
-	return choose_var(block.local_vars, access, cg_context, type, qfer, mt, invalid_vars);
+	return choose_indexed_var(block.local_var_index, block.local_vars, access, cg_context, type, qfer, mt, invalid_vars);
 }
 
 
@@ -672,7 +754,7 @@ VariableSelector::eager_create_local_struct(Block &block, Effect::Access access,
 Variable *
 VariableSelector::SelectGlobal(Effect::Access access, const CGContext &cg_context, const Type* type, const CVQualifiers* qfer, eMatchType mt, const vector<const Variable*>& invalid_vars)
 {
-	Variable* var = choose_var(GlobalList, access, cg_context, type, qfer, mt, invalid_vars);
+	Variable* var = choose_indexed_var(GlobalIndex, GlobalList, access, cg_context, type, qfer, mt, invalid_vars);
 	ERROR_GUARD(NULL);
 	if (var == 0) {
 		if (CGOptions::expand_struct()) {
@@ -697,7 +779,7 @@ VariableSelector::SelectGlobal(Effect::Access access, const CGContext &cg_contex
 void
 VariableSelector::find_all_non_bitfield_visible_vars(const Block *b, vector<Variable*> &vars)
 {
-	vector<Variable *>::iterator i;
+	VariableList::const_iterator i;
 	for (i = GlobalList.begin(); i != GlobalList.end(); ++i) {
 		if (!((*i)->isBitfield_))
 			vars.push_back(*i);
@@ -712,28 +794,6 @@ VariableSelector::find_all_non_bitfield_visible_vars(const Block *b, vector<Vari
 	}
 }
 
-void
-VariableSelector::find_all_non_array_visible_vars(const Block *b, vector<Variable*> &vars)
-{
-	size_t i;
-	for (i = 0; i < GlobalList.size(); i++) {
-		if (!(GlobalList[i]->isArray))
-			vars.push_back(GlobalList[i]);
-	}	
-	if (b) {
-		for (i=0; i<b->func->param.size(); i++) {
-			vars.push_back(b->func->param[i]);
-		}
-		while (b) {
-			for (i = 0; i < b->local_vars.size(); i++) {
-				if (!((b->local_vars[i])->isArray))
-					vars.push_back(b->local_vars[i]);
-			}
-			b = b->parent;
-		}
-	}
-}
-
 void
 VariableSelector::get_all_array_vars(vector<const Variable*> &array_vars)
 {
@@ -1036,7 +1096,7 @@ VariableSelector::SelectParentLocal(Effect::Access access,
 		ERROR_GUARD(NULL);
 	}
 
-	Variable* var = choose_var(block->local_vars, access, cg_context, t, qfer, mt, invalid_vars);
+	Variable* var = choose_indexed_var(block->local_var_index, block->local_vars, access, cg_context, t, qfer, mt, invalid_vars);
 	ERROR_GUARD(NULL);
 	if (var == 0) {
 #if 0
@@ -1169,28 +1229,31 @@ VariableSelector::SelectLoopCtrlVar(const CGContext &cg_context, const vector<co
 {
 	// Note that many of the functions that select `var' can return null, if
 	const Type* type = get_int_type();   
-	vector<Variable*> vars;
-	find_all_non_array_visible_vars(cg_context.get_current_block(), vars);
-	// remove union variables that have both integer field(s) and pointer field(s)  
-	// because incrementing the integer field causes the pointer to be invalid, and the current 
-	// points-to analysis simply assumes loop stepping has no pointer effect
-	size_t len = vars.size();
-	for (size_t i=0; i<len; i++) { 
-		if (vars[i]->type && 
-			(!vars[i]->type->has_int_field() ||		// remove variables isn't (or doesn't contain) integers 
-			(vars[i]->type->eType == eUnion && 
-			vars[i]->type->contain_pointer_field()))) {
-			vars.erase(vars.begin() + i);
-			i--;
-			len--;
-		}
-	}
 	Variable* var;
 	if (cg_context.get_atomic_context()) {
-          var = choose_var(cg_context.get_current_block()->local_vars, Effect::WRITE, cg_context, type, 0, eConvert, invalid_vars, true);
+          Block *b = cg_context.get_current_block();
+          var = choose_indexed_var(b->local_var_index, b->local_vars, Effect::WRITE, cg_context, type, 0, eConvert, invalid_vars, true);
 	}
 	else {
-          var = choose_var(vars, Effect::WRITE, cg_context, type, 0, eConvert, invalid_vars, true);
+          // the integers among the globals, parameters and locals that
+          // are not arrays
+          vector<const VariableIndex *> scopes;
+          const Block *b = cg_context.get_current_block();
+          GlobalIndex.sync(GlobalList);
+          scopes.push_back(&GlobalIndex);
+          if (b) {
+            b->func->param_index.sync(b->func->param);
+            scopes.push_back(&b->func->param_index);
+            for (; b; b = b->parent) {
+              b->local_var_index.sync(b->local_vars);
+              scopes.push_back(&b->local_var_index);
+            }
+          }
+          vector<Variable*> pointer_vars, volatile_vars, candidates;
+          VariableIndex::collect_pointers(scopes, pointer_vars, is_loop_ctrl_candidate);
+          VariableIndex::collect_volatiles(scopes, volatile_vars, is_loop_ctrl_candidate);
+          VariableIndex::collect(scopes, type->get_indirect_level(), candidates, is_loop_ctrl_candidate);
+          var = choose_expanded_var(pointer_vars, volatile_vars, candidates, Effect::WRITE, cg_context, type, 0, eConvert, invalid_vars, true);
         }
 	ERROR_GUARD(NULL);
 	if (var == NULL) {
@@ -1207,6 +1270,23 @@ VariableSelector::SelectLoopCtrlVar(const CGContext &cg_context, const vector<co
 	return var;
 }
 
+/*
+ * Removes arrays, and union variables that have both integer field(s) and
+ * pointer field(s) because incrementing the integer field causes the pointer
+ * to be invalid, and the current points-to analysis simply assumes loop
+ * stepping has no pointer effect
+ */
+bool
+VariableSelector::is_loop_ctrl_candidate(const Variable *var)
+{
+	if (var->isArray)
+		return false;
+	return !(var->type && 
+		(!var->type->has_int_field() ||		// remove variables isn't (or doesn't contain) integers 
+		(var->type->eType == eUnion && 
+		var->type->contain_pointer_field())));
+}
+
 // --------------------------------------------------------------
 // Select or Create a new variable visible to this scope (new var may be
 // global, or local to one of the function's blocks)
@@ -1276,20 +1356,39 @@ Variable *
 VariableSelector::select_deref_pointer(Effect::Access access, const CGContext &cg_context, const Type* type, const CVQualifiers* qfer, const vector<const Variable*>& invalid_vars)
 { 
 	assert(qfer && qfer->sanity_check(type));
-	vector<Variable*> vars;
-	// add globals
-	vars.insert(vars.end(), GlobalNonvolatilesList.begin(), GlobalNonvolatilesList.end()); 
-	// add parent locals
 	const Block* b = cg_context.get_current_block();
-	while (b) {
-		vars.insert(vars.end(), b->local_vars.begin(), b->local_vars.end());
-		b = b->parent;
-	}
-	// add function parameters
 	const Function* f = cg_context.get_current_func();
-	vars.insert(vars.end(), f->param.begin(), f->param.end()); 
-
-	Variable* var = choose_var(vars, access, cg_context, type, qfer, eDereference, invalid_vars);
+	Variable* var = 0;
+	if (type->eType == eSimple) {
+		// the scopes are indexed, see choose_indexed_var. Only pointers
+		// can be dereferenced.
+		vector<const VariableIndex *> scopes;
+		GlobalNonvolatilesIndex.sync(GlobalNonvolatilesList);
+		scopes.push_back(&GlobalNonvolatilesIndex);
+		for (; b; b = b->parent) {
+			b->local_var_index.sync(b->local_vars);
+			scopes.push_back(&b->local_var_index);
+		}
+		f->param_index.sync(f->param);
+		scopes.push_back(&f->param_index);
+		vector<Variable*> pointer_vars, volatile_vars;
+		VariableIndex::collect_pointers(scopes, pointer_vars);
+		VariableIndex::collect_volatiles(scopes, volatile_vars);
+		var = choose_expanded_var(pointer_vars, volatile_vars, pointer_vars, access, cg_context, type, qfer, eDereference, invalid_vars, false);
+	}
+	else {
+		vector<Variable*> vars;
+		// add globals
+		vars.insert(vars.end(), GlobalNonvolatilesList.begin(), GlobalNonvolatilesList.end()); 
+		// add parent locals
+		while (b) {
+			vars.insert(vars.end(), b->local_vars.begin(), b->local_vars.end());
+			b = b->parent;
+		}
+		// add function parameters
+		vars.insert(vars.end(), f->param.begin(), f->param.end()); 
+		var = choose_var(vars, access, cg_context, type, qfer, eDereference, invalid_vars);
+	}
 	ERROR_GUARD(NULL);
 	if (var == 0) {
 		Type* ptr_type = Type::find_pointer_type(type, true);
@@ -1567,6 +1666,17 @@ const Variable*
 VariableSelector::find_var_by_name(string name)
 {
 	size_t i;
+	// variables are only ever appended to AllVars
+	for (i=VarsByNameCount; i<AllVars.size(); i++) {
+		VarsByName.insert(make_pair(AllVars[i]->name, AllVars[i]));
+	}
+	VarsByNameCount = AllVars.size();
+	unordered_map<string, const Variable*>::const_iterator iter = VarsByName.find(name);
+	// the names of some variables are changed after they are created
+	if (iter != VarsByName.end() && iter->second->name == name) {
+		return iter->second;
+	}
+	// fields and array elements are not in the map
 	for (i=0; i<AllVars.size(); i++) {
 		const Variable* v = AllVars[i]->match_var_name(name);
 		if (v) {
@@ -1589,6 +1699,12 @@ VariableSelector::doFinalization(void)
 	AllVars.clear();
 	GlobalList.clear();
 	GlobalNonvolatilesList.clear();
+	GlobalIndex.clear();
+	GlobalNonvolatilesIndex.clear();
+	VarsByName.clear();
+	VarsByNameCount = 0;
+	var_created = false;
+	tmp_count = 0;
 }
 
 // --------------------------------------------------------------
@@ -1596,7 +1712,7 @@ void
 OutputGlobalVariables(std::ostream &out)
 {
 	output_comment_line(out, "--- GLOBAL VARIABLES ---");
-	vector<Variable *>& vars = *(VariableSelector::GetGlobalVariables());
+	const vector<Variable *>& vars = *(VariableSelector::GetGlobalVariables());
 	bool access_once = CGOptions::access_once();
 
 	CGOptions::access_once(false);
@@ -34,9 +34,11 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
 using namespace std;
 #include "Variable.h"
 #include "Type.h"
+#include "VariableIndex.h"
 
 class CGContext;
 class Expression;
@@ -72,7 +74,7 @@ public:
 	static Variable* choose_ok_var(const vector<Variable *> &vars);
 	static const Variable* choose_ok_var(const vector<const Variable *> &vars);
 	static const Variable* choose_visible_read_var(const Block* b, vector<const Variable*> written_vars, const Type* type, const vector<const Fact*>& facts);
-	static Variable* choose_var(vector<Variable *> vars, Effect::Access access,
+	static Variable* choose_var(const vector<Variable *> &vars, Effect::Access access,
 		   const CGContext &cg_context, const Type* type, const CVQualifiers* qfer,
 		   eMatchType mt, const vector<const Variable*>& invalid_vars, bool no_bitfield = false, bool no_expand_struct = false);
 	static Variable *select_deref_pointer(Effect::Access access, const CGContext &cg_context, const Type* type, 
@@ -94,12 +96,12 @@ public:
 
 	static void GenerateParameterVariable(Function &curFunc);
 	static Variable* GenerateParameterVariable(const Type *type, const CVQualifiers *qfer);
-	static std::vector<Variable *>* GetGlobalVariables(void) {return &GlobalList;}
+	static VariableList* GetGlobalVariables(void) {return &GlobalList;}
 	static std::vector<Variable *>* GetAllVariables(void) {return &AllVars;}
 	static void doFinalization(void); 
 	static void expand_struct_union_vars(vector<const Variable *>& vars, const Type* type);
 
-	static ProbabilityTable<unsigned int, eVariableScope> * scopeTable_;
+	static thread_local ProbabilityTable<unsigned int, eVariableScope> * scopeTable_;
 	static void InitScopeTable();
 
 	static vector<Variable*> find_all_visible_vars(const Block* b); 
@@ -140,30 +142,47 @@ private:
 
 	static void find_all_non_bitfield_visible_vars(const Block* b, vector<Variable*> &vars);
 
-	static void find_all_non_array_visible_vars(const Block* b, vector<Variable*> &vars);
-
 	static void expand_struct_union_vars(vector<Variable *>& vars, const Type* type);
 
+	static Variable* choose_indexed_var(VariableIndex &index, const VariableList &vars, Effect::Access access,
+		   const CGContext &cg_context, const Type* type, const CVQualifiers* qfer,
+		   eMatchType mt, const vector<const Variable*>& invalid_vars, bool no_bitfield = false, bool no_expand_struct = false);
+
+	static Variable* choose_expanded_var(const vector<Variable *> &pointer_vars, const vector<Variable *> &volatile_vars,
+		   const vector<Variable *> &candidates,
+		   Effect::Access access, const CGContext &cg_context, const Type* type, const CVQualifiers* qfer,
+		   eMatchType mt, const vector<const Variable*>& invalid_vars, bool no_bitfield);
+
 	static bool has_dereferenceable_var(const vector<Variable *>& vars, const Type* type, const CGContext& cg_context);
 
 	static bool has_eligible_volatile_var(const vector<Variable *>& vars, const Type* type, const CVQualifiers* qfer, Effect::Access access, const CGContext& cg_context);
 
+	static bool is_loop_ctrl_candidate(const Variable *var);
+
 	static bool is_eligible_var(const Variable* var, int deref_level, Effect::Access access, const CGContext& cg_context);
 	
 	static Variable * create_and_initialize(Effect::Access access, const CGContext &cg_context, const Type* t, 
 					const CVQualifiers* qfer, Block *blk, std::string name);
 
 	// all variables generated
-	static vector<Variable*> AllVars;
+	static thread_local vector<Variable*> AllVars;
 
 	// All globals, including volatiles.
-	static vector<Variable*> GlobalList;
+	static thread_local VariableList GlobalList;
 
 	// All the non-volatile globals.
-	static vector<Variable*> GlobalNonvolatilesList;
+	static thread_local VariableList GlobalNonvolatilesList;
+
+	// Indexes of GlobalList and GlobalNonvolatilesList for choose_var().
+	static thread_local VariableIndex GlobalIndex;
+	static thread_local VariableIndex GlobalNonvolatilesIndex;
+
+	// AllVars by name, filled in by find_var_by_name().
+	static thread_local unordered_map<string, const Variable*> VarsByName;
+	static thread_local size_t VarsByNameCount;
 
 	// flag that indicates whether a new variable has been created 
-	static bool var_created;
+	static thread_local bool var_created;
 };
 
 void OutputGlobalVariables(std::ostream &);
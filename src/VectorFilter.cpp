@@ -68,16 +68,74 @@ VectorFilter::filter(int v) const
 	if (!this->valid_filter())
 		return false;
  
-	v = lookup(v); 
-	bool re = std::find(vs_.begin(), vs_.end(), static_cast<unsigned int>(v)) != vs_.end();
+	if (ptable) {
+		if (excluded_entries_.empty())
+			build_excluded_entries();
+		return excluded_entries_[ptable->rnd_num_to_index(v)];
+	}
+	return excluded(static_cast<unsigned int>(v));
+}
+
+bool
+VectorFilter::excluded(unsigned int key) const
+{
+	bool re = std::find(vs_.begin(), vs_.end(), key) != vs_.end();
 	return (flag_ == FILTER_OUT) ? re : !re;
 }
 
+void
+VectorFilter::build_excluded_entries(void) const
+{
+	excluded_entries_.resize(ptable->size());
+	for (size_t i = 0; i < ptable->size(); ++i)
+		excluded_entries_[i] = excluded(static_cast<unsigned int>(ptable->key_at(i)));
+}
+
+bool
+VectorFilter::accepted_ranges(unsigned int n, FilterRanges &ranges) const
+{
+	if (!this->valid_filter()) {
+		add_range(ranges, 0, n);
+		return true;
+	}
+
+	if (ptable) {
+		// Each key of the table covers a range of numbers.
+		if (excluded_entries_.empty())
+			build_excluded_entries();
+		unsigned int first = 0;
+		for (size_t i = 0; i < ptable->size() && first < n; ++i) {
+			unsigned int last = std::min(static_cast<unsigned int>(ptable->end_at(i)), n);
+			if (!excluded_entries_[i])
+				add_range(ranges, first, last);
+			first = last;
+		}
+		return true;
+	}
+
+	vector<unsigned int> sorted(vs_);
+	std::sort(sorted.begin(), sorted.end());
+	unsigned int first = 0;
+	for (size_t i = 0; i < sorted.size() && sorted[i] < n; ++i) {
+		if (i > 0 && sorted[i] == sorted[i - 1])
+			continue;
+		if (flag_ == FILTER_OUT)
+			add_range(ranges, first, sorted[i]);
+		else
+			add_range(ranges, sorted[i], sorted[i] + 1);
+		first = sorted[i] + 1;
+	}
+	if (flag_ == FILTER_OUT)
+		add_range(ranges, first, n);
+	return true;
+}
+
 VectorFilter&
 VectorFilter::add(unsigned int item)
 { 
 	if (std::find(vs_.begin(), vs_.end(), item) == vs_.end()) {
 		vs_.push_back(item); 
+		excluded_entries_.clear();
 	}
 	return *this;
 }
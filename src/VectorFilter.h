@@ -57,12 +57,23 @@ public:
 	virtual ~VectorFilter(void);
 
 	virtual bool filter(int v) const;
+
+	virtual bool accepted_ranges(unsigned int n, FilterRanges &ranges) const;
 private:
+	bool excluded(unsigned int key) const;
+
+	void build_excluded_entries(void) const;
+
 	std::vector<unsigned int> vs_;
 
 	DistributionTable *ptable;
 
 	int flag_;
+
+	// With a table, whether each of its entries is filtered out. Built on the
+	// first use after an item is added, so that a value is checked without
+	// searching vs_. The table must not change while it is being filtered.
+	mutable std::vector<bool> excluded_entries_;
 };
 
 #endif // VECTOR_FILTER_H
@@ -108,6 +108,65 @@ bool create_dir(const char *dir)
 	return true;
 }
 
+//////////// platform specific peak memory /////////////////
+#ifndef WIN32
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#else
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+unsigned long platform_peak_rss_kb()
+{
+#ifndef WIN32
+	// Linux has the high water mark that platform_reset_peak_rss() resets;
+	// elsewhere there is only the peak over the life of the process.
+	FILE *f = fopen("/proc/self/status", "r");
+	if (f) {
+		char line[256];
+		unsigned long kb = 0;
+		while (fgets(line, sizeof(line), f)) {
+			if (strncmp(line, "VmHWM:", 6) == 0) {
+				kb = strtoul(line + 6, NULL, 10);
+				break;
+			}
+		}
+		fclose(f);
+		if (kb)
+			return kb;
+	}
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+#else
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize / 1024;
+#endif
+}
+
+bool platform_reset_peak_rss()
+{
+#ifndef WIN32
+	FILE *f = fopen("/proc/self/clear_refs", "w");
+	if (!f)
+		return false;
+	bool ok = fputs("5", f) >= 0;
+	return (fclose(f) == 0) && ok;
+#else
+	return false;
+#endif
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 // Local Variables:
@@ -36,6 +36,13 @@ unsigned long platform_gen_seed();
 
 bool create_dir(const char* dir);
 
+// Most memory the process has had resident so far, in KB, or 0 if unknown.
+unsigned long platform_peak_rss_kb();
+
+// Starts the count of platform_peak_rss_kb() again from the memory resident
+// now, where the system allows it. Returns false if it does not.
+bool platform_reset_peak_rss();
+
 ///////////////////////////////////////////////////////////////////////////////
 
 #endif // PLATFORM_H
@@ -43,7 +43,7 @@
 using namespace std; 
 ///////////////////////////////////////////////////////////////////////////////
 
-static int gensym_count = 0;
+static thread_local int gensym_count = 0;
 
 void
 reset_gensym()
@@ -0,0 +1,515 @@
+// Ranks reduced kernels for triage like gonzalez.c, without computing the
+// distance between every pair of them.
+//
+//   g++ -O2 -std=c++11 -pthread -o triage triage.cpp
+//   triage [-j jobs] [-t threshold] rankfile [kernel...]
+//
+// The kernels are named on the command line, or one per line on stdin. The
+// rank file gets the index of each kernel, one per line, in furthest-point
+// order, as gonzalez.c writes it: the first n lines are the representatives
+// of n clusters.
+//
+// Kernels are compared as token sequences, where the numbers of generated
+// names (l_12, func_3) and the values of literals are dropped. The distance
+// between two kernels is their edit distance divided by the longer length, as
+// in tamer.pl. It is only computed exactly for the pairs of kernels that
+// locality sensitive hashing of MinHash signatures over token shingles finds
+// similar, and then only up to the threshold (default 0.35). Any other
+// distance is estimated from the signatures, and is at least the threshold,
+// as only near duplicates need telling apart.
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static const int SHINGLE = 4;
+static const int BANDS = 32;
+static const int ROWS = 4;
+static const int HASHES = BANDS * ROWS;
+
+struct kernel_t {
+  vector<uint32_t> tokens;
+  uint32_t sig[HASHES];
+};
+
+static uint64_t mix (uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+static uint32_t token_id (const string &s)
+{
+  uint32_t h = 2166136261u;
+  for (size_t i=0; i<s.size(); i++) {
+    h ^= (unsigned char)s[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static bool is_ident (char c)
+{
+  return isalnum ((unsigned char)c) || c == '_';
+}
+
+// l_12 -> l_#, and the OpenCL address spaces with or without underscores
+static string normalize_ident (const string &s)
+{
+  size_t us = s.rfind ('_');
+  if (us != string::npos && us > 0 && us + 1 < s.size() &&
+      strspn (s.c_str() + us + 1, "0123456789") == s.size() - us - 1)
+    return s.substr (0, us + 1) + "#";
+  if (s == "__global" || s == "__local" || s == "__constant" ||
+      s == "__private" || s == "__kernel")
+    return s.substr (2);
+  return s;
+}
+
+static const char *const puncts[] = {
+  "<<=", ">>=", "...", "->", "++", "--", "<<", ">>", "<=", ">=", "==", "!=",
+  "&&", "||", "+=", "-=", "*=", "/=", "%=", "&=", "^=", "|=", "##", NULL
+};
+
+static void tokenize (const string &text, vector<uint32_t> &tokens)
+{
+  size_t i = 0, n = text.size();
+  bool line_start = true;
+  while (i < n) {
+    char c = text[i];
+    if (c == '\n') {
+      line_start = true;
+      i++;
+      continue;
+    }
+    if (isspace ((unsigned char)c)) {
+      i++;
+      continue;
+    }
+    // preprocessor lines, with their continuations
+    if (c == '#' && line_start) {
+      while (i < n && !(text[i] == '\n' && text[i-1] != '\\'))
+	i++;
+      continue;
+    }
+    line_start = false;
+    if (c == '/' && i + 1 < n && text[i+1] == '/') {
+      while (i < n && text[i] != '\n')
+	i++;
+      continue;
+    }
+    if (c == '/' && i + 1 < n && text[i+1] == '*') {
+      size_t end = text.find ("*/", i + 2);
+      i = (end == string::npos) ? n : end + 2;
+      continue;
+    }
+    if (isalpha ((unsigned char)c) || c == '_') {
+      size_t start = i;
+      while (i < n && is_ident (text[i]))
+	i++;
+      tokens.push_back (token_id (normalize_ident (text.substr (start, i - start))));
+      continue;
+    }
+    // numbers keep only their suffix: 42UL -> Nul
+    if (isdigit ((unsigned char)c) ||
+	(c == '.' && i + 1 < n && isdigit ((unsigned char)text[i+1]))) {
+      bool hex = c == '0' && i + 1 < n && (text[i+1] == 'x' || text[i+1] == 'X');
+      if (hex)
+	i += 2;
+      while (i < n && (is_ident (text[i]) || text[i] == '.' ||
+		       ((text[i] == '+' || text[i] == '-') &&
+			strchr (hex ? "pP" : "eE", text[i-1]))))
+	i++;
+      string suffix = "N";
+      size_t j = i;
+      while (j > 0 && strchr ("uUlLfF", text[j-1]) &&
+	     !(hex && strchr ("fF", text[j-1])))
+	j--;
+      for (; j < i; j++)
+	suffix += (char)tolower ((unsigned char)text[j]);
+      tokens.push_back (token_id (suffix));
+      continue;
+    }
+    if (c == '"' || c == '\'') {
+      i++;
+      while (i < n && text[i] != c) {
+	if (text[i] == '\\')
+	  i++;
+	i++;
+      }
+      i++;
+      tokens.push_back (token_id (string (2, c)));
+      continue;
+    }
+    int k;
+    for (k=0; puncts[k]; k++) {
+      size_t len = strlen (puncts[k]);
+      if (text.compare (i, len, puncts[k]) == 0)
+	break;
+    }
+    size_t len = puncts[k] ? strlen (puncts[k]) : 1;
+    tokens.push_back (token_id (text.substr (i, len)));
+    i += len;
+  }
+}
+
+static void minhash (kernel_t &k)
+{
+  static uint64_t seeds[HASHES];
+  static std::once_flag seeded;
+  std::call_once (seeded, [] () {
+    for (int h=0; h<HASHES; h++)
+      seeds[h] = mix (h + 1);
+  });
+
+  for (int h=0; h<HASHES; h++)
+    k.sig[h] = UINT32_MAX;
+  const vector<uint32_t> &t = k.tokens;
+  size_t shingles = t.size() < SHINGLE ? (t.empty() ? 0 : 1) :
+    t.size() - SHINGLE + 1;
+  for (size_t i=0; i<shingles; i++) {
+    uint64_t s = 0;
+    for (size_t j=i; j<i+SHINGLE && j<t.size(); j++)
+      s = mix (s ^ t[j]);
+    for (int h=0; h<HASHES; h++) {
+      uint32_t v = (uint32_t)mix (s ^ seeds[h]);
+      if (v < k.sig[h])
+	k.sig[h] = v;
+    }
+  }
+}
+
+// The edit distance between a and b if it is at most k, or else k+1. Only the
+// cells within k of the diagonal are computed. The substitutions and deletions
+// of a row don't depend on each other, so that part vectorizes; the
+// insertions are then carried along the row.
+static int banded_distance (const vector<uint32_t> &a, const vector<uint32_t> &b,
+			    int k, vector<int> &prev, vector<int> &cur)
+{
+  int n1 = a.size(), n2 = b.size();
+  const int inf = k + 1;
+  if (abs (n1 - n2) > k)
+    return inf;
+  prev.assign (n2 + 1, inf);
+  cur.assign (n2 + 1, inf);
+  for (int j=0; j<=n2 && j<=k; j++)
+    prev[j] = j;
+  for (int i=1; i<=n1; i++) {
+    int lo = max (1, i - k), hi = min (n2, i + k);
+    const uint32_t c = a[i-1];
+    cur[lo-1] = (lo == 1 && i <= k) ? i : inf;
+    for (int j=lo; j<=hi; j++) {
+      int sub = prev[j-1] + (b[j-1] != c);
+      int del = prev[j] + 1;
+      cur[j] = min (min (sub, del), inf);
+    }
+    int row_min = cur[lo-1];
+    for (int j=lo; j<=hi; j++) {
+      cur[j] = min (cur[j], cur[j-1] + 1);
+      row_min = min (row_min, cur[j]);
+    }
+    if (hi < n2)
+      cur[hi+1] = inf;
+    if (row_min > k)
+      return inf;
+    swap (prev, cur);
+  }
+  return min (prev[n2], inf);
+}
+
+// Runs f(begin, end) over [0, n) on all the threads, and waits for it.
+class pool_t {
+public:
+  explicit pool_t (int jobs) : gen_(0), pending_(0), stop_(false)
+  {
+    for (int i=1; i<jobs; i++)
+      threads_.push_back (thread (&pool_t::work, this));
+  }
+
+  ~pool_t ()
+  {
+    {
+      lock_guard<mutex> lock (mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all ();
+    for (size_t i=0; i<threads_.size(); i++)
+      threads_[i].join ();
+  }
+
+  void run (size_t n, const function<void (size_t, size_t)> &f)
+  {
+    const size_t chunk = 1024;
+    if (threads_.empty() || n <= chunk) {
+      f (0, n);
+      return;
+    }
+    {
+      lock_guard<mutex> lock (mutex_);
+      f_ = &f;
+      n_ = n;
+      next_ = 0;
+      pending_ = threads_.size();
+      gen_++;
+    }
+    wake_.notify_all ();
+    slice (f, n);
+    unique_lock<mutex> lock (mutex_);
+    while (pending_ > 0)
+      done_.wait (lock);
+  }
+
+private:
+  void slice (const function<void (size_t, size_t)> &f, size_t n)
+  {
+    const size_t chunk = 1024;
+    for (size_t begin = next_.fetch_add (chunk); begin < n;
+	 begin = next_.fetch_add (chunk))
+      f (begin, min (n, begin + chunk));
+  }
+
+  void work ()
+  {
+    unsigned long seen = 0;
+    while (1) {
+      const function<void (size_t, size_t)> *f;
+      size_t n;
+      {
+	unique_lock<mutex> lock (mutex_);
+	while (!stop_ && gen_ == seen)
+	  wake_.wait (lock);
+	if (stop_)
+	  return;
+	seen = gen_;
+	f = f_;
+	n = n_;
+      }
+      slice (*f, n);
+      lock_guard<mutex> lock (mutex_);
+      if (--pending_ == 0)
+	done_.notify_one ();
+    }
+  }
+
+  vector<thread> threads_;
+  mutex mutex_;
+  condition_variable wake_, done_;
+  unsigned long gen_;
+  size_t pending_;
+  bool stop_;
+  const function<void (size_t, size_t)> *f_;
+  size_t n_;
+  atomic<size_t> next_;
+};
+
+static void usage (void)
+{
+  printf ("usage: triage [-j jobs] [-t threshold] rankfile [kernel...]\n");
+  exit (-1);
+}
+
+int main (int argc, char *argv[])
+{
+  int jobs = thread::hardware_concurrency ();
+  double threshold = 0.35;
+  int index = 1;
+  for (; index < argc && argv[index][0] == '-' && argv[index][1]; index++) {
+    if (!strcmp (argv[index], "-j") && index + 1 < argc)
+      jobs = atoi (argv[++index]);
+    else if (!strcmp (argv[index], "-t") && index + 1 < argc)
+      threshold = atof (argv[++index]);
+    else
+      usage ();
+  }
+  if (index >= argc || jobs < 1 || threshold <= 0 || threshold > 1)
+    usage ();
+  const char *outfn = argv[index++];
+
+  vector<string> names;
+  for (; index < argc; index++)
+    names.push_back (argv[index]);
+  if (names.empty()) {
+    string line;
+    while (getline (cin, line))
+      if (!line.empty())
+	names.push_back (line);
+  }
+  const int numvecs = names.size();
+  printf ("numvecs = %d\n", numvecs);
+  if (numvecs == 0)
+    usage ();
+
+  pool_t pool (jobs);
+  vector<kernel_t> kernels (numvecs);
+  atomic<bool> failed (false);
+  pool.run (numvecs, [&] (size_t begin, size_t end) {
+    for (size_t i=begin; i<end; i++) {
+      ifstream in (names[i].c_str());
+      if (!in) {
+	printf ("oops, could not open '%s'\n", names[i].c_str());
+	failed = true;
+	continue;
+      }
+      stringstream text;
+      text << in.rdbuf ();
+      tokenize (text.str (), kernels[i].tokens);
+      minhash (kernels[i]);
+    }
+  });
+  if (failed)
+    exit (-1);
+
+  // Identical kernels are at distance 0, so only the first of each is
+  // ranked by distance; the others come last, in order.
+  vector<int> uniq;
+  vector<bool> is_dup (numvecs, false);
+  {
+    unordered_map<uint64_t, vector<int> > by_hash;
+    for (int i=0; i<numvecs; i++) {
+      uint64_t h = kernels[i].tokens.size();
+      for (size_t j=0; j<kernels[i].tokens.size(); j++)
+	h = mix (h ^ kernels[i].tokens[j]);
+      vector<int> &same = by_hash[h];
+      for (size_t j=0; j<same.size() && !is_dup[i]; j++)
+	is_dup[i] = kernels[same[j]].tokens == kernels[i].tokens;
+      if (!is_dup[i]) {
+	same.push_back (i);
+	uniq.push_back (i);
+      }
+    }
+  }
+  const int nuniq = uniq.size();
+  printf ("unique = %d\n", nuniq);
+
+  // candidate pairs: the kernels that share the hash of a band of their
+  // signatures
+  vector<pair<int,int> > pairs;
+  for (int b=0; b<BANDS; b++) {
+    unordered_map<uint64_t, vector<int> > buckets;
+    for (int u=0; u<nuniq; u++) {
+      uint64_t h = b;
+      for (int r=0; r<ROWS; r++)
+	h = mix (h ^ kernels[uniq[u]].sig[b * ROWS + r]);
+      buckets[h].push_back (u);
+    }
+    for (unordered_map<uint64_t, vector<int> >::const_iterator it = buckets.begin();
+	 it != buckets.end(); ++it) {
+      const vector<int> &us = it->second;
+      for (size_t x=0; x<us.size(); x++)
+	for (size_t y=x+1; y<us.size(); y++)
+	  pairs.push_back (make_pair (us[x], us[y]));
+    }
+  }
+  sort (pairs.begin(), pairs.end());
+  pairs.erase (unique (pairs.begin(), pairs.end()), pairs.end());
+  printf ("candidate pairs = %d\n", (int)pairs.size());
+
+  // exact distances of the candidates, -1 beyond the threshold
+  vector<float> exact (pairs.size());
+  pool.run (pairs.size(), [&] (size_t begin, size_t end) {
+    vector<int> prev, cur;
+    for (size_t p=begin; p<end; p++) {
+      const vector<uint32_t> &a = kernels[uniq[pairs[p].first]].tokens;
+      const vector<uint32_t> &b = kernels[uniq[pairs[p].second]].tokens;
+      const size_t len = max (a.size(), b.size());
+      const int k = (int)(threshold * len);
+      // near duplicates are cheap with a narrow band, so widen it from there
+      int band = min (k, 64), d;
+      while ((d = banded_distance (a, b, band, prev, cur)) > band && band < k)
+	band = min (k, band * 2);
+      exact[p] = (d > k) ? -1 : (float)d / len;
+    }
+  });
+  vector<vector<pair<int,float> > > near (nuniq);
+  for (size_t p=0; p<pairs.size(); p++) {
+    if (exact[p] < 0)
+      continue;
+    near[pairs[p].first].push_back (make_pair (pairs[p].second, exact[p]));
+    near[pairs[p].second].push_back (make_pair (pairs[p].first, exact[p]));
+  }
+
+  // furthest-point ranking, keeping the distance of each kernel to the
+  // nearest ranked one
+  vector<float> min_dist (nuniq, HUGE_VALF);
+  vector<bool> ranked (nuniq, false);
+  vector<int> ranking;
+  auto add_point = [&] (int i) {
+    const uint32_t *si = kernels[uniq[i]].sig;
+    pool.run (nuniq, [&] (size_t begin, size_t end) {
+      for (size_t y=begin; y<end; y++) {
+	const uint32_t *sy = kernels[uniq[y]].sig;
+	int agree = 0;
+	for (int h=0; h<HASHES; h++)
+	  agree += si[h] == sy[h];
+	float d = max ((float)threshold, 1.0f - (float)agree / HASHES);
+	if (d < min_dist[y])
+	  min_dist[y] = d;
+      }
+    });
+    for (size_t j=0; j<near[i].size(); j++) {
+      int y = near[i][j].first;
+      min_dist[y] = min (min_dist[y], near[i][j].second);
+    }
+    min_dist[i] = 0;
+  };
+  auto furthest = [&] () {
+    int i = -1;
+    float max_dist = -HUGE_VALF;
+    for (int y=0; y<nuniq; y++) {
+      if (!ranked[y] && min_dist[y] > max_dist) {
+	max_dist = min_dist[y];
+	i = y;
+      }
+    }
+    return i;
+  };
+
+  // start with the kernel furthest from the first one
+  add_point (0);
+  int i = furthest ();
+  if (i == -1)
+    i = 0;
+  fill (min_dist.begin(), min_dist.end(), HUGE_VALF);
+  while (i != -1) {
+    ranked[i] = true;
+    ranking.push_back (uniq[i]);
+    add_point (i);
+    i = furthest ();
+  }
+  for (int x=0; x<numvecs; x++)
+    if (is_dup[x])
+      ranking.push_back (x);
+  assert ((int)ranking.size() == numvecs);
+
+  printf ("output file: '%s'\n", outfn);
+  FILE *outf = fopen (outfn, "w+");
+  if (!outf) {
+    printf ("oops, could not open '%s'\n", outfn);
+    exit (-1);
+  }
+  for (size_t x=0; x<ranking.size(); x++)
+    fprintf (outf, "%d\n", ranking[x]);
+  fclose (outf);
+  return 0;
+}